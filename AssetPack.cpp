@@ -0,0 +1,316 @@
+#include "AssetPack.hpp"
+
+#include <stb/stb_image.h> // For decoding textures while baking
+#include <iostream>
+#include <fstream> // For std::ifstream
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h> // For CreateFileMapping and MapViewOfFile
+#else
+#include <fcntl.h> // For open
+#include <sys/mman.h> // For mmap
+#include <sys/stat.h> // For fstat
+#include <unistd.h> // For close
+#endif
+
+
+
+// Packs start with this
+static const char packMagic[4] = { 'M', 'C', 'A', 'P' };
+// Magic, version, hash (2 words), layer size, layer count, level count,
+// block count, block table offset and pixel offset
+static const size_t headerBytes = 40;
+// Each block table entry: id, flags, 6 face textures, emission and name length, then the name
+static const size_t blockEntryBytes = 10;
+// Pixels start on a 16 byte boundary
+static const size_t pixelAlignment = 16;
+
+
+
+// Little endian, whatever the machine's byte order is
+static void PutUint32(std::vector<GLubyte> &bytes, size_t offset, uint32_t value)
+{
+    for(GLuint i = 0; i < 4; i++)
+        bytes[offset + i] = (GLubyte)(value >> (i * 8));
+}
+
+static uint32_t GetUint32(const GLubyte *bytes)
+{
+    return (uint32_t)bytes[0] | (uint32_t)bytes[1] << 8 | (uint32_t)bytes[2] << 16 | (uint32_t)bytes[3] << 24;
+}
+
+
+
+// How many bytes one mip level holds across all layers
+static size_t LevelBytes(GLuint level, GLuint layerCount)
+{
+    size_t size = AssetPack::LevelSize(level);
+    return size * size * 4 * layerCount;
+}
+
+
+
+AssetPack::~AssetPack()
+{
+    Close();
+}
+
+
+
+uint64_t AssetPack::HashDefinitions(const std::vector<GLubyte> &blocksFile)
+{
+    // 64 bit FNV-1a
+    uint64_t hash = 0xCBF29CE484222325ull;
+    for(GLubyte byte : blocksFile)
+    {
+        hash ^= byte;
+        hash *= 0x100000001B3ull;
+    }
+    return hash;
+}
+
+
+
+GLboolean AssetPack::Bake(const std::vector<GLubyte> &blocksFile, std::vector<GLubyte> &pack)
+{
+    json definitions = json::parse(blocksFile.begin(), blocksFile.end(), nullptr, false);
+    if(definitions.is_discarded())
+    {
+        std::cout << "blocks.json is not valid json, can't bake the asset pack" << std::endl;
+        return false;
+    }
+    BlockRegistry registry;
+    registry.LoadDefinitions(definitions);
+    const std::vector<std::string> &textureLayers = registry.GetTextureLayers();
+
+    GLuint levelCount = 1;
+    while((layerSize >> levelCount) > 0)
+        levelCount++;
+
+    // Block table: id, flags, face textures, emission and name for every defined block
+    pack.assign(headerBytes, 0);
+    GLuint blockCount = 0;
+    for(GLint id = 0; id < (GLint)BlockRegistry::maxBlockTypes; id++)
+    {
+        const std::string &name = registry.GetName(id);
+        if(name.empty())
+            continue;
+        const BlockProperties &properties = registry.Get(id);
+        pack.push_back(id);
+        pack.push_back(properties.flags);
+        pack.insert(pack.end(), properties.faceTexture, properties.faceTexture + 6);
+        pack.push_back(properties.emission);
+        pack.push_back(name.size());
+        pack.insert(pack.end(), name.begin(), name.end());
+        blockCount++;
+    }
+    pack.resize((pack.size() + pixelAlignment - 1) / pixelAlignment * pixelAlignment, 0);
+    size_t pixelOffset = pack.size();
+
+    // Level 0: decode every texture and scale it to fill its layer. Nearest
+    // sampling keeps the blocky pixel art look
+    size_t layerBytes = layerSize * layerSize * 4;
+    size_t totalPixelBytes = 0;
+    for(GLuint level = 0; level < levelCount; level++)
+        totalPixelBytes += LevelBytes(level, textureLayers.size());
+    pack.resize(pixelOffset + totalPixelBytes, 0);
+    for(GLuint layer = 0; layer < textureLayers.size(); layer++)
+    {
+        GLint width, height, channels;
+        // Loading as rgb_alpha so transparent pixels are transparent
+        unsigned char *image = stbi_load(textureLayers[layer].c_str(), &width, &height, &channels, STBI_rgb_alpha);
+        if(image == nullptr)
+        {
+            // Leave the layer transparent, like a texture that failed to load always was
+            std::cout << "Failed to load texture " << textureLayers[layer] << std::endl;
+            continue;
+        }
+        GLubyte *destination = pack.data() + pixelOffset + layer * layerBytes;
+        for(GLuint y = 0; y < layerSize; y++)
+        for(GLuint x = 0; x < layerSize; x++)
+        {
+            const unsigned char *source = image + ((y * height / layerSize) * width + x * width / layerSize) * 4;
+            std::copy(source, source + 4, destination + (y * layerSize + x) * 4);
+        }
+        stbi_image_free(image);
+    }
+
+    // The rest of the levels: average each 2x2 square of the level above
+    size_t levelOffset = pixelOffset;
+    for(GLuint level = 1; level < levelCount; level++)
+    {
+        GLuint parentSize = LevelSize(level - 1);
+        GLuint size = LevelSize(level);
+        const GLubyte *parent = pack.data() + levelOffset;
+        GLubyte *pixels = pack.data() + levelOffset + LevelBytes(level - 1, textureLayers.size());
+        for(GLuint layer = 0; layer < textureLayers.size(); layer++)
+        for(GLuint y = 0; y < size; y++)
+        for(GLuint x = 0; x < size; x++)
+        for(GLuint channel = 0; channel < 4; channel++)
+        {
+            const GLubyte *parentLayer = parent + layer * parentSize * parentSize * 4;
+            GLuint sum = parentLayer[((2 * y) * parentSize + 2 * x) * 4 + channel] + parentLayer[((2 * y) * parentSize + 2 * x + 1) * 4 + channel]
+                       + parentLayer[((2 * y + 1) * parentSize + 2 * x) * 4 + channel] + parentLayer[((2 * y + 1) * parentSize + 2 * x + 1) * 4 + channel];
+            pixels[((layer * size + y) * size + x) * 4 + channel] = (sum + 2) / 4;
+        }
+        levelOffset += LevelBytes(level - 1, textureLayers.size());
+    }
+
+    uint64_t hash = HashDefinitions(blocksFile);
+    std::copy(packMagic, packMagic + 4, pack.begin());
+    PutUint32(pack, 4, formatVersion);
+    PutUint32(pack, 8, (uint32_t)hash);
+    PutUint32(pack, 12, (uint32_t)(hash >> 32));
+    PutUint32(pack, 16, layerSize);
+    PutUint32(pack, 20, textureLayers.size());
+    PutUint32(pack, 24, levelCount);
+    PutUint32(pack, 28, blockCount);
+    PutUint32(pack, 32, headerBytes);
+    PutUint32(pack, 36, pixelOffset);
+    return true;
+}
+
+
+
+GLboolean AssetPack::Open(const std::string &path, uint64_t definitionsHash)
+{
+    Close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if(file == INVALID_HANDLE_VALUE)
+        return false;
+    LARGE_INTEGER fileSize;
+    HANDLE mapping = (GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0 ? CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr);
+    // The view keeps the file open, we don't need our handles once it exists
+    void *view = (mapping != nullptr ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr);
+    if(mapping != nullptr)
+        CloseHandle(mapping);
+    CloseHandle(file);
+    if(view == nullptr)
+        return false;
+    packSize = fileSize.QuadPart;
+#else
+    int file = open(path.c_str(), O_RDONLY);
+    if(file == -1)
+        return false;
+    struct stat fileStatus;
+    void *view = (fstat(file, &fileStatus) == 0 && fileStatus.st_size > 0 ? mmap(nullptr, fileStatus.st_size, PROT_READ, MAP_PRIVATE, file, 0) : MAP_FAILED);
+    // The mapping keeps the file open, we don't need our descriptor once it exists
+    close(file);
+    if(view == MAP_FAILED)
+        return false;
+    packSize = fileStatus.st_size;
+#endif
+
+    packData = (const GLubyte *)view;
+    mapped = true;
+    if(!ReadHeader(definitionsHash))
+    {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+
+
+GLboolean AssetPack::Open(std::vector<GLubyte> &&pack, uint64_t definitionsHash)
+{
+    Close();
+    packMemory = std::move(pack);
+    packData = packMemory.data();
+    packSize = packMemory.size();
+    if(!ReadHeader(definitionsHash))
+    {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+
+
+void AssetPack::LoadBlocks(BlockRegistry &registry) const
+{
+    const GLubyte *entry = packData + blockTableOffset;
+    for(GLuint i = 0; i < blockCount; i++)
+    {
+        BlockProperties properties;
+        properties.flags = entry[1];
+        std::copy(entry + 2, entry + 8, properties.faceTexture);
+        properties.emission = entry[8];
+        registry.AddBlockType(entry[0], std::string((const char *)entry + blockEntryBytes, entry[9]), properties);
+        entry += blockEntryBytes + entry[9];
+    }
+}
+
+
+
+const GLubyte *AssetPack::GetLevelPixels(GLuint level) const
+{
+    size_t offset = pixelOffset;
+    for(GLuint i = 0; i < level; i++)
+        offset += LevelBytes(i, layerCount);
+    return packData + offset;
+}
+
+
+
+GLboolean AssetPack::ReadHeader(uint64_t definitionsHash)
+{
+    if(packSize < headerBytes || std::string((const char *)packData, 4) != std::string(packMagic, 4) || GetUint32(packData + 4) != formatVersion)
+        return false;
+    uint64_t hash = GetUint32(packData + 8) | (uint64_t)GetUint32(packData + 12) << 32;
+    if(hash != definitionsHash || GetUint32(packData + 16) != layerSize)
+        return false;
+
+    layerCount = GetUint32(packData + 20);
+    levelCount = GetUint32(packData + 24);
+    blockCount = GetUint32(packData + 28);
+    blockTableOffset = GetUint32(packData + 32);
+    pixelOffset = GetUint32(packData + 36);
+    if(layerCount > BlockRegistry::maxTextureLayers || levelCount == 0 || (layerSize >> (levelCount - 1)) != 1)
+        return false;
+    if(blockTableOffset < headerBytes || blockTableOffset > pixelOffset || pixelOffset > packSize)
+        return false;
+
+    // Walk the block table to make sure it fits before the pixels
+    size_t offset = blockTableOffset;
+    for(GLuint i = 0; i < blockCount; i++)
+    {
+        if(offset + blockEntryBytes > pixelOffset || offset + blockEntryBytes + packData[offset + 9] > pixelOffset || packData[offset] >= BlockRegistry::maxBlockTypes)
+            return false;
+        // Every face has to point at a layer we have
+        for(GLuint face = 0; face < 6; face++)
+            if(packData[offset + 2 + face] >= layerCount)
+                return false;
+        offset += blockEntryBytes + packData[offset + 9];
+    }
+
+    size_t pixelBytes = 0;
+    for(GLuint level = 0; level < levelCount; level++)
+        pixelBytes += LevelBytes(level, layerCount);
+    return packSize - pixelOffset >= pixelBytes;
+}
+
+
+
+void AssetPack::Close()
+{
+    if(mapped)
+    {
+#ifdef _WIN32
+        UnmapViewOfFile(packData);
+#else
+        munmap((void *)packData, packSize);
+#endif
+    }
+    mapped = false;
+    packData = nullptr;
+    packSize = 0;
+    packMemory.clear();
+    packMemory.shrink_to_fit();
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "BlockRegistry.hpp"
+
+#include <glad/glad.h>
+#include <cstdint> // For uint64_t
+#include <string> // For std::string
+#include <vector> // For std::vector
+
+
+
+// blocks.json and every texture it points at, baked into one file: the block
+// property table plus the texture array's layers, already decoded to RGBA,
+// scaled to layerSize and mipmapped. Loading it is a memory map and one
+// glTexImage3D per mip level, instead of parsing json and decoding every
+// image at startup.
+//
+// Packs remember a hash of the blocks.json they were baked from, and Open
+// refuses a stale one. Rerun the bake (misc/AssetBake, or delete the pack and
+// the game rebakes it) after changing a texture without touching blocks.json
+class AssetPack
+{
+public:
+    // Bumped whenever the file layout changes
+    static const GLuint formatVersion = 2;
+    // Width and height of every texture layer. Images of other sizes are scaled to it
+    static const GLuint layerSize = 512;
+
+    AssetPack() {};
+    ~AssetPack(); // Unmaps the file
+    AssetPack(const AssetPack &) = delete;
+    AssetPack &operator=(const AssetPack &) = delete;
+
+    // Hash of the blocks.json bytes a pack is checked against
+    static uint64_t HashDefinitions(const std::vector<GLubyte> &blocksFile);
+    // Bake a pack from the blocks.json bytes, decoding the textures it lists.
+    // Textures paths are relative to the working directory, like at runtime
+    static GLboolean Bake(const std::vector<GLubyte> &blocksFile, std::vector<GLubyte> &pack);
+
+    // Memory map a pack file. Returns false if it is missing, corrupt, or
+    // was baked from a blocks.json with another hash
+    GLboolean Open(const std::string &path, uint64_t definitionsHash);
+    // Use a pack already in memory (like one Bake just made), taking over its bytes
+    GLboolean Open(std::vector<GLubyte> &&pack, uint64_t definitionsHash);
+
+    // Fill a block registry from the pack's block table
+    void LoadBlocks(BlockRegistry &registry) const;
+    GLuint GetLayerCount() const { return layerCount; }
+    GLuint GetLevelCount() const { return levelCount; }
+    // Every layer of a mip level, one after another, ready for glTexImage3D
+    const GLubyte *GetLevelPixels(GLuint level) const;
+    // Width and height of a mip level's layers
+    static GLuint LevelSize(GLuint level) { return (layerSize >> level) > 0 ? (layerSize >> level) : 1; }
+
+private:
+    // The whole pack, either mapped or in packMemory
+    const GLubyte *packData = nullptr;
+    size_t packSize = 0;
+    GLboolean mapped = false;
+    std::vector<GLubyte> packMemory;
+
+    GLuint layerCount = 0;
+    GLuint levelCount = 0;
+    GLuint blockCount = 0;
+    size_t blockTableOffset = 0;
+    size_t pixelOffset = 0;
+
+    // Check the header and read the counts and offsets out of it
+    GLboolean ReadHeader(uint64_t definitionsHash);
+    // Unmap or free whatever we hold
+    void Close();
+};
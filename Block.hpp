@@ -1,8 +1,5 @@
 #pragma once
 
-#include <glm/glm.hpp>
-#include <nlohmann/json.hpp>
-using json = nlohmann::json;
 #include <glm/glm.hpp>
 #include <glad/glad.h>
 
@@ -29,38 +26,15 @@ struct Block_Configuration
 
 
 
-// Struct used to determine the ambient occlusion for each face of a block
-struct aoBlockFace
-{
-    // Booleans to determine where ambient occlusion
-    // should be done
-    GLboolean aoTopLeft = false;
-    GLboolean aoTopRight = false;
-    GLboolean aoBottomLeft = false;
-    GLboolean aoBottomRight = false;
-};
-
-
-
+// A single block, built on the fly from a chunk's block storage
+// (chunks only store block type IDs, see BlockStorage.hpp)
 class Block
 {
 public:
     glm::vec3 position; // Position of the block
     GLint blockTypeID = -1; // What type of block is this? By default Air
 
-    // A struct to determine the Ambient Occlusion values
-    // for each face of the block
-    aoBlockFace topFace;
-    aoBlockFace bottomFace;
-    aoBlockFace leftFace;
-    aoBlockFace rightFace;
-    aoBlockFace frontFace;
-    aoBlockFace backFace;
-
     // Blank constuctor
     Block(){};
 };
 
-// Reference for our textures
-inline json blocks;
-
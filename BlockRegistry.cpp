@@ -0,0 +1,129 @@
+#include "BlockRegistry.hpp"
+
+#include <iostream>
+#include <algorithm> // For std::min
+
+
+
+BlockRegistry::BlockRegistry()
+{
+    // Air is there whatever blocks get loaded
+    blockIDs["Air"] = Air;
+    blockNames[Air + 1] = "Air";
+}
+
+
+
+void BlockRegistry::LoadDefinitions(const json &definitions)
+{
+    // Each block's main texture goes in the texture layer matching its ID
+    for(auto &el : definitions.items())
+    {
+        GLuint id = el.value()["id"];
+        if(id >= maxBlockTypes)
+        {
+            std::cout << "Block " << el.key() << " has an ID past the block type limit of " << maxBlockTypes << std::endl;
+            continue;
+        }
+        if(el.key().size() > maxNameLength)
+        {
+            std::cout << "Block " << el.key().substr(0, 32) << "... has a name longer than " << maxNameLength << " characters" << std::endl;
+            continue;
+        }
+        if(id >= maxTextureLayers)
+        {
+            std::cout << "Block " << el.key() << " has an ID past the texture layer limit of " << maxTextureLayers << ", its texture couldn't be drawn" << std::endl;
+            continue;
+        }
+        if(textureLayers.size() <= id)
+            textureLayers.resize(id + 1);
+        textureLayers[id] = el.value()["texture"];
+    }
+
+    for(auto &el : definitions.items())
+    {
+        GLint id = el.value()["id"];
+        if(id >= (GLint)maxBlockTypes || id >= (GLint)maxTextureLayers || el.key().size() > maxNameLength)
+            continue;
+
+        BlockProperties &block = properties[id + 1];
+        block.flags = ((bool)el.value()["transparent"] ? Block_Transparent : Block_Opaque);
+        if((bool)el.value()["isFoliage"])
+            block.flags |= Block_Foliage;
+        // Optional block light, e.g. "emission": 14. Light levels go up to 15
+        if(el.value().contains("emission"))
+            block.emission = std::min((GLuint)el.value()["emission"], 15u);
+
+        for(GLuint face = 0; face < 6; face++)
+            block.faceTexture[face] = id;
+        // Optional per face textures, e.g. "faceTextures": { "side": "resources/Textures/grass_side.jpeg" }
+        if(el.value().contains("faceTextures"))
+        {
+            const json &faces = el.value()["faceTextures"];
+            if(faces.contains("top"))
+                block.faceTexture[BlockFaces::Top_Face] = TextureLayer(faces["top"], id);
+            if(faces.contains("bottom"))
+                block.faceTexture[BlockFaces::Bottom_Face] = TextureLayer(faces["bottom"], id);
+            if(faces.contains("side"))
+            {
+                GLubyte sideLayer = TextureLayer(faces["side"], id);
+                block.faceTexture[BlockFaces::Back_Face] = sideLayer;
+                block.faceTexture[BlockFaces::Front_Face] = sideLayer;
+                block.faceTexture[BlockFaces::Left_Face] = sideLayer;
+                block.faceTexture[BlockFaces::Right_Face] = sideLayer;
+            }
+        }
+
+        blockIDs[el.key()] = id;
+        blockNames[id + 1] = el.key();
+    }
+}
+
+
+
+void BlockRegistry::AddBlockType(GLint blockTypeID, const std::string &name, const BlockProperties &blockProperties)
+{
+    if(blockTypeID < 0 || blockTypeID >= (GLint)maxBlockTypes)
+    {
+        std::cout << "Block " << name << " has an ID past the block type limit of " << maxBlockTypes << std::endl;
+        return;
+    }
+    if(name.size() > maxNameLength)
+    {
+        std::cout << "Block " << name.substr(0, 32) << "... has a name longer than " << maxNameLength << " characters" << std::endl;
+        return;
+    }
+    properties[blockTypeID + 1] = blockProperties;
+    blockIDs[name] = blockTypeID;
+    blockNames[blockTypeID + 1] = name;
+}
+
+
+
+GLint BlockRegistry::GetID(const std::string &name) const
+{
+    auto it = blockIDs.find(name);
+    if(it == blockIDs.end())
+    {
+        std::cout << "Unknown block type " << name << ", using air" << std::endl;
+        return Air;
+    }
+    return it->second;
+}
+
+
+
+GLubyte BlockRegistry::TextureLayer(const std::string &texturePath, GLubyte fallbackLayer)
+{
+    for(GLuint layer = 0; layer < textureLayers.size(); layer++)
+        if(textureLayers[layer] == texturePath)
+            return layer;
+
+    if(textureLayers.size() >= maxTextureLayers)
+    {
+        std::cout << "No texture layer left for " << texturePath << " (the limit is " << maxTextureLayers << "), using its block's main texture instead" << std::endl;
+        return fallbackLayer;
+    }
+    textureLayers.push_back(texturePath);
+    return textureLayers.size() - 1;
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "Block.hpp"
+
+#include <glad/glad.h>
+#include <nlohmann/json.hpp>
+using json = nlohmann::json;
+#include <string> // For std::string
+#include <unordered_map> // For unordered_map
+#include <vector> // For std::vector
+
+
+
+// Packed property flags for each block type
+typedef enum BlockFlags {
+    Block_Transparent = 1 << 0, // Neighbouring faces are drawn against it
+    Block_Foliage     = 1 << 1, // Transparent, but still draws its own sides and casts AO
+    Block_Opaque      = 1 << 2  // Hides any face touching it
+} BlockFlags;
+
+
+
+// Everything the mesher needs to know about a block type, small enough
+// that the whole table sits in a couple of cache lines
+struct BlockProperties
+{
+    GLubyte flags = Block_Transparent;
+    // Texture array layer for each face, indexed by BlockFaces
+    GLubyte faceTexture[6] = {0, 0, 0, 0, 0, 0};
+    // Block light level (0-15) the block gives off, 0 for blocks that don't glow
+    GLubyte emission = 0;
+};
+
+
+
+// Dense, ID indexed table of block properties. Built once from
+// resources/blocks.json, then only read (so it is safe to query from any thread)
+class BlockRegistry
+{
+public:
+    // Block type ID of air
+    static const GLint Air = -1;
+    // Most block types we can have, one per texture array layer
+    static const GLuint maxBlockTypes = 256;
+    // Most texture array layers faces can use, vertices only have 5 bits for the
+    // layer. A block's main texture is the layer matching its ID, so blocks with
+    // an ID past this are rejected too
+    static const GLuint maxTextureLayers = 32;
+    // Longest block name we take. Asset packs and saves store names behind a one byte length
+    static const GLuint maxNameLength = 255;
+
+    // Starts out knowing only air
+    BlockRegistry();
+
+    // Fill the table from the parsed blocks.json
+    void LoadDefinitions(const json &definitions);
+    // Add one block type, with its properties already worked out (like from an AssetPack)
+    void AddBlockType(GLint blockTypeID, const std::string &name, const BlockProperties &blockProperties);
+
+    // Properties of a block type. Air sits at slot 0, so ID -1 needs no special case
+    const BlockProperties &Get(GLint blockTypeID) const { return properties[blockTypeID + 1]; }
+    GLboolean IsTransparent(GLint blockTypeID) const { return (properties[blockTypeID + 1].flags & Block_Transparent) != 0; }
+    GLboolean IsFoliage(GLint blockTypeID) const { return (properties[blockTypeID + 1].flags & Block_Foliage) != 0; }
+    GLboolean IsOpaque(GLint blockTypeID) const { return (properties[blockTypeID + 1].flags & Block_Opaque) != 0; }
+    GLuint FaceTexture(GLint blockTypeID, GLuint faceIndex) const { return properties[blockTypeID + 1].faceTexture[faceIndex]; }
+    GLuint Emission(GLint blockTypeID) const { return properties[blockTypeID + 1].emission; }
+
+    // Look up a block type ID by its name in blocks.json. Only meant for setup
+    // code, hot loops should look their IDs up once and keep them
+    GLint GetID(const std::string &name) const;
+    // Name of a block type in blocks.json, the inverse of GetID. Saves store names, so
+    // they still load if block IDs get renumbered
+    const std::string &GetName(GLint blockTypeID) const { return blockNames[blockTypeID + 1]; }
+    // Image paths for each texture array layer, in layer order
+    const std::vector<std::string> &GetTextureLayers() const { return textureLayers; }
+
+private:
+    BlockProperties properties[maxBlockTypes + 1];
+    std::unordered_map<std::string, GLint> blockIDs;
+    // Indexed like properties, so air is at 0
+    std::string blockNames[maxBlockTypes + 1];
+    std::vector<std::string> textureLayers;
+
+    // Get the layer for an image, adding a new layer if this is the first time we see it.
+    // Gives fallbackLayer (with a warning) if every layer we can address is taken
+    GLubyte TextureLayer(const std::string &texturePath, GLubyte fallbackLayer);
+};
+
+// The block properties every chunk, player and generation lookup goes through
+inline BlockRegistry blockRegistry;
@@ -0,0 +1,187 @@
+#include "BlockStorage.hpp"
+
+
+
+// How many blocks are in one section
+static const GLuint sectionVolume = BlockSection::volume;
+
+
+
+BlockSection::BlockSection()
+{
+    // -1 is the block type ID for air
+    palette.push_back(-1);
+}
+
+
+
+void BlockSection::Set(GLuint index, GLint blockTypeID)
+{
+    // Setting a uniform section to the type it already holds is free
+    if(bitsPerBlock == 0 && palette[0] == blockTypeID)
+        return;
+
+    GLuint paletteIndex = PaletteIndex(blockTypeID);
+    // If the palette no longer fits in our index width, double it
+    if(paletteIndex > indexMask || bitsPerBlock == 0)
+    {
+        GLuint newBitsPerBlock = (bitsPerBlock == 0 ? 1 : bitsPerBlock);
+        while(paletteIndex >= (1u << newBitsPerBlock))
+            newBitsPerBlock *= 2;
+        Resize(newBitsPerBlock);
+    }
+    WriteIndex(index, paletteIndex);
+}
+
+
+
+void BlockSection::Fill(GLint blockTypeID)
+{
+    // Drop back to the single-value representation
+    palette.assign(1, blockTypeID);
+    data.clear();
+    data.shrink_to_fit();
+    bitsPerBlock = 0;
+    indexMask = 0;
+}
+
+
+
+void BlockSection::Assign(const GLint *blockTypeIDs, GLuint typeCount, const GLubyte *typeIndices)
+{
+    // Only block types that show up get a palette entry, so the indices come out as narrow as Set would make them
+    GLubyte used[256] = {};
+    for(GLuint i = 0; i < sectionVolume; i++)
+        used[typeIndices[i]] = 1;
+    palette.clear();
+    GLubyte paletteIndices[256];
+    for(GLuint type = 0; type < typeCount; type++)
+        if(used[type])
+            paletteIndices[type] = PaletteIndex(blockTypeIDs[type]);
+    if(palette.size() == 1)
+    {
+        Fill(palette[0]);
+        return;
+    }
+
+    bitsPerBlock = 1;
+    while((1u << bitsPerBlock) < palette.size())
+        bitsPerBlock *= 2;
+    indexMask = (1ull << bitsPerBlock) - 1;
+    data.assign(sectionVolume * bitsPerBlock / 64, 0);
+
+    // Each word holds a whole number of entries, so it is built up in a register and stored once
+    const GLuint entriesPerWord = 64 / bitsPerBlock;
+    for(GLuint word = 0; word < data.size(); word++)
+    {
+        const GLubyte *indices = typeIndices + word * entriesPerWord;
+        uint64_t packed = 0;
+        for(GLuint i = 0; i < entriesPerWord; i++)
+            packed |= (uint64_t)paletteIndices[indices[i]] << (i * bitsPerBlock);
+        data[word] = packed;
+    }
+}
+
+
+
+size_t BlockSection::MemoryUsage() const
+{
+    return sizeof(BlockSection) + palette.capacity() * sizeof(GLint) + data.capacity() * sizeof(uint64_t);
+}
+
+
+
+GLboolean BlockSection::Load(std::vector<GLint> &savedPalette, GLuint savedBitsPerBlock, std::vector<uint64_t> &savedData)
+{
+    if(savedPalette.empty() || (savedBitsPerBlock != 0 && savedBitsPerBlock != 1 && savedBitsPerBlock != 2 && savedBitsPerBlock != 4 && savedBitsPerBlock != 8 && savedBitsPerBlock != 16))
+        return false;
+    if(savedData.size() != sectionVolume * savedBitsPerBlock / 64 || (savedBitsPerBlock == 0 && savedPalette.size() != 1) || (savedBitsPerBlock != 0 && savedPalette.size() > (1u << savedBitsPerBlock)))
+        return false;
+
+    // Unless the palette fills the whole index range, make sure no index points past it
+    uint64_t savedIndexMask = (savedBitsPerBlock == 0 ? 0 : (1ull << savedBitsPerBlock) - 1);
+    if(savedBitsPerBlock != 0 && savedPalette.size() < (1u << savedBitsPerBlock))
+    {
+        for(GLuint i = 0; i < sectionVolume; i++)
+        {
+            GLuint bitIndex = i * savedBitsPerBlock;
+            if(((savedData[bitIndex >> 6] >> (bitIndex & 63)) & savedIndexMask) >= savedPalette.size())
+                return false;
+        }
+    }
+
+    palette.swap(savedPalette);
+    data.swap(savedData);
+    bitsPerBlock = savedBitsPerBlock;
+    indexMask = savedIndexMask;
+    return true;
+}
+
+
+
+GLuint BlockSection::PaletteIndex(GLint blockTypeID)
+{
+    // Palettes are tiny (a handful of block types), so a linear scan beats a map
+    for(GLuint i = 0; i < palette.size(); i++)
+        if(palette[i] == blockTypeID)
+            return i;
+
+    palette.push_back(blockTypeID);
+    return palette.size() - 1;
+}
+
+
+
+void BlockSection::Resize(GLuint newBitsPerBlock)
+{
+    std::vector<uint64_t> oldData;
+    oldData.swap(data);
+    GLuint oldBitsPerBlock = bitsPerBlock;
+    uint64_t oldIndexMask = indexMask;
+
+    bitsPerBlock = newBitsPerBlock;
+    indexMask = (1ull << bitsPerBlock) - 1;
+    data.assign(sectionVolume * bitsPerBlock / 64, 0);
+
+    // A section that was single-valued holds palette index 0 everywhere,
+    // which is already what our zeroed data says
+    if(oldBitsPerBlock == 0)
+        return;
+
+    for(GLuint i = 0; i < sectionVolume; i++)
+    {
+        GLuint bitIndex = i * oldBitsPerBlock;
+        WriteIndex(i, (oldData[bitIndex >> 6] >> (bitIndex & 63)) & oldIndexMask);
+    }
+}
+
+
+
+void BlockSection::WriteIndex(GLuint index, GLuint paletteIndex)
+{
+    GLuint bitIndex = index * bitsPerBlock;
+    uint64_t &word = data[bitIndex >> 6];
+    word &= ~(indexMask << (bitIndex & 63));
+    word |= (uint64_t)paletteIndex << (bitIndex & 63);
+}
+
+
+
+size_t BlockStorage::MemoryUsage() const
+{
+    size_t total = 0;
+    for(const BlockSection &section : sections)
+        total += section.MemoryUsage();
+    return total;
+}
+
+
+
+GLboolean BlockStorage::IsUniform(GLint &blockTypeID) const
+{
+    blockTypeID = sections[0].Get(0);
+    for(const BlockSection &section : sections)
+        if(!section.IsUniform() || section.Get(0) != blockTypeID)
+            return false;
+    return true;
+}
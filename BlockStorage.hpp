@@ -0,0 +1,117 @@
+#pragma once
+
+#include "WorldConstants.hpp"
+
+#include <glad/glad.h>
+#include <cstdint> // For uint64_t
+#include <vector> // For std::vector
+
+
+
+// A cube of blocks stored as a small palette of block type IDs plus
+// bit-packed indices into that palette. A section holding only one block
+// type (all air, all stone, etc) keeps no index data at all
+class BlockSection
+{
+public:
+    // How many blocks are in one section
+    static const GLuint volume = World::blockSectionSize * World::blockSectionSize * World::blockSectionSize;
+
+    // Every section starts out filled with air
+    BlockSection();
+
+    // Get the block type ID at a 1D index inside the section
+    GLint Get(GLuint index) const
+    {
+        // Single-value fast path, there is nothing packed to read
+        if(bitsPerBlock == 0)
+            return palette[0];
+
+        GLuint bitIndex = index * bitsPerBlock;
+        // Entries are a power of 2 bits wide, so they never straddle two words
+        return palette[(data[bitIndex >> 6] >> (bitIndex & 63)) & indexMask];
+    }
+    // Set the block type ID at a 1D index inside the section
+    void Set(GLuint index, GLint blockTypeID);
+    // Set every block in the section to one block type
+    void Fill(GLint blockTypeID);
+    // Replace every block in the section at once. typeIndices holds one byte per
+    // block (in section index order) picking one of the typeCount entries of
+    // blockTypeIDs. The palette is built from the entries that are used and
+    // everything is packed in one pass, instead of a palette lookup per block
+    void Assign(const GLint *blockTypeIDs, GLuint typeCount, const GLubyte *typeIndices);
+    // Whether every block in this section is the same type
+    GLboolean IsUniform() const { return bitsPerBlock == 0; }
+    // How many bytes this section is using on the heap and inline
+    size_t MemoryUsage() const;
+
+    // Our raw palette and packed indices, for writing the section to disk
+    const std::vector<GLint> &GetPalette() const { return palette; }
+    const std::vector<uint64_t> &GetData() const { return data; }
+    GLuint GetBitsPerBlock() const { return bitsPerBlock; }
+    // Take over a palette and packed indices read back from disk. Returns false,
+    // leaving the section untouched, if they don't make up a valid section
+    GLboolean Load(std::vector<GLint> &savedPalette, GLuint savedBitsPerBlock, std::vector<uint64_t> &savedData);
+
+private:
+    // The block type IDs used in this section
+    std::vector<GLint> palette;
+    // Palette indices packed bitsPerBlock bits at a time
+    std::vector<uint64_t> data;
+    // 0 while the section only has one block type, then 1, 2, 4, 8 or 16
+    GLuint bitsPerBlock = 0;
+    uint64_t indexMask = 0;
+
+    // Find a block type in the palette, adding it if we have not seen it yet
+    GLuint PaletteIndex(GLint blockTypeID);
+    // Repack our indices with more bits per block once the palette outgrows them
+    void Resize(GLuint newBitsPerBlock);
+    // Write a palette index without any palette bookkeeping
+    void WriteIndex(GLuint index, GLuint paletteIndex);
+};
+
+
+
+// All the blocks of one chunk, split into palette compressed sections
+class BlockStorage
+{
+public:
+    // Get the block type ID of a block in chunk coordinates
+    GLint GetBlockType(GLint x, GLint y, GLint z) const
+    {
+        return sections[SectionIndex(x, y, z)].Get(LocalIndex(x, y, z));
+    }
+    // Set the block type ID of a block in chunk coordinates
+    void SetBlockType(GLint x, GLint y, GLint z, GLint blockTypeID)
+    {
+        sections[SectionIndex(x, y, z)].Set(LocalIndex(x, y, z), blockTypeID);
+    }
+    // How many bytes all of our sections are using
+    size_t MemoryUsage() const;
+    // Whether every block is the same type, and which. Only looks at the sections,
+    // so it costs nothing for the all-air and all-stone chunks of tall worlds
+    GLboolean IsUniform(GLint &blockTypeID) const;
+
+    static const GLuint sectionsX = World::chunkWidthX  / World::blockSectionSize;
+    static const GLuint sectionsY = World::chunkHeightY / World::blockSectionSize;
+    static const GLuint sectionsZ = World::chunkDepthZ  / World::blockSectionSize;
+    static const GLuint sectionCount = sectionsX * sectionsY * sectionsZ;
+
+    // Direct access to our sections, in SectionIndex order. For saving and loading
+    BlockSection &GetSection(GLuint index) { return sections[index]; }
+    const BlockSection &GetSection(GLuint index) const { return sections[index]; }
+    // Formula for a section is: sections[x + z*sectionsX + y*sectionsX*sectionsZ]
+    static GLuint SectionIndex(GLint x, GLint y, GLint z)
+    {
+        return (x / World::blockSectionSize) + (z / World::blockSectionSize) * sectionsX + (y / World::blockSectionSize) * sectionsX * sectionsZ;
+    }
+
+private:
+    BlockSection sections[sectionCount];
+
+    // Formula for a block inside a section is: [x + z*size + y*size*size]
+    static GLuint LocalIndex(GLint x, GLint y, GLint z)
+    {
+        return (x % World::blockSectionSize) + (z % World::blockSectionSize) * World::blockSectionSize + (y % World::blockSectionSize) * World::blockSectionSize * World::blockSectionSize;
+    }
+};
@@ -1,5 +1,7 @@
 #include "BufferManager.hpp"
 #include "resources/Models/Light.cpp"
+#include "Profiler.hpp"
+#include "QuadIndexBuffer.hpp"
 
 #define STB_IMAGE_IMPLEMENTATION // Have to include this or STB will throw error
 #include <stb/stb_image.h>       // Used for textures / image processing
@@ -27,11 +29,27 @@ BufferManager::BufferManager() : cubeShaderProgram("shaders/cube.vert", "shaders
     // Activate all of our textures
     ActivateTextures();
 
-    // Generate our chunks if they have not been generated yet
+    // Chunk meshes draw their quads through one shared index buffer, if enabled
+    quadIndexBuffer_.Init();
+    // Every chunk mesh goes into one shared vertex buffer, if enabled
+    chunkArena_.Init();
+    cubeShaderProgram.SetInt("chunkArenaEnabled", World::multiDrawRendering);
+    cubeShaderProgram.SetInt("chunkArenaPageVertices", World::chunkArenaPageVertices);
+    cubeShaderProgram.SetInt("chunkArenaPageOffsets", chunkArena_.GetPageTableTextureUnit());
+    cubeShaderProgram.SetInt("vertexPulling", World::vertexPulling);
+    cubeShaderProgram.SetInt("quadRecords", chunkArena_.GetRecordTextureUnit());
+
+    // Start generating the chunks around the origin
     chunkManager.GenerateChunks();
 
     // Set our blocksize in our vertex shader
-    glUniform1f(glGetUniformLocation(cubeShaderProgram.GetID(), "blockSize"), World::blockSize);
+    cubeShaderProgram.SetFloat("blockSize", World::blockSize);
+
+    // One buffer feeds the camera and light data to every shader, instead of
+    // setting the same uniforms on each program every frame
+    frameUniformBuffer.InitUBO(sizeof(FrameData), frameDataBindingPoint);
+    cubeShaderUsesFrameData = cubeShaderProgram.BindUniformBlock("FrameData", frameDataBindingPoint);
+    lightShaderUsesFrameData = lightShaderProgram.BindUniformBlock("FrameData", frameDataBindingPoint);
 }
 
 BufferManager::~BufferManager()
@@ -39,21 +57,33 @@ BufferManager::~BufferManager()
     LightVAO.Delete();
     LightVBO.Delete();
     LightEBO.Delete();
+    frameUniformBuffer.Delete();
+    chunkArena_.Delete();
+    quadIndexBuffer_.Delete();
 }
 
-void BufferManager::RunLoop(GLFWwindow *window, glm::vec3 cameraPosition, glm::vec3 cameraOrientation)
+void BufferManager::RunLoop(GLFWwindow *window, const Camera &camera)
 {
     // Set all of the uniforms for our lighting shader
     glm::vec4 lightColor = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);                                    // Color of the light
                                                                                                  // glm::vec3 lightPosition = glm::vec3(sin(glfwGetTime()) * World::chunkSize, World::heightLimit, sin(glfwGetTime()) * World::chunkSize); // Position of the light cube
-    glm::vec3 lightPosition = glm::vec3(World::chunkSize, World::heightLimit, World::chunkSize); // Position of the light cube
+    glm::vec3 lightPosition = glm::vec3(World::chunkSize, World::terrainHeight, World::chunkSize); // Position of the light cube
     glm::mat4 lightModel = glm::mat4(1.0f);
     lightModel = glm::translate(lightModel, lightPosition);
+
+    // Camera and light data shared by our cube and light shaders
+    FrameData frameData;
+    frameData.projectionMatrix = camera.GetProjectionMatrix();
+    frameData.viewMatrix = camera.GetViewMatrix();
+    frameData.cameraPosition = glm::vec4(camera.Position, 1.0f);
+    frameData.lightPosition = glm::vec4(lightPosition, 1.0f);
+    frameData.lightColor = lightColor;
+    UpdateFrameData(frameData);
+
     // Tells OpenGL which Shader Program we want to use
     lightShaderProgram.Activate();
-    // Export our various uniform values to our lighting shaders
-    glUniformMatrix4fv(glGetUniformLocation(lightShaderProgram.GetID(), "model"), 1, GL_FALSE, glm::value_ptr(lightModel));
-    glUniform4f(glGetUniformLocation(lightShaderProgram.GetID(), "lightColor"), lightColor.x, lightColor.y, lightColor.z, lightColor.w);
+    // Export our light cube's model matrix to our lighting shaders
+    lightShaderProgram.SetMat4("model", lightModel);
     // Bind the VAO so OpenGL knows to use it
     LightVAO.Bind();
     // Draw primitive, number of indices, datatype of indices, index of indices
@@ -62,13 +92,43 @@ void BufferManager::RunLoop(GLFWwindow *window, glm::vec3 cameraPosition, glm::v
 
     // Tell OpenGL which Shader Program we want to use
     cubeShaderProgram.Activate();
-    // Assign uniforms for our cube shader
-    glUniform4f(glGetUniformLocation(cubeShaderProgram.GetID(), "lightColor"), lightColor.x, lightColor.y, lightColor.z, lightColor.w);
-    glUniform3f(glGetUniformLocation(cubeShaderProgram.GetID(), "lightPosition"), lightPosition.x, lightPosition.y, lightPosition.z);
-    glUniform3f(glGetUniformLocation(cubeShaderProgram.GetID(), "cameraPosition"), cameraPosition.x, cameraPosition.y, cameraPosition.z);
 
-    // Render all of our chunks
-    chunkManager.RenderChunks(cameraPosition, cameraOrientation, cubeShaderProgram.GetID());
+    // Load and unload chunks around the camera, upload finished chunk meshes and
+    // queue new ones, then render all of our chunks
+    {
+        ProfileScope streaming(Profile_Streaming);
+        chunkManager.StreamChunks(camera.Position);
+    }
+    chunkManager.UpdateMeshes(camera.Position, camera.GetProjectionScale());
+    chunkManager.RenderChunks(camera.GetViewProjectionMatrix(), cubeShaderProgram);
+}
+
+void BufferManager::UpdateFrameData(const FrameData &frameData)
+{
+    // A single upload reaches every shader that declares the FrameData block
+    frameUniformBuffer.UpdateUBO(&frameData, sizeof(FrameData));
+
+    // Fall back to plain uniforms for shaders that don't
+    if (!lightShaderUsesFrameData)
+    {
+        lightShaderProgram.Activate();
+        SetFrameDataUniforms(lightShaderProgram, frameData);
+    }
+    if (!cubeShaderUsesFrameData)
+    {
+        cubeShaderProgram.Activate();
+        SetFrameDataUniforms(cubeShaderProgram, frameData);
+    }
+}
+
+void BufferManager::SetFrameDataUniforms(Shader &shader, const FrameData &frameData)
+{
+    // Uniforms the shader doesn't have are silently skipped
+    shader.SetMat4("projectionMatrix", frameData.projectionMatrix);
+    shader.SetMat4("viewMatrix", frameData.viewMatrix);
+    shader.SetVec3("cameraPosition", glm::vec3(frameData.cameraPosition));
+    shader.SetVec3("lightPosition", glm::vec3(frameData.lightPosition));
+    shader.SetVec4("lightColor", frameData.lightColor);
 }
 
 void BufferManager::ActivateTextures()
@@ -76,65 +136,37 @@ void BufferManager::ActivateTextures()
     // Tell OpenGL which Shader Program we want to use
     cubeShaderProgram.Activate();
 
-    // Load all of our textures from a json file
-    std::ifstream ifs("resources/blocks.json");
-    json jf;
-
-    if (ifs.is_open())
-    {
-        jf = json::parse(ifs);
-    }
-    else
+    // Blocks and textures come from the asset pack baked from blocks.json. We only
+    // read blocks.json to check the pack was baked from this version of it
+    std::ifstream ifs("resources/blocks.json", std::ios::binary);
+    if (!ifs.is_open())
     {
         std::cout << "The texture file could not be opened." << std::endl;
+        return;
     }
+    std::vector<GLubyte> blocksFile((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+    uint64_t definitionsHash = AssetPack::HashDefinitions(blocksFile);
 
-    std::string texture_path;
-    std::string group;
-    bool texture_transparent;
-    bool texture_isFoliage;
-    GLuint index = 0;
-    GLuint count = 0;
-
-    // Add air tile
-    blocks["Air"]["index"] = -1;
-    blocks["Air"]["transparent"] = true;
-    blocks["Air"]["isFoliage"] = false;
-    blocks["Air"]["group"] = "Air";
-    blocks["-1"]["transparent"] = true;
-    blocks["-1"]["isFoliage"] = false;
-    blocks["-1"]["group"] = "Air";
-
-    // Loop through all of our textures. Double for loop
-    // makes sure we get all the indices in order
-    for (auto it = jf.begin(); it != jf.end(); it++)
+    // No pack yet, or blocks.json changed since it was baked, so bake it now and
+    // keep it for next time
+    AssetPack assetPack;
+    if (!assetPack.Open("resources/assets.pack", definitionsHash))
     {
-        for (auto el : jf.items())
-        {
-            index = el.value()["id"];
-            if (index == count)
-            {
-                // Get texture path and group from json
-                texture_path = el.value()["texture"];
-                group = el.value()["group"];
-                texture_transparent = (bool)el.value()["transparent"];
-                texture_isFoliage = (bool)el.value()["isFoliage"];
-                // Add the texture to our texture array
-                textureArray.AddTextureToArray(texture_path.c_str());
-                // Make an index for this texture
-                blocks[el.key()]["index"] = index;
-                blocks[el.key()]["group"] = group;
-                blocks[el.key()]["transparent"] = texture_transparent;
-                blocks[el.key()]["isFoliage"] = texture_isFoliage;
-                blocks["" + std::to_string(index) + ""]["transparent"] = texture_transparent;
-                blocks["" + std::to_string(index) + ""]["isFoliage"] = texture_isFoliage;
-                blocks["" + std::to_string(index) + ""]["group"] = group;
-                blocks["" + std::to_string(index) + ""]["texture"] = texture_path;
-                count++;
-            }
-        }
+        std::cout << "Baking resources/assets.pack, this only happens when blocks.json changes" << std::endl;
+        std::vector<GLubyte> pack;
+        if (!AssetPack::Bake(blocksFile, pack))
+            return;
+        std::ofstream packFile("resources/assets.pack", std::ios::binary);
+        packFile.write((const char *)pack.data(), pack.size());
+        if (!packFile)
+            std::cout << "Could not write resources/assets.pack, it will be baked again next time" << std::endl;
+        assetPack.Open(std::move(pack), definitionsHash);
     }
 
+    // Build our block property table once, everything else reads from it
+    assetPack.LoadBlocks(blockRegistry);
+    textureArray.Upload(assetPack);
+
     // Activate our 2D texture array
-    textureArray.ActivateShaderArray(cubeShaderProgram.GetID());
+    textureArray.ActivateShaderArray(cubeShaderProgram);
 }
@@ -3,9 +3,12 @@
 #include "VAO.hpp"
 #include "VBO.hpp"
 #include "EBO.hpp"
+#include "UBO.hpp"
 #include "ShaderManager.hpp"
 #include "ChunkManager.hpp"
 #include "TextureArray.hpp"
+#include "BlockRegistry.hpp"
+#include "Camera.hpp"
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
@@ -14,6 +17,20 @@
 
 
 
+// Per-frame camera and light data in std140 layout, uploaded once a frame to
+// the FrameData uniform block. vec3s are stored as vec4s because std140 pads
+// them to 16 bytes anyway. Must match the block declared in the shaders
+struct FrameData
+{
+    glm::mat4 projectionMatrix;
+    glm::mat4 viewMatrix;
+    glm::vec4 cameraPosition;
+    glm::vec4 lightPosition;
+    glm::vec4 lightColor;
+};
+
+
+
 class BufferManager
 {
 public:
@@ -24,6 +41,11 @@ public:
     EBO LightEBO;
     Shader lightShaderProgram{"shaders/lighting.vert", "shaders/lighting.frag"};
 
+    // Holds FrameData for every shader that declares the FrameData block
+    UBO frameUniformBuffer;
+    // Uniform buffer binding point FrameData is attached to
+    static const GLuint frameDataBindingPoint = 0;
+
     // Our textures
     TextureArray textureArray;
 
@@ -42,7 +64,19 @@ public:
     ~BufferManager();
 
     // Run the event loop once
-    void RunLoop(GLFWwindow *window, glm::vec3 cameraPosition, glm::vec3 cameraOrientation);
+    void RunLoop(GLFWwindow *window, const Camera &camera);
     // Activate textures
     void ActivateTextures();
+
+private:
+    // Whether each shader reads FrameData from the uniform buffer. A shader
+    // without the block gets the same values as plain uniforms instead
+    GLboolean cubeShaderUsesFrameData = false;
+    GLboolean lightShaderUsesFrameData = false;
+
+    // Upload this frame's camera and light data to the uniform buffer, and to
+    // any shader that doesn't declare the FrameData block
+    void UpdateFrameData(const FrameData &frameData);
+    // Set FrameData as individual uniforms on a shader, must be active
+    void SetFrameDataUniforms(Shader &shader, const FrameData &frameData);
 };
\ No newline at end of file
@@ -31,10 +31,10 @@ void Camera::updateMatrix(GLfloat FOVdeg, GLfloat nearPlane, GLfloat farPlane)
 void Camera::Matrix(Shader& shader, const char* projectionUniformName, const char* viewUniformName)
 {
 	// Make sure we use the shader program
-	glUseProgram(shader.GetID());
+	shader.Activate();
 	// Set our Camera matrix in our shaders
-	glUniformMatrix4fv(glGetUniformLocation(shader.GetID(), projectionUniformName), 1, GL_FALSE, glm::value_ptr(projectionMatrix));
-	glUniformMatrix4fv(glGetUniformLocation(shader.GetID(), viewUniformName), 1, GL_FALSE, glm::value_ptr(viewMatrix));
+	shader.SetMat4(projectionUniformName, projectionMatrix);
+	shader.SetMat4(viewUniformName, viewMatrix);
 	// Clear the shader program after we are done using it
 	glUseProgram(0);
 }
@@ -45,9 +45,9 @@ void Camera::Matrix(Shader& shader, const char* projectionUniformName, const cha
 void Camera::OrthographicMatrix(Shader& shader, const char* orthographicUniformName)
 {
 	// Make sure we use the shader program
-	glUseProgram(shader.GetID());
+	shader.Activate();
 	// Set our orthographic matrix in our shaders
-	glUniformMatrix4fv(glGetUniformLocation(shader.GetID(), orthographicUniformName), 1, GL_FALSE, glm::value_ptr(orthographicMatrix));
+	shader.SetMat4(orthographicUniformName, orthographicMatrix);
 	// Clear the shader program after we are done using it
 	glUseProgram(0);
 }
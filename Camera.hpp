@@ -25,6 +25,13 @@ public:
 
 	// Updates the camera matrix to the Vertex Shader
 	void updateMatrix(GLfloat FOVdeg, GLfloat nearPlane, GLfloat farPlane);
+	// Gets projection * view, for frustum culling
+	glm::mat4 GetViewProjectionMatrix() const { return projectionMatrix * viewMatrix; }
+	// Gets the projection and view matrices on their own, for the FrameData uniform buffer
+	const glm::mat4& GetProjectionMatrix() const { return projectionMatrix; }
+	const glm::mat4& GetViewMatrix() const { return viewMatrix; }
+	// How many pixels tall something one unit tall looks from one unit away, for screen space error
+	GLfloat GetProjectionScale() const { return projectionMatrix[1][1] * height * 0.5f; }
 	// Exports the camera matrix to a shader
 	void Matrix(Shader& shader, const char* projectionUniformName, const char* viewUniformName);
 	// Exports orthographic matrix to the Vertex Shader
@@ -1,35 +1,23 @@
 #include "Chunk.hpp"
+#include "ChunkMesher.hpp"
+#include "FeaturePlacer.hpp"
+
+#include "TerrainGenerator.hpp"
 
-#include <FastNoise/FastNoise.h> // Noise generator
 #include <cmath> // for abs()
 #include <vector> // For std::vector
-#include <stdlib.h> // For generating random numbers
-#include <algorithm> // std::find() function
+#include <algorithm> // For std::min and std::max
 #include <string> // For std::string
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TERRAIN_USE_SSE2
+#include <emmintrin.h> // SSE2 intrinsics
+#endif
 
 
-Chunk::Chunk(GLint position_x, GLint position_y, GLint position_z, GLuint BiomeIndex) : ChunkOpaqueVAO(), ChunkOpaqueVBO()
-{
-    // Generate Vertex Array Object and binds it
-    /* Opaque VBO */
-	ChunkOpaqueVAO.Bind();
-    ChunkOpaqueVBO.Bind();
-	// Links VBO attributes such as coordinates and colors to VAO
-	ChunkOpaqueVAO.LinkAttrib(ChunkOpaqueVBO, 0, 1, GL_FLOAT, 1 * sizeof(GLuint), (void*)0);
-	// Unbind all to prevent accidentally modifying them
-	ChunkOpaqueVBO.Unbind();
-    ChunkOpaqueVAO.Unbind();
-
-    /* Transparent VBO */
-    ChunkTransparentVAO.Bind();
-    ChunkTransparentVBO.Bind();
-	// Links VBO attributes such as coordinates and colors to VAO
-	ChunkOpaqueVAO.LinkAttrib(ChunkTransparentVBO, 0, 1, GL_FLOAT, 1 * sizeof(GLuint), (void*)0);
-	// Unbind all to prevent accidentally modifying them
-    ChunkTransparentVAO.Unbind();
-	ChunkTransparentVBO.Unbind();
 
+Chunk::Chunk(GLint position_x, GLint position_y, GLint position_z, GLuint BiomeIndex)
+{
     // Set offset of our chunk, so that chunks load at different positions
     // (not on top of each other)
     offset_x = position_x * (World::chunkWidthX  * World::blockSize);
@@ -42,1031 +30,283 @@ Chunk::Chunk(GLint position_x, GLint position_y, GLint position_z, GLuint BiomeI
 
     // Set our biome
     biomeID = BiomeIndex;
+
+    // We are the middle of our own neighbourhood
+    neighbours[NeighbourIndex(0, 0, 0)] = this;
+
+    // No slab of our mesh has anything in it until the first one is uploaded
+    for(GLuint slab = 0; slab < World::meshSlabCount; slab++)
+    {
+        slabMinY[slab] = World::chunkHeightY;
+        slabMaxY[slab] = -1;
+    }
 }
 
 
 
 Chunk::~Chunk()
 {
-    // Delete all buffers after program is stopped
-    // std::cout << "Deleting Chunk Buffers" << std::endl;
-    ChunkOpaqueVAO.Delete();
-    ChunkOpaqueVBO.Delete();
-    ChunkTransparentVAO.Delete();
-    ChunkTransparentVBO.Delete();
-    delete[] &chunkOpaqueVertices;
-    delete[] &chunkTransparentVertices;
-    delete[] &chunk;
+    // Nothing to free here, the chunk manager releases our mesh's GPU side
+    // (ChunkManager::ReleaseMesh) before deleting us
 }
 
 
 
-void Chunk::GenerateBlocks(GLuint seed, GLint biomeTypeIDPosX, GLint biomeTypeIDPosZ, GLint biomeTypeIDNegX, GLint biomeTypeIDNegZ)
-{
-    // Initialize FastNoise2
-    auto OpenSimplex = FastNoise::New<FastNoise::OpenSimplex2>();
-    auto FractalFBm = FastNoise::New<FastNoise::FractalFBm>();
-    FractalFBm->SetSource(OpenSimplex);
-    FractalFBm->SetGain(BiomeConfiguration[biomeID].NoiseGain);
-    FractalFBm->SetOctaveCount(4);
-    FractalFBm->SetLacunarity(5.0f);
-    // FractalFBm->SetWeightedStrength(0.01f);
-    
-    auto DomainScale = FastNoise::New<FastNoise::DomainScale>();
-    DomainScale->SetSource(FractalFBm);
-    DomainScale->SetScale(0.196f);
-
-    auto PositionOutput = FastNoise::New<FastNoise::PositionOutput>();
-    PositionOutput->Set<FastNoise::Dim::Y>(0.05f);
-
-    auto add = FastNoise::New<FastNoise::Add>();
-    add->SetLHS(DomainScale);
-    add->SetRHS(PositionOutput);
-
-    // Vector structure to hold our noise
-    std::vector<GLfloat> interpolNoise(9); // Top center
-    
-     std::vector<GLfloat> noiseOutput(World::chunkWidthX * World::chunkDepthZ);
-    // Index for when we loop through our noiseOutput 
-    GLint noiseIndex = 0;
-
-    GLint adjustedChunkPosX = chunk_position_x * (GLint)World::chunkWidthX;
-    GLint adjustedChunkPosZ = chunk_position_z * (GLint)World::chunkDepthZ;
-    // Generate a chunkWidthX x chunkDepthZ area of noise
-    add->GenUniformGrid2D(noiseOutput.data(), adjustedChunkPosX, adjustedChunkPosZ, (GLint)World::chunkWidthX, (GLint)World::chunkDepthZ, BiomeConfiguration[biomeID].NoiseFrequency, seed);
+// The layers a column of terrain is made of, top to bottom. Surface, subsurface and
+// stone follow each other, so a block's layer is Layer_Surface plus how many of the
+// other two it is deep enough for
+typedef enum TerrainLayer {
+    Layer_Air        = 0,
+    Layer_Liquid     = 1,
+    Layer_Surface    = 2, // The top block of the ground
+    Layer_Subsurface = 3, // The 3 blocks under it
+    Layer_Stone      = 4, // Everything further down
+    Layer_Count      = 5
+} TerrainLayer;
 
-    GLfloat cubesY; // Variable to store our noise in the for loops
 
-    GLuint treeHeightIndex = 0; // Index for seeing the max tree height
 
-    for(GLfloat z = 0; z < World::chunkDepthZ; z += 1)
-    for(GLfloat x = 0; x < World::chunkWidthX; x += 1)
+// Work out the TerrainLayer of count blocks in a row at height worldY, given the
+// surface height of each of their columns. aboveGround is the layer above the
+// surface (air, or liquid at the water level). Branch free, 16 blocks at a time with SSE2
+static void FillTerrainRow(GLubyte *layers, const GLint *surfaceHeights, GLint count, GLint worldY, GLubyte aboveGround)
+{
+    GLint x = 0;
+#ifdef TERRAIN_USE_SSE2
+    const __m128i y = _mm_set1_epi32(worldY);
+    const __m128i subsurfaceDepth = _mm_set1_epi32(1);
+    const __m128i stoneDepth = _mm_set1_epi32(4);
+    const __m128i surfaceLayer = _mm_set1_epi32(Layer_Surface);
+    const __m128i aboveGroundLayer = _mm_set1_epi32(aboveGround);
+    for(; x + 16 <= count; x += 16)
     {
-        cubesY = (GLint)(abs(noiseOutput[noiseIndex]) * (heightMax - heightMin) + heightMin);
-        noiseIndex++;
-        
-
-        for(GLfloat y = 0; y < World::chunkHeightY; y += 1)
+        __m128i lanes[4];
+        for(GLuint i = 0; i < 4; i++)
         {
-            // If y is less than cubesY, we want to generate the block,
-            // because cubesY is our max height
-            if(y + offset_y < cubesY)
-            {
-                Block tempBlock;
-                // Set our block's position with the correct chunk offset
-                tempBlock.position = glm::vec3(x, y, z);
-
-                // Logic for determining which block type to place
-                if(y + offset_y >= cubesY - 1)
-                    tempBlock.blockTypeID = BiomeConfiguration[biomeID].Surface_Block;
-                else if(y + offset_y >= cubesY - 4)
-                    tempBlock.blockTypeID = BiomeConfiguration[biomeID].Subsurface_Block;
-                else
-                    tempBlock.blockTypeID = blocks["Stone_Block"]["index"];;
-
-                // Set our block
-                SetBlock(tempBlock);
-            }
-            // If its greater than cubesY, we don't want to generate the block
-            // but we still want to record its position
-            else
-            {
-                // Random chance to make an oak tree
-                if((y + offset_y == cubesY && rand() % BiomeConfiguration[biomeID].TreeFrequency == 0 && BiomeConfiguration[biomeID].TreeFrequency != -1) || (treeHeightIndex >= 1 && treeHeightIndex <= 5))
-                {
-                    // Check if this tree would even fit inside the chunk (for now 
-                    // don't want to deal with placing leaves across chunks)
-                    if(((treeHeightIndex == 0 && y + 7.0f < World::chunkHeightY) || treeHeightIndex > 0) && x + 2 < World::chunkWidthX && z + 2 < World::chunkDepthZ and x > 1 and z > 1)
-                    {
-                        Block woodBlock;
-                        // Set our block's position with the correct chunk offset
-                        woodBlock.position = glm::vec3(x, y, z);
-                        woodBlock.blockTypeID = blocks["Oak_Log"]["index"];
-                        // Set our block
-                        SetBlock(woodBlock);
-                        treeHeightIndex = (treeHeightIndex == -1 ? 1 : treeHeightIndex + 1);
-
-                        // Put leaves around wood
-                        if(treeHeightIndex == 6)
-                        {
-                            Block leavesBlock;
-                            leavesBlock.position = glm::vec3(x, y+1, z);
-                            leavesBlock.blockTypeID = blocks["Oak_Leaves"]["index"];
-                            // Make first layer of leaves
-                            for(int i=x-2; i<=x+2; i++)
-                                for(int j=z-2; j<=z+2; j++)
-                                {
-                                    leavesBlock.position = glm::vec3(i, y+1, j);
-                                    SetBlock(leavesBlock);
-                                }
-
-                            // Make second layer of leaves
-                            for(int i=x-2; i<=x+2; i++)
-                                for(int j=z-2; j<=z+2; j++)
-                                    if((i != x+2 && j != z+2) && (i != x-2 && j != z+2) && (i != x+2 && j != z-2) && (i != x-2 && j != z-2))
-                                    {
-                                        leavesBlock.position = glm::vec3(i, y+2, j);
-                                        SetBlock(leavesBlock);
-                                    }
-                        }
-                    }
-                }
-                else // If we are not making a tree then just record its position
-                {
-                    // If below a certain threshold, put water instead of air
-                    if(y == World::waterLevel && BiomeConfiguration[biomeID].AllowWater) // Water level check
-                    {
-                        Block waterBlock;
-                        // Set our block's position with the correct chunk offset
-                        waterBlock.position = glm::vec3(x, y, z);
-                        waterBlock.blockTypeID = (BiomeConfiguration[biomeID].HotTemperature == true ? blocks["Water"]["index"] : blocks["Ice_Block"]["index"]);
-                        // Set our block
-                        SetBlock(waterBlock);
-                    }
-                    else
-                    {
-                        SetPosition(x, y, z);
-                    }
-                }
-            }
-        } // End of for loop for y
-        treeHeightIndex = 0;
+            __m128i height = _mm_loadu_si128((const __m128i *)(surfaceHeights + x + i * 4));
+            // Compares give -1 where they hold, so subtracting them counts how deep we are
+            __m128i ground = _mm_cmpgt_epi32(height, y);
+            __m128i groundLayer = _mm_sub_epi32(_mm_sub_epi32(surfaceLayer, _mm_cmpgt_epi32(_mm_sub_epi32(height, subsurfaceDepth), y)), _mm_cmpgt_epi32(_mm_sub_epi32(height, stoneDepth), y));
+            lanes[i] = _mm_or_si128(_mm_and_si128(ground, groundLayer), _mm_andnot_si128(ground, aboveGroundLayer));
+        }
+        // Narrow the 16 layers down to bytes and write them in one store
+        _mm_storeu_si128((__m128i *)(layers + x), _mm_packus_epi16(_mm_packs_epi32(lanes[0], lanes[1]), _mm_packs_epi32(lanes[2], lanes[3])));
+    }
+#endif
+
+    // Whatever is left over (or everything, without SSE2)
+    for(; x < count; x++)
+    {
+        GLint height = surfaceHeights[x];
+        layers[x] = (worldY < height ? Layer_Surface + (worldY < height - 1) + (worldY < height - 4) : aboveGround);
     }
 }
 
 
 
-void Chunk::DetermineAOTopFace(glm::vec3 position)
+void Chunk::GenerateBlocks(GLuint seed, GLint biomeTypeIDPosX, GLint biomeTypeIDPosZ, GLint biomeTypeIDNegX, GLint biomeTypeIDNegZ)
 {
-    /* Determine top face AO */
-    // If we are not on an x-axis chunk border
-    if(position.x != 0 && position.x < World::chunkWidthX - 1 && position.y < World::chunkHeightY - 1)
-    {
-        // Check if there is a block over and up 1 to the left
-        if(!IsTransparent(position.x + 1, position.y + 1, position.z) || IsFoliage(position.x + 1, position.y + 1, position.z))
-        {
-            Block tempBlock = GetBlock(position);
-            tempBlock.topFace.aoTopRight = true;
-            tempBlock.topFace.aoTopLeft = true;
-            SetBlock(tempBlock);
-        }
-        if(!IsTransparent(position.x - 1, position.y + 1, position.z) || IsFoliage(position.x - 1, position.y + 1, position.z))
-        {
-            Block tempBlock = GetBlock(position);
-            tempBlock.topFace.aoBottomLeft = true;
-            tempBlock.topFace.aoBottomRight = true;
-            SetBlock(tempBlock);
-        }
-    }
-    if(position.x == 0 && position.y < World::chunkHeightY - 1) // We are on a x axis chunk border
-    {
-        if(abs(chunk_position_x - 1) <= World::chunkDiameter) // Check out of chunk
-        {
-            // X Position of adjacent chunk, y Position, Z position, position of chunk, chunks pointer
-            if(!chunks_[glm::vec3(chunk_position_x - 1, chunk_position_y, chunk_position_z)]->IsTransparent(World::chunkWidthX-1, position.y+1, position.z) || chunks_[glm::vec3(chunk_position_x - 1, chunk_position_y, chunk_position_z)]->IsFoliage(World::chunkWidthX-1, position.y+1, position.z))
-            {
-                // We want to do ambient occlusion bottom left and bottom right
-                Block tempBlock = GetBlock(position);
-                tempBlock.topFace.aoBottomLeft = true;
-                tempBlock.topFace.aoBottomRight = true;
-                SetBlock(tempBlock);                                    
-            }
-            
-        }
-        // Check in the same chunk
-        if(!IsTransparent(position.x + 1, position.y + 1, position.z) || IsFoliage(position.x + 1, position.y + 1, position.z))
-        {
-            Block tempBlock = GetBlock(position);
-            tempBlock.topFace.aoTopLeft = true;
-            tempBlock.topFace.aoTopRight = true;
-            SetBlock(tempBlock);
-        }
-    }
-    if(position.x == World::chunkWidthX - 1 && position.y < World::chunkHeightY - 1) // We are on a x axis chunk border
-    {
-        if(abs(chunk_position_x + 1) <= World::chunkDiameter) // Check out of chunk
-        {
-            // X Position of adjacent chunk, y Position, Z position, position of chunk, chunks pointer
-            if(!chunks_[glm::vec3(chunk_position_x + 1, chunk_position_y, chunk_position_z)]->IsTransparent(0, position.y+1, position.z) || chunks_[glm::vec3(chunk_position_x + 1, chunk_position_y, chunk_position_z)]->IsFoliage(0, position.y+1, position.z))
-            {
-                // We want to do ambient occlusion bottom left and bottom right
-                Block tempBlock = GetBlock(position);
-                tempBlock.topFace.aoTopRight = true;
-                tempBlock.topFace.aoTopLeft = true;
-                SetBlock(tempBlock);
-            }
-        }
-        // Check in the same chunk
-        if(!IsTransparent(position.x - 1, position.y + 1, position.z) || IsFoliage(position.x - 1, position.y + 1, position.z))
-        {
-            Block tempBlock = GetBlock(position);
-            tempBlock.topFace.aoBottomLeft = true;
-            tempBlock.topFace.aoBottomRight = true;
-            SetBlock(tempBlock);
-        }
-    }
+    outgoingFeatureEdits.clear();
+    // Nothing in the chunk until we put it there
+    occupiedMinY = World::chunkHeightY;
+    occupiedMaxY = -1;
+    // Chunks above the highest the terrain and water can reach are all air, like we start out
+    if(offset_y >= heightMax && offset_y > World::waterLevel)
+        return;
 
-    // If we are not on a z-axis chunk border
-    if(position.z != 0 && position.z < World::chunkDepthZ - 1 && position.y < World::chunkHeightY - 1)
+    // Vector structure to hold our noise
+    std::vector<GLfloat> noiseOutput(World::chunkWidthX * World::chunkDepthZ);
+
+    GLint adjustedChunkPosX = chunk_position_x * (GLint)World::chunkWidthX;
+    GLint adjustedChunkPosZ = chunk_position_z * (GLint)World::chunkDepthZ;
+    // Generate a chunkWidthX x chunkDepthZ area of noise, using this thread's noise generator
+    TerrainGenerator::ForThisThread().GenerateHeightNoise(noiseOutput.data(), adjustedChunkPosX, adjustedChunkPosZ, BiomeConfiguration[biomeID].NoiseGain, BiomeConfiguration[biomeID].NoiseFrequency, seed);
+
+    // World y of the first air block above the ground in each column, where trees take root.
+    // Everything below it is ground. The lowest and highest of them bound the terrain in this chunk
+    GLint surfaceHeights[World::chunkWidthX * World::chunkDepthZ];
+    GLint lowestChunkSurface = World::heightLimit, highestChunkSurface = 0;
+    for(GLuint i = 0; i < World::chunkWidthX * World::chunkDepthZ; i++)
     {
-        // Check if there is a block over and up 1 to the left
-        if(!IsTransparent(position.x, position.y + 1, position.z - 1) || IsFoliage(position.x, position.y + 1, position.z - 1))
-        {
-            // We want to do ambient occlusion top left and bottom left
-            Block tempBlock = GetBlock(position);
-            tempBlock.topFace.aoTopLeft = true;
-            tempBlock.topFace.aoBottomLeft = true;
-            SetBlock(tempBlock);
-        }
-        if(!IsTransparent(position.x, position.y + 1, position.z + 1) || IsFoliage(position.x, position.y + 1, position.z + 1))
-        {
-            Block tempBlock = GetBlock(position);
-            tempBlock.topFace.aoTopRight = true;
-            tempBlock.topFace.aoBottomRight = true;
-            SetBlock(tempBlock);
-        }
+        surfaceHeights[i] = (GLint)(std::abs(noiseOutput[i]) * (heightMax - heightMin) + heightMin);
+        lowestChunkSurface = std::min(lowestChunkSurface, surfaceHeights[i]);
+        highestChunkSurface = std::max(highestChunkSurface, surfaceHeights[i]);
     }
-    if(position.z == 0 && position.y < World::chunkHeightY - 1) // We are on a z axis chunk border
+
+    // Look up the block types we place once, instead of per block
+    const GLint stoneBlockID = blockRegistry.GetID("Stone_Block");
+    const GLint waterBlockID = blockRegistry.GetID("Water");
+    const GLint iceBlockID = blockRegistry.GetID("Ice_Block");
+    const GLint liquidBlockID = (BiomeConfiguration[biomeID].HotTemperature == true ? waterBlockID : iceBlockID);
+    // Which block each terrain layer is, indexed by TerrainLayer
+    const GLint layerBlockTypes[Layer_Count] = { BlockRegistry::Air, liquidBlockID, BiomeConfiguration[biomeID].Surface_Block, BiomeConfiguration[biomeID].Subsurface_Block, stoneBlockID };
+
+    // Where the ground and the water in this chunk start and end, in chunk y
+    const GLint bottomY = (GLint)offset_y;
+    const GLboolean chunkHoldsWater = BiomeConfiguration[biomeID].AllowWater && (GLint)World::waterLevel >= bottomY && (GLint)World::waterLevel < bottomY + (GLint)World::chunkHeightY;
+    if(highestChunkSurface > bottomY)
     {
-        if(abs(chunk_position_z - 1) <= World::chunkDiameter) // Check out of chunk
-        {
-            if(position.x == 0 && abs(chunk_position_x - 1) <= World::chunkDiameter) // If we are on a x-axis chunk border along with our z-axis chunk border
-            {
-                if(!chunks_[glm::vec3(chunk_position_x - 1, chunk_position_y, chunk_position_z - 1)]->IsTransparent(World::chunkWidthX-1, position.y+1, World::chunkDepthZ-1) || chunks_[glm::vec3(chunk_position_x - 1, chunk_position_y, chunk_position_z - 1)]->IsFoliage(World::chunkWidthX-1, position.y+1, World::chunkDepthZ-1))
-                {
-                    // We want to do ambient occlusion bottom left and bottom right
-                    Block tempBlock = GetBlock(position);
-                    tempBlock.topFace.aoTopLeft = true;
-                    tempBlock.topFace.aoBottomLeft = true;
-                    SetBlock(tempBlock);                                    
-                }
-            }
-            else if(position.x == World::chunkWidthX - 1 && abs(chunk_position_x + 1) <= World::chunkDiameter) // If we are on a x-axis chunk border along with our z-axis chunk border
-            {
-                if(!chunks_[glm::vec3(chunk_position_x + 1, chunk_position_y, chunk_position_z - 1)]->IsTransparent(0, position.y+1, World::chunkDepthZ-1) || chunks_[glm::vec3(chunk_position_x + 1, chunk_position_y, chunk_position_z - 1)]->IsFoliage(0, position.y+1, World::chunkDepthZ-1))
-                {
-                    // We want to do ambient occlusion bottom left and bottom right
-                    Block tempBlock = GetBlock(position);
-                    tempBlock.topFace.aoTopLeft = true;
-                    tempBlock.topFace.aoBottomLeft = true;
-                    SetBlock(tempBlock);                                    
-                }
-            }
-            // X Position of adjacent chunk, y Position, Z position, position of chunk, chunks pointer
-            else if(!chunks_[glm::vec3(chunk_position_x, chunk_position_y, chunk_position_z - 1)]->IsTransparent(position.x, position.y+1, World::chunkDepthZ-1) || chunks_[glm::vec3(chunk_position_x, chunk_position_y, chunk_position_z - 1)]->IsFoliage(position.x, position.y+1, World::chunkDepthZ-1))
-            {
-                // We want to do ambient occlusion bottom left and bottom right
-                Block tempBlock = GetBlock(position);
-                tempBlock.topFace.aoTopLeft = true;
-                tempBlock.topFace.aoBottomLeft = true;
-                SetBlock(tempBlock);                                    
-            }
-        }
-        // Check in the same chunk
-        if(!IsTransparent(position.x, position.y + 1, position.z + 1) || IsFoliage(position.x, position.y + 1, position.z + 1))
-        {
-            Block tempBlock = GetBlock(position);
-            tempBlock.topFace.aoTopRight = true;
-            tempBlock.topFace.aoBottomRight = true;
-            SetBlock(tempBlock);
-        }
+        occupiedMinY = 0;
+        occupiedMaxY = std::min(highestChunkSurface - bottomY, (GLint)World::chunkHeightY) - 1;
     }
-    if(position.z == World::chunkDepthZ - 1 && position.y < World::chunkHeightY - 1)  // We are on a z axis chunk border
+    if(chunkHoldsWater && lowestChunkSurface <= (GLint)World::waterLevel)
     {
-        if(abs(chunk_position_z + 1) <= World::chunkDiameter) // Check out of chunk
-        {
-            if(position.x == 0 && abs(chunk_position_x - 1) <= World::chunkDiameter) // If we are on a x-axis chunk border along with our z-axis chunk border
-            {
-                if(!chunks_[glm::vec3(chunk_position_x - 1, chunk_position_y, chunk_position_z + 1)]->IsTransparent(World::chunkWidthX-1, position.y+1, 0) || chunks_[glm::vec3(chunk_position_x - 1, chunk_position_y, chunk_position_z + 1)]->IsFoliage(World::chunkWidthX-1, position.y+1, 0))
-                {
-                    // We want to do ambient occlusion bottom left and bottom right
-                    Block tempBlock = GetBlock(position);
-                    tempBlock.topFace.aoTopRight = true;
-                    tempBlock.topFace.aoBottomRight = true;
-                    SetBlock(tempBlock);                                    
-                }
-            }
-            else if(position.x == World::chunkWidthX - 1 && abs(chunk_position_x + 1) <= World::chunkDiameter) // If we are on a x-axis chunk border along with our z-axis chunk border
-            {
-                if(!chunks_[glm::vec3(chunk_position_x + 1, chunk_position_y, chunk_position_z + 1)]->IsTransparent(0, position.y+1, 0) || chunks_[glm::vec3(chunk_position_x + 1, chunk_position_y, chunk_position_z + 1)]->IsFoliage(0, position.y+1, 0))
-                {
-                    // We want to do ambient occlusion bottom left and bottom right
-                    Block tempBlock = GetBlock(position);
-                    tempBlock.topFace.aoTopRight = true;
-                    tempBlock.topFace.aoBottomRight = true;
-                    SetBlock(tempBlock);                                    
-                }
-            }
-            // X Position of adjacent chunk, y Position, Z position, position of chunk, chunks pointer
-            else if(!chunks_[glm::vec3(chunk_position_x, chunk_position_y, chunk_position_z + 1)]->IsTransparent(position.x, position.y+1, 0) || chunks_[glm::vec3(chunk_position_x, chunk_position_y, chunk_position_z + 1)]->IsFoliage(position.x, position.y+1, 0))
-            {
-                Block tempBlock = GetBlock(position);
-                tempBlock.topFace.aoTopRight = true;
-                tempBlock.topFace.aoBottomRight = true;
-                SetBlock(tempBlock);
-            }
-        }
-        // Check in the same chunk
-        if(!IsTransparent(position.x, position.y + 1, position.z - 1) || IsFoliage(position.x, position.y + 1, position.z - 1))
-        {
-            Block tempBlock = GetBlock(position);
-            tempBlock.topFace.aoTopLeft = true;
-            tempBlock.topFace.aoBottomLeft = true;
-            SetBlock(tempBlock);
-        }
+        occupiedMinY = std::min(occupiedMinY, (GLint)World::waterLevel - bottomY);
+        occupiedMaxY = std::max(occupiedMaxY, (GLint)World::waterLevel - bottomY);
     }
 
-    // For blocks up and diagonal not on chunk border
-    if(position.z != 0 && position.z < World::chunkDepthZ - 1 && position.x != 0 && position.x < World::chunkWidthX - 1 && position.y < World::chunkHeightY - 1)
-    {   
-        if(!IsTransparent(position.x + 1, position.y + 1, position.z - 1) || IsFoliage(position.x + 1, position.y + 1, position.z - 1))
-        {
-            Block tempBlock = GetBlock(position);
-            tempBlock.topFace.aoTopLeft = true;
-            SetBlock(tempBlock);
-        }
-        if(!IsTransparent(position.x + 1, position.y + 1, position.z + 1) || IsFoliage(position.x + 1, position.y + 1, position.z + 1))
-        {
-            Block tempBlock = GetBlock(position);
-            tempBlock.topFace.aoTopRight = true;
-            SetBlock(tempBlock);
-        }
-        if(!IsTransparent(position.x - 1, position.y + 1, position.z + 1) || IsFoliage(position.x - 1, position.y + 1, position.z + 1))
-        {
-            Block tempBlock = GetBlock(position);
-            tempBlock.topFace.aoBottomRight = true;
-            SetBlock(tempBlock);
-        }
-        if(!IsTransparent(position.x - 1, position.y + 1, position.z - 1) || IsFoliage(position.x - 1, position.y + 1, position.z - 1))
-        {
-            Block tempBlock = GetBlock(position);
-            tempBlock.topFace.aoBottomLeft = true;
-            SetBlock(tempBlock);
-        }
-    }
-    // For blocks up and diagonal on chunk border
-    // Z level checking in the negative z direction
-    if(position.z == 0 && position.y < World::chunkHeightY - 1)
-    {
-        if(abs(chunk_position_z - 1) <= World::chunkDiameter) // Check out of chunk
-        {
-            // I may need an additional check here because I am doing x+1 and x-1 as well.
-            // My gut feeling is this will segmentation fault across the x-axis if a block in the exact corner
-            // of a chunk needs AO, but will see in the future
-            if(position.x == World::chunkWidthX - 1 && abs(chunk_position_x + 1) <= World::chunkDiameter) // If we are on an x-axis chunk border as well
-            {
-                if(!chunks_[glm::vec3(chunk_position_x + 1, chunk_position_y, chunk_position_z - 1)]->IsTransparent(0, position.y+1, World::chunkDepthZ-1) || chunks_[glm::vec3(chunk_position_x + 1, chunk_position_y, chunk_position_z - 1)]->IsFoliage(0, position.y+1, World::chunkDepthZ-1))
-                {
-                    Block tempBlock = GetBlock(position);
-                    tempBlock.topFace.aoTopLeft = true;
-                    SetBlock(tempBlock);
-                }
-            }
-            else if(!chunks_[glm::vec3(chunk_position_x, chunk_position_y, chunk_position_z - 1)]->IsTransparent(position.x+1, position.y+1, World::chunkDepthZ-1) || chunks_[glm::vec3(chunk_position_x, chunk_position_y, chunk_position_z - 1)]->IsFoliage(position.x+1, position.y+1, World::chunkDepthZ-1))
-            {
-                Block tempBlock = GetBlock(position);
-                tempBlock.topFace.aoTopLeft = true;
-                SetBlock(tempBlock);
-            }
-            if(position.x == 0 && abs(chunk_position_x - 1) <= World::chunkDiameter) // If we are on an x-axis chunk border as well
-            {
-                if(!chunks_[glm::vec3(chunk_position_x - 1, chunk_position_y, chunk_position_z - 1)]->IsTransparent(World::chunkWidthX-1, position.y+1, World::chunkDepthZ-1) || chunks_[glm::vec3(chunk_position_x - 1, chunk_position_y, chunk_position_z - 1)]->IsFoliage(World::chunkWidthX-1, position.y+1, World::chunkDepthZ-1))
-                {
-                    Block tempBlock = GetBlock(position);
-                    tempBlock.topFace.aoBottomLeft = true;
-                    SetBlock(tempBlock);
-                }
-            }
-            else if(!chunks_[glm::vec3(chunk_position_x, chunk_position_y, chunk_position_z - 1)]->IsTransparent(position.x-1, position.y+1, World::chunkDepthZ-1) || chunks_[glm::vec3(chunk_position_x, chunk_position_y, chunk_position_z - 1)]->IsFoliage(position.x-1, position.y+1, World::chunkDepthZ-1))
-            {
-                Block tempBlock = GetBlock(position);
-                tempBlock.topFace.aoBottomLeft = true;
-                SetBlock(tempBlock);
-            }
-        }
-        // Check inside the chunk
-        if(position.x == World::chunkWidthX - 1 && abs(chunk_position_x + 1) <= World::chunkDiameter) // If we are on an x-axis chunk border as well 
-        {
-            if(!chunks_[glm::vec3(chunk_position_x + 1, chunk_position_y, chunk_position_z)]->IsTransparent(0, position.y+1, position.z+1) || chunks_[glm::vec3(chunk_position_x + 1, chunk_position_y, chunk_position_z)]->IsFoliage(0, position.y+1, position.z+1))
-            {
-                Block tempBlock = GetBlock(position);
-                tempBlock.topFace.aoTopRight = true;
-                SetBlock(tempBlock);
-            }
-        }
-        else if(!IsTransparent(position.x+1, position.y+1, position.z+1) || IsFoliage(position.x+1, position.y+1, position.z+1))
-        {
-            Block tempBlock = GetBlock(position);
-            tempBlock.topFace.aoTopRight = true;
-            SetBlock(tempBlock);
-        }
-        if(position.x == 0 && abs(chunk_position_x - 1) <= World::chunkDiameter) // If we are on an x-axis chunk border as well 
-        {
-            if(!chunks_[glm::vec3(chunk_position_x - 1, chunk_position_y, chunk_position_z)]->IsTransparent(World::chunkWidthX-1, position.y+1, position.z+1) || chunks_[glm::vec3(chunk_position_x - 1, chunk_position_y, chunk_position_z)]->IsFoliage(World::chunkWidthX-1, position.y+1, position.z+1))
-            {
-                Block tempBlock = GetBlock(position);
-                tempBlock.topFace.aoBottomRight = true;
-                SetBlock(tempBlock);
-            }
-        }
-        else if(!IsTransparent(position.x-1, position.y+1, position.z+1) || IsFoliage(position.x-1, position.y+1, position.z+1))
-        {
-            Block tempBlock = GetBlock(position);
-            tempBlock.topFace.aoBottomRight = true;
-            SetBlock(tempBlock);
-        }
-    }
-    // For blocks up and diagonal on chunk border
-    // Z level checking in the positive z direction
-    if(position.z == World::chunkDepthZ - 1 && position.y < World::chunkHeightY - 1)
+    // Fill the chunk a storage section at a time. Sections entirely above the ground
+    // and the water stay air, and sections entirely below the dirt are filled with
+    // stone in one go, so the tall stacks of chunks in a column cost next to nothing.
+    // The rest are filled a row of blocks at a time into a layer per block, and packed in one go
+    const GLint sectionSize = World::blockSectionSize;
+    GLubyte sectionLayers[BlockSection::volume];
+    for(GLint sectionY = 0; sectionY < (GLint)World::chunkHeightY; sectionY += sectionSize)
+    for(GLint sectionZ = 0; sectionZ < (GLint)World::chunkDepthZ;  sectionZ += sectionSize)
+    for(GLint sectionX = 0; sectionX < (GLint)World::chunkWidthX;  sectionX += sectionSize)
     {
-        if(abs(chunk_position_z + 1) <= World::chunkDiameter) // Check out of chunk
+        GLint lowestSurface = surfaceHeights[sectionX + sectionZ * World::chunkWidthX], highestSurface = lowestSurface;
+        for(GLint z = sectionZ; z < sectionZ + sectionSize; z++)
+        for(GLint x = sectionX; x < sectionX + sectionSize; x++)
         {
-            // I may need an additional check here because I am doing x+1 and x-1 as well.
-            // My gut feeling is this will segmentation fault across the x-axis if a block in the exact corner
-            // of a chunk needs AO, but will see in the future
-            if(position.x == World::chunkWidthX-1 && abs(chunk_position_x + 1) <= World::chunkDiameter) // If we are on an x-axis chunk border as well 
-            {
-                if(!chunks_[glm::vec3(chunk_position_x + 1, chunk_position_y, chunk_position_z + 1)]->IsTransparent(0, position.y+1, 0) || chunks_[glm::vec3(chunk_position_x + 1, chunk_position_y, chunk_position_z + 1)]->IsFoliage(0, position.y+1, 0))
-                {
-                    Block tempBlock = GetBlock(position);
-                    tempBlock.topFace.aoTopRight = true;
-                    SetBlock(tempBlock);
-                }
-            }
-            else if(!chunks_[glm::vec3(chunk_position_x, chunk_position_y, chunk_position_z + 1)]->IsTransparent(position.x+1, position.y+1, 0) || chunks_[glm::vec3(chunk_position_x, chunk_position_y, chunk_position_z + 1)]->IsFoliage(position.x+1, position.y+1, 0))
-            {
-                Block tempBlock = GetBlock(position);
-                tempBlock.topFace.aoTopRight = true;
-                SetBlock(tempBlock);
-            }
-            if(position.x == 0 && abs(chunk_position_x - 1) <= World::chunkDiameter) // If we are on an x-axis chunk border as well 
-            {
-                if(!chunks_[glm::vec3(chunk_position_x - 1, chunk_position_y, chunk_position_z + 1)]->IsTransparent(World::chunkWidthX-1, position.y+1, 0) || chunks_[glm::vec3(chunk_position_x - 1, chunk_position_y, chunk_position_z + 1)]->IsFoliage(World::chunkWidthX-1, position.y+1, 0))
-                {
-                    Block tempBlock = GetBlock(position);
-                    tempBlock.topFace.aoBottomRight = true;
-                    SetBlock(tempBlock);
-                }
-            }
-            else if(!chunks_[glm::vec3(chunk_position_x, chunk_position_y, chunk_position_z + 1)]->IsTransparent(position.x-1, position.y+1, 0) || chunks_[glm::vec3(chunk_position_x, chunk_position_y, chunk_position_z + 1)]->IsFoliage(position.x-1, position.y+1, 0))
-            {
-                Block tempBlock = GetBlock(position);
-                tempBlock.topFace.aoBottomRight = true;
-                SetBlock(tempBlock);
-            }
+            lowestSurface = std::min(lowestSurface, surfaceHeights[x + z * World::chunkWidthX]);
+            highestSurface = std::max(highestSurface, surfaceHeights[x + z * World::chunkWidthX]);
         }
-        // Check inside the chunk
-        if(position.x == World::chunkWidthX-1 && abs(chunk_position_x + 1) <= World::chunkDiameter) // If we are on an x-axis chunk border as well 
+        GLint sectionBottomY = bottomY + sectionY;
+        GLint sectionTopY = sectionBottomY + sectionSize; // First y above the section
+        GLboolean holdsWater = BiomeConfiguration[biomeID].AllowWater && (GLint)World::waterLevel >= sectionBottomY && (GLint)World::waterLevel < sectionTopY;
+        if(sectionBottomY >= highestSurface && !holdsWater)
+            continue;
+        if(sectionTopY <= lowestSurface - 4)
         {
-            if(!chunks_[glm::vec3(chunk_position_x + 1, chunk_position_y, chunk_position_z)]->IsTransparent(0, position.y+1, position.x-1) || chunks_[glm::vec3(chunk_position_x + 1, chunk_position_y, chunk_position_z)]->IsFoliage(0, position.y+1, position.z-1))
-            {
-                Block tempBlock = GetBlock(position);
-                tempBlock.topFace.aoTopLeft = true;
-                SetBlock(tempBlock);
-            }
+            chunkBlocks.GetSection(BlockStorage::SectionIndex(sectionX, sectionY, sectionZ)).Fill(stoneBlockID);
+            continue;
         }
-        else if(!IsTransparent(position.x + 1, position.y + 1, position.z - 1) || IsFoliage(position.x + 1, position.y + 1, position.z - 1))
-        {
-            Block tempBlock = GetBlock(position);
-            tempBlock.topFace.aoTopLeft = true;
-            SetBlock(tempBlock);
-        }
-        if(position.x == 0 && abs(chunk_position_x - 1) <= World::chunkDiameter) // If we are on an x-axis chunk border as well 
-        {
-            if(!chunks_[glm::vec3(chunk_position_x - 1, chunk_position_y, chunk_position_z)]->IsTransparent(World::chunkWidthX-1, position.y+1, position.z-1) || chunks_[glm::vec3(chunk_position_x - 1, chunk_position_y, chunk_position_z)]->IsFoliage(World::chunkWidthX-1, position.y+1, position.z-1))
-            {
-                Block tempBlock = GetBlock(position);
-                tempBlock.topFace.aoBottomLeft = true;
-                SetBlock(tempBlock);
-            }
-        }
-        else if(!IsTransparent(position.x - 1, position.y + 1, position.z - 1) || IsFoliage(position.x - 1, position.y + 1, position.z - 1))
-        {
-            Block tempBlock = GetBlock(position);
-            tempBlock.topFace.aoBottomLeft = true;
-            SetBlock(tempBlock);
-        }
-    }
-    // For blocks up and diagonal on chunk border
-    // X level checking in the negative X direction
-
-    // For blocks up and diagonal on chunk border
-    // X level checking in the positive X direction
-}
-
 
-
-void Chunk::DetermineAOFrontFace(glm::vec3 position)
-{
-    // If we are not on a z-axis chunk border
-    if(position.z < World::chunkDepthZ - 1 && position.y != 0)
-    {
-        if((!IsTransparent(position.x, position.y - 1, position.z + 1) || IsFoliage(position.x, position.y - 1, position.z + 1)))
+        // Section blocks go x first, then z, then y, so each row along x is one run of bytes
+        for(GLint y = 0; y < sectionSize; y++)
         {
-            Block tempBlock = GetBlock(position);
-            tempBlock.frontFace.aoBottomLeft = true;
-            tempBlock.frontFace.aoBottomRight = true;
-            SetBlock(tempBlock);
+            GLint worldY = sectionBottomY + y;
+            GLubyte aboveGround = (holdsWater && worldY == (GLint)World::waterLevel ? Layer_Liquid : Layer_Air);
+            for(GLint z = 0; z < sectionSize; z++)
+                FillTerrainRow(sectionLayers + (z + y * sectionSize) * sectionSize, surfaceHeights + sectionX + (sectionZ + z) * World::chunkWidthX, sectionSize, worldY, aboveGround);
         }
+        chunkBlocks.GetSection(BlockStorage::SectionIndex(sectionX, sectionY, sectionZ)).Assign(layerBlockTypes, Layer_Count, sectionLayers);
     }
-    else if(position.z == World::chunkDepthZ - 1 && position.y != 0) // We are on a z-axis chunk border
-    {
-        if(abs(chunk_position_z + 1) <= World::chunkDiameter) 
-        {
-            // X Position of adjacent chunk, y Position, Z position, position of chunk, chunks pointer
-            if(!chunks_[glm::vec3(chunk_position_x, chunk_position_y, chunk_position_z + 1)]->IsTransparent(position.x, position.y-1, 0) || chunks_[glm::vec3(chunk_position_x, chunk_position_y, chunk_position_z + 1)]->IsFoliage(position.x, position.y-1, 0))
-            {
-                // We want to do ambient occlusion top left and bottom left
-                Block tempBlock = GetBlock(position);
-                tempBlock.frontFace.aoBottomLeft = true;
-                tempBlock.frontFace.aoBottomRight = true;
-                SetBlock(tempBlock);
-            }
-        }
-    } 
+
+    // Trees go in once the ground is down. Parts of trees that reach into our
+    // neighbours are kept for the chunk manager to hand over
+    FeaturePlacer::PlaceTrees(*this, seed, surfaceHeights, outgoingFeatureEdits);
 }
 
 
 
-void Chunk::DetermineAOBackFace(glm::vec3 position)
+SavedChunk Chunk::Save() const
 {
-    // If we are not on a z-axis chunk border
-    if(position.z != 0 && position.y != 0)
-    {
-        if((!IsTransparent(position.x, position.y - 1, position.z - 1) || IsFoliage(position.x, position.y - 1, position.z - 1)))
-        {
-            // We want to do ambient occlusion top left and bottom left
-            Block tempBlock = GetBlock(position);
-            tempBlock.backFace.aoBottomLeft = true;
-            tempBlock.backFace.aoBottomRight = true;
-            SetBlock(tempBlock);
-        }
-    }
-    else if(position.z == 0 && position.y != 0) // We are on a z-axis chunk border
-    {
-        if(abs(chunk_position_z - 1) <= World::chunkDiameter)
-        {
-            if(!chunks_[glm::vec3(chunk_position_x, chunk_position_y, chunk_position_z - 1)]->IsTransparent(position.x, position.y-1, World::chunkDepthZ-1) || chunks_[glm::vec3(chunk_position_x, chunk_position_y, chunk_position_z - 1)]->IsFoliage(position.x, position.y-1, World::chunkDepthZ-1))
-            {                                        
-                // We want to do ambient occlusion top left and bottom left
-                Block tempBlock = GetBlock(position);
-                tempBlock.backFace.aoBottomLeft = true;
-                tempBlock.backFace.aoBottomRight = true;
-                SetBlock(tempBlock);
-            }
-        }
-    } 
+    SavedChunk saved;
+    saved.blocks = chunkBlocks;
+    saved.outgoingFeatureEdits = outgoingFeatureEdits;
+    saved.appliedFeatureNeighbours = appliedFeatureNeighbours;
+    return saved;
 }
 
 
 
-void Chunk::DetermineAOLeftFace(glm::vec3 position)
+void Chunk::Load(SavedChunk &&saved)
 {
-    // If we are not on an x-axis chunk border
-    if(position.x != 0 && position.y != 0)
-    {
-        // Check if there is a block over and up 1 to the left
-        if((!IsTransparent(position.x - 1, position.y - 1, position.z) || IsFoliage(position.x - 1, position.y - 1, position.z)))
-        {
-            // We want to do ambient occlusion bottom left and bottom right   
-            Block tempBlock = GetBlock(position);
-            tempBlock.leftFace.aoBottomLeft = true;
-            tempBlock.leftFace.aoBottomRight = true;
-            SetBlock(tempBlock);
-        }
-    }
-    else if(position.x == 0 && position.y != 0) // We are on a x-axis chunk border
-    {
-        if(abs(chunk_position_x - 1) <= World::chunkDiameter)
-        {
-            // X Position of adjacent chunk, y Position, Z position, position of chunk, chunks pointer
-            if(!chunks_[glm::vec3(chunk_position_x - 1, chunk_position_y, chunk_position_z)]->IsTransparent(World::chunkWidthX-1, position.y-1, position.z) || chunks_[glm::vec3(chunk_position_x - 1, chunk_position_y, chunk_position_z)]->IsFoliage(World::chunkWidthX-1, position.y-1, position.z))
-            {
-                // We want to do ambient occlusion bottom left and bottom right
-                Block tempBlock = GetBlock(position);
-                tempBlock.leftFace.aoBottomLeft = true;
-                tempBlock.leftFace.aoBottomRight = true;
-                SetBlock(tempBlock);                                    
-            }
-        }
-    } 
+    chunkBlocks = std::move(saved.blocks);
+    outgoingFeatureEdits = std::move(saved.outgoingFeatureEdits);
+    appliedFeatureNeighbours = saved.appliedFeatureNeighbours;
 }
 
 
 
-void Chunk::DetermineAORightFace(glm::vec3 position)
+ChunkSnapshot Chunk::TakeSnapshot(GLuint slabMask)
 {
-    // If we are not on an x-axis chunk border
-    if(position.x < World::chunkWidthX - 1 && position.y != 0)
-    {
-        if((!IsTransparent(position.x + 1, position.y - 1, position.z) || IsFoliage(position.x + 1, position.y - 1, position.z)))
-        {
-            // We want to do ambient occlusion top left and bottom left
-            Block tempBlock = GetBlock(position);
-            tempBlock.rightFace.aoBottomLeft = true;
-            tempBlock.rightFace.aoBottomRight = true;
-            SetBlock(tempBlock);
-        }
-    }
-    else if(position.x == World::chunkWidthX - 1 && position.y != 0) // We are on a x-axis chunk border
-    {
-        if(abs(chunk_position_x + 1) <= World::chunkDiameter) 
-        {
-            // X Position of adjacent chunk, y Position, Z position, position of chunk, chunks pointer
-            if(!chunks_[glm::vec3(chunk_position_x + 1, chunk_position_y, chunk_position_z)]->IsTransparent(0, position.y-1, position.z) || chunks_[glm::vec3(chunk_position_x + 1, chunk_position_y, chunk_position_z)]->IsFoliage(0, position.y-1, position.z))
-            {
-                // We want to do ambient occlusion bottom left and bottom right
-                Block tempBlock = GetBlock(position);
-                tempBlock.rightFace.aoBottomLeft = true;
-                tempBlock.rightFace.aoBottomRight = true;
-                SetBlock(tempBlock);
-            }
-        }
-    } 
+    ChunkSnapshot snapshot;
+    TakeSnapshot(snapshot, slabMask);
+    return snapshot;
 }
 
 
 
-// Draw an individual face
-void Chunk::DrawFace(Block block, GLuint faceIndex)
+void Chunk::TakeSnapshot(ChunkSnapshot &snapshot, GLuint slabMask)
 {
-    GLuint posX = block.position.x;     // 6 Bits, 0-63
-    GLuint posY = block.position.y;     // 6 Bits, 0-63
-    GLuint posZ = block.position.z;     // 6 Bits, 0-63
-    GLuint faceID = faceIndex;          // 3 Bits, 0-7
-    // VertexID                         // 3 Bits, 0-7
-    GLuint textureID = block.blockTypeID; // 5 Bits, 0-31
-    // Ambient Occlusion Enabled        // 1 Bit,  0-1
-
-    GLuint packedVertexOne;
-    GLuint packedVertexTwo;
-    GLuint packedVertexThree;
-    GLuint packedVertexFour;
-    GLuint packedVertexFive;
-    GLuint packedVertexSix;
-    
-    // Pack our data up
-    switch(faceIndex) // Ambient Occlusion data is different per vertex depending on the face, hence a switch
+    // Meshing a slab reads one block past it, which only leaves the chunk at the top and bottom slabs
+    GLint lowY = (slabMask & 1 ? -1 : 0);
+    GLint highY = (slabMask & (1u << (World::meshSlabCount - 1)) ? 1 : 0);
+    // The air above the top of the world, shared by every snapshot that needs it
+    static const BlockStorage sky;
+    snapshot.Clear();
+    for(GLint dz = -1; dz <= 1; dz++)
+    for(GLint dy = lowY; dy <= highY; dy++)
+    for(GLint dx = -1; dx <= 1; dx++)
     {
-        case BlockFaces::Top_Face:
-            if(World::ambientOcclusionEnabled)
-            {
-                // Reset ambient occlusion fields in case we are breaking a block and need
-                // to recalculate them          
-                block.topFace.aoTopLeft = false;
-                block.topFace.aoTopRight = false;
-                block.topFace.aoBottomLeft = false;
-                block.topFace.aoBottomRight = false;
-                SetBlock(block);
-                // Determine ambient occlusion for this block
-                DetermineAOTopFace(block.position);
-                block = GetBlock(block.position);
-            }
-            packedVertexOne   = (posX | posY << 6 | posZ << 12 | faceID << 18 | 0 << 21 | textureID << 24 | block.topFace.aoBottomLeft << 29); 
-            packedVertexTwo   = (posX | posY << 6 | posZ << 12 | faceID << 18 | 1 << 21 | textureID << 24 | block.topFace.aoTopRight << 29);
-            packedVertexThree = (posX | posY << 6 | posZ << 12 | faceID << 18 | 2 << 21 | textureID << 24 | block.topFace.aoTopLeft << 29); 
-            packedVertexFour  = (posX | posY << 6 | posZ << 12 | faceID << 18 | 3 << 21 | textureID << 24 | block.topFace.aoTopRight << 29);
-            packedVertexFive  = (posX | posY << 6 | posZ << 12 | faceID << 18 | 4 << 21 | textureID << 24 | block.topFace.aoBottomLeft << 29); 
-            packedVertexSix   = (posX | posY << 6 | posZ << 12 | faceID << 18 | 5 << 21 | textureID << 24 | block.topFace.aoBottomRight << 29);
-            break;
-        case BlockFaces::Front_Face:
-            if(World::ambientOcclusionEnabled)
-            {
-                // Reset ambient occlusion fields in case we are breaking a block and need
-                // to recalculate them          
-                block.frontFace.aoTopLeft = false;
-                block.frontFace.aoTopRight = false;
-                block.frontFace.aoBottomLeft = false;
-                block.frontFace.aoBottomRight = false;
-                SetBlock(block);
-                // Determine ambient occlusion for this block
-                DetermineAOFrontFace(block.position);
-                block = GetBlock(block.position);
-            }
-            packedVertexOne   = (posX | posY << 6 | posZ << 12 | faceID << 18 | 0 << 21 | textureID << 24 | block.frontFace.aoBottomLeft << 29); 
-            packedVertexTwo   = (posX | posY << 6 | posZ << 12 | faceID << 18 | 1 << 21 | textureID << 24 | 0 << 29);
-            packedVertexThree = (posX | posY << 6 | posZ << 12 | faceID << 18 | 2 << 21 | textureID << 24 | 0 << 29); 
-            packedVertexFour  = (posX | posY << 6 | posZ << 12 | faceID << 18 | 3 << 21 | textureID << 24 | 0 << 29);
-            packedVertexFive  = (posX | posY << 6 | posZ << 12 | faceID << 18 | 4 << 21 | textureID << 24 | block.frontFace.aoBottomLeft << 29); 
-            packedVertexSix   = (posX | posY << 6 | posZ << 12 | faceID << 18 | 5 << 21 | textureID << 24 | block.frontFace.aoBottomRight << 29);
-            break;
-        case BlockFaces::Back_Face:
-            if(World::ambientOcclusionEnabled)
-            {
-                // Reset ambient occlusion fields in case we are breaking a block and need
-                // to recalculate them          
-                block.backFace.aoTopLeft = false;
-                block.backFace.aoTopRight = false;
-                block.backFace.aoBottomLeft = false;
-                block.backFace.aoBottomRight = false;
-                SetBlock(block);
-                // Determine ambient occlusion for this block
-                DetermineAOBackFace(block.position);
-                block = GetBlock(block.position);
-            }
-            packedVertexOne   = (posX | posY << 6 | posZ << 12 | faceID << 18 | 0 << 21 | textureID << 24 | block.backFace.aoBottomRight << 29); 
-            packedVertexTwo   = (posX | posY << 6 | posZ << 12 | faceID << 18 | 1 << 21 | textureID << 24 | 0 << 29);
-            packedVertexThree = (posX | posY << 6 | posZ << 12 | faceID << 18 | 2 << 21 | textureID << 24 | block.backFace.aoBottomLeft << 29); 
-            packedVertexFour  = (posX | posY << 6 | posZ << 12 | faceID << 18 | 3 << 21 | textureID << 24 | 0 << 29);
-            packedVertexFive  = (posX | posY << 6 | posZ << 12 | faceID << 18 | 4 << 21 | textureID << 24 | block.backFace.aoBottomRight << 29); 
-            packedVertexSix   = (posX | posY << 6 | posZ << 12 | faceID << 18 | 5 << 21 | textureID << 24 | 0 << 29);
-            break;
-        case BlockFaces::Left_Face:
-            if(World::ambientOcclusionEnabled)
-            {
-                // Reset ambient occlusion fields in case we are breaking a block and need
-                // to recalculate them          
-                block.leftFace.aoTopLeft = false;
-                block.leftFace.aoTopRight = false;
-                block.leftFace.aoBottomLeft = false;
-                block.leftFace.aoBottomRight = false;
-                SetBlock(block);
-                // Determine ambient occlusion for this block
-                DetermineAOLeftFace(block.position);
-                block = GetBlock(block.position);
-            }
-            packedVertexOne   = (posX | posY << 6 | posZ << 12 | faceID << 18 | 0 << 21 | textureID << 24 | 0 << 29); 
-            packedVertexTwo   = (posX | posY << 6 | posZ << 12 | faceID << 18 | 1 << 21 | textureID << 24 | block.leftFace.aoBottomLeft << 29); 
-            packedVertexThree = (posX | posY << 6 | posZ << 12 | faceID << 18 | 2 << 21 | textureID << 24 | block.leftFace.aoBottomRight << 29); 
-            packedVertexFour  = (posX | posY << 6 | posZ << 12 | faceID << 18 | 3 << 21 | textureID << 24 | block.leftFace.aoBottomLeft << 29); 
-            packedVertexFive  = (posX | posY << 6 | posZ << 12 | faceID << 18 | 4 << 21 | textureID << 24 | 0 << 29); 
-            packedVertexSix   = (posX | posY << 6 | posZ << 12 | faceID << 18 | 5 << 21 | textureID << 24 | 0 << 29); 
-            break;
-        case BlockFaces::Right_Face:
-            if(World::ambientOcclusionEnabled)
-            {
-                // Reset ambient occlusion fields in case we are breaking a block and need
-                // to recalculate them          
-                block.rightFace.aoTopLeft = false;
-                block.rightFace.aoTopRight = false;
-                block.rightFace.aoBottomLeft = false;
-                block.rightFace.aoBottomRight = false;
-                SetBlock(block);
-                // Determine ambient occlusion for this block
-                DetermineAORightFace(block.position);
-                block = GetBlock(block.position);
-            }
-            packedVertexOne   = (posX | posY << 6 | posZ << 12 | faceID << 18 | 0 << 21 | textureID << 24 | 0 << 29); 
-            packedVertexTwo   = (posX | posY << 6 | posZ << 12 | faceID << 18 | 1 << 21 | textureID << 24 | block.rightFace.aoBottomRight << 29);
-            packedVertexThree = (posX | posY << 6 | posZ << 12 | faceID << 18 | 2 << 21 | textureID << 24 | 0 << 29); 
-            packedVertexFour  = (posX | posY << 6 | posZ << 12 | faceID << 18 | 3 << 21 | textureID << 24 | block.rightFace.aoBottomRight << 29);
-            packedVertexFive  = (posX | posY << 6 | posZ << 12 | faceID << 18 | 4 << 21 | textureID << 24 | 0 << 29); 
-            packedVertexSix   = (posX | posY << 6 | posZ << 12 | faceID << 18 | 5 << 21 | textureID << 24 | block.rightFace.aoBottomLeft << 29);
-            break;
-        default:
-            packedVertexOne   = (posX | posY << 6 | posZ << 12 | faceID << 18 | 0 << 21 | textureID << 24 | 0 << 29);
-            packedVertexTwo   = (posX | posY << 6 | posZ << 12 | faceID << 18 | 1 << 21 | textureID << 24 | 0 << 29);
-            packedVertexThree = (posX | posY << 6 | posZ << 12 | faceID << 18 | 2 << 21 | textureID << 24 | 0 << 29); 
-            packedVertexFour  = (posX | posY << 6 | posZ << 12 | faceID << 18 | 3 << 21 | textureID << 24 | 0 << 29);
-            packedVertexFive  = (posX | posY << 6 | posZ << 12 | faceID << 18 | 4 << 21 | textureID << 24 | 0 << 29); 
-            packedVertexSix   = (posX | posY << 6 | posZ << 12 | faceID << 18 | 5 << 21 | textureID << 24 | 0 << 29);
-            break;
+        Chunk *neighbour = neighbours[NeighbourIndex(dx, dy, dz)];
+        if(neighbour != nullptr && neighbour->generated)
+            snapshot.SetChunk(dx, dy, dz, neighbour->chunkBlocks);
+        // Above the top of the world is open sky, so faces there still get drawn
+        else if(chunk_position_y + dy >= (GLint)World::chunksTall)
+            snapshot.SetChunk(dx, dy, dz, sky);
     }
 
-    if(IsTransparent(block.position)) // Our block is transparent
-    { 
-        chunkTransparentVertices.push_back(packedVertexOne);
-        chunkTransparentVertices.push_back(packedVertexTwo);
-        chunkTransparentVertices.push_back(packedVertexThree);
-        chunkTransparentVertices.push_back(packedVertexFour);
-        chunkTransparentVertices.push_back(packedVertexFive);
-        chunkTransparentVertices.push_back(packedVertexSix); 
-    }
-    else // Our block is not transparent
+    // The light our faces look into, ours and the layer of each neighbour against our sides
+    static const LightStorage skyLight(LightStorage::Pack(LightStorage::maxLevel, 0));
+    static const GLint faceOffsets[6][3] = { {0, 0, -1}, {0, 0, 1}, {-1, 0, 0}, {1, 0, 0}, {0, 1, 0}, {0, -1, 0} };
+    snapshot.SetLight(light);
+    for(GLuint faceIndex = 0; faceIndex < 6; faceIndex++)
     {
-        chunkOpaqueVertices.push_back(packedVertexOne);
-        chunkOpaqueVertices.push_back(packedVertexTwo);
-        chunkOpaqueVertices.push_back(packedVertexThree);
-        chunkOpaqueVertices.push_back(packedVertexFour);
-        chunkOpaqueVertices.push_back(packedVertexFive);
-        chunkOpaqueVertices.push_back(packedVertexSix);
+        Chunk *neighbour = neighbours[NeighbourIndex(faceOffsets[faceIndex][0], faceOffsets[faceIndex][1], faceOffsets[faceIndex][2])];
+        if(neighbour != nullptr && neighbour->lit)
+            snapshot.SetBorderLight(faceIndex, neighbour->light);
+        else if(chunk_position_y + faceOffsets[faceIndex][1] >= (GLint)World::chunksTall)
+            snapshot.SetBorderLight(faceIndex, skyLight);
     }
 }
 
 
 
-void Chunk::RenderMesh()
+void Chunk::RebuildMesh()
 {
-    for(GLfloat z = 0; z < World::chunkDepthZ;  z += 1)
-    for(GLfloat x = 0; x < World::chunkWidthX;  x += 1)
-    for(GLfloat y = 0; y < World::chunkHeightY; y += 1)            
-    { 
-        // If this isn't an air block
-        if(GetBlock(x, y, z).blockTypeID != blocks["Air"]["index"])
-        {
-            // The block we are currently testing to see if we render its faces
-            Block block = GetBlock(x, y, z); 
-
-            // If any given face for a block has an adjacent air block,
-            // we will want to render that block. These if statements 
-            // do all of that adjacent air block checking. The else conditions
-            // are for checking blocks that are on chunk borders
-
-            /* Y axis checking for neighbouring air blocks */
-            if(y < World::chunkHeightY - 1)
-            {
-                // std::cout << "Check: " << IsTransparent(x, y+1, z) << std::endl;
-                if(IsTransparent(x, y+1, z)) // This is a surface block
-                {
-                    // Draw Top Face of this block
-                    DrawFace(block, BlockFaces::Top_Face);
-                }
-            }
-            else // if y == World::chunkHeightY - 1, on chunk border
-            {
-                if(chunk_position_y + 1 < World::chunksTall) 
-                {
-                    // X Position of adjacent chunk, y Position, Z position, position of chunk, chunks pointer
-                    if(chunks_[glm::vec3(chunk_position_x, chunk_position_y + 1, chunk_position_z)]->IsTransparent(x, 0, z)) 
-                    {
-                        // Draw Top Face of this block
-                        DrawFace(block, BlockFaces::Top_Face);
-                    }
-                }
-            }
-            
-            // Checking for y level
-            if(y != 0)
-            {
-                if(IsTransparent(x, y-1, z))
-                {
-                    // Draw Bottom Face of this block
-                    DrawFace(block, BlockFaces::Bottom_Face);
-                }
-            }
-            else // if y == 0, on chunk border
-            {
-                if(chunk_position_y - 1 >= 0)
-                {
-                    // X Position of adjacent chunk, y Position, Z position, position of chunk, chunks pointer
-                    if(chunks_[glm::vec3(chunk_position_x, chunk_position_y - 1, chunk_position_z)]->IsTransparent(x, World::chunkHeightY - 1, z))
-                    {                                    
-                        // Draw Bottom Face of this block
-                        DrawFace(block, BlockFaces::Bottom_Face);
-                    }
-                }
-            }
-
-            // Only do x and z faces if this block is not transparent unless its foliage
-            if(!IsTransparent(x, y, z) || IsFoliage(x, y, z))
-            {
-                // X axis checking for neighbouring air blocks //   
-                // If its != 0, its not on a chunk border
-                if(x != 0)
-                {
-                    if(IsTransparent(x-1, y, z))
-                    {
-                        // Draw Left Face of this block
-                        DrawFace(block, BlockFaces::Left_Face);
-                    }
-                }
-                else // if x == 0, on chunk border
-                {
-                    if(abs(chunk_position_x - 1) <= World::chunkDiameter)
-                    {
-                        // X Position of adjacent chunk, y Position, Z position, position of chunk, chunks pointer
-                        if(chunks_[glm::vec3(chunk_position_x - 1, chunk_position_y, chunk_position_z)]->IsTransparent(World::chunkWidthX-1, y, z))
-                        {                                    
-                            // Draw Left Face of this block
-                            DrawFace(block, BlockFaces::Left_Face);
-                        }
-                    }
-                }
-
-                // If its not at the chunk's max position, its not on a chunk border
-                if(x < World::chunkWidthX - 1)
-                {
-                    if(IsTransparent(x+1, y, z))
-                    {
-                        // Draw Right Face of this block
-                        DrawFace(block, BlockFaces::Right_Face);
-                    }
-                }
-                else // if x == World::chunkWidthX - 1, on chunk border
-                {
-                    if(abs(chunk_position_x + 1) <= World::chunkDiameter) 
-                    {
-                        // X Position of adjacent chunk, y Position, Z position, position of chunk, chunks pointer
-                        if(chunks_[glm::vec3(chunk_position_x + 1, chunk_position_y, chunk_position_z)]->IsTransparent(0, y, z))
-                        {
-                            // Draw Right Face of this block
-                            DrawFace(block, BlockFaces::Right_Face);
-                        }
-                    }
-                }
-
-                // Z axis checking for neighbouring air blocks //
-                // If its != 0, its not on a chunk border
-                if(z != 0)
-                {
-                    if(IsTransparent(x, y, z-1))
-                    {
-                        // Draw Back Face of this block
-                        DrawFace(block, BlockFaces::Back_Face);
-                    }
-                }
-                else // if z == 0, on chunk border
-                {
-                    if(abs(chunk_position_z - 1) <= World::chunkDiameter)
-                    {
-                        if(chunks_[glm::vec3(chunk_position_x, chunk_position_y, chunk_position_z - 1)]->IsTransparent(x, y, World::chunkDepthZ-1))
-                        {                                        
-                            // Draw Back Face of this block
-                            DrawFace(block, BlockFaces::Back_Face);
-                        }
-                    }
-                }
-                
-                // If its not at the chunk's max position, its not on a chunk border
-                if(z < World::chunkDepthZ - 1)
-                {
-                    if(IsTransparent(x, y, z+1))
-                    {
-                        // Draw Front Face of this block
-                        DrawFace(block, BlockFaces::Front_Face);
-                    }
-                }
-                else // if z == World::chunkDepthZ - 1, on chunk border
-                {
-                    if(abs(chunk_position_z + 1) <= World::chunkDiameter) 
-                    {
-                        // X Position of adjacent chunk, y Position, Z position, position of chunk, chunks pointer
-                        if(chunks_[glm::vec3(chunk_position_x, chunk_position_y, chunk_position_z + 1)]->IsTransparent(x, y, 0))
-                        {
-                            // Draw Front Face of this block
-                            DrawFace(block, BlockFaces::Front_Face);
-                        }
-                    }
-                }
-            } 
-        }
-    }
+    RebuildMeshSlabs(World::allMeshSlabs);
 }
 
 
 
-void Chunk::RebuildMesh()
+void Chunk::RebuildMeshSlabs(GLuint slabMask)
 {
-    // Clear our batch data
-    chunkOpaqueVertices.clear();
-    chunkTransparentVertices.clear();
-
-    // Remesh our chunk
-    meshCreated = false;
+    // The chunk manager queues a new mesh job for us, we keep drawing the old mesh until it's uploaded
+    dirtySlabs |= slabMask;
 }
 
 
 
-void Chunk::RenderChunk(GLuint cubeShaderProgramID, GLboolean renderOpaque)
+void Chunk::RebuildMeshAround(GLint x, GLint y, GLint z)
 {
-    // Draw our chunks, this if statement only runs once per chunk
-    if(!meshCreated)
+    // A block changes the faces and ambient occlusion of the blocks up to one
+    // away from it, which can be in the chunks it touches
+    GLint lowX = (x == 0 ? -1 : 0), highX = (x == (GLint)World::chunkWidthX  - 1 ? 1 : 0);
+    GLint lowY = (y == 0 ? -1 : 0), highY = (y == (GLint)World::chunkHeightY - 1 ? 1 : 0);
+    GLint lowZ = (z == 0 ? -1 : 0), highZ = (z == (GLint)World::chunkDepthZ  - 1 ? 1 : 0);
+    for(GLint dz = lowZ; dz <= highZ; dz++)
+    for(GLint dy = lowY; dy <= highY; dy++)
+    for(GLint dx = lowX; dx <= highX; dx++)
     {
-        /* Create our batch data */
-        // We have to create our mesh for our chunk using our 3D chunk block array
-        meshCreated = true;
-        RenderMesh();
-
-        // Put our batch data in buffers
-        // Bind the VAO so OpenGL knows to use it
-        // Batch data for Opaque blocks
-        ChunkOpaqueVAO.Bind();
-        ChunkOpaqueVBO.InitVBO(chunkOpaqueVertices.data(), sizeof(GLuint) * chunkOpaqueVertices.size());
-        ChunkOpaqueVAO.Unbind();
-
-        // Batch data for Transparent blocks
-        ChunkTransparentVAO.Bind();
-        ChunkTransparentVBO.InitVBO(chunkTransparentVertices.data(), sizeof(GLuint) * chunkTransparentVertices.size());
-        ChunkTransparentVAO.Unbind();
-    }
-
-    // Set our uniform for our chunk offset
-    glUniform3f(glGetUniformLocation(cubeShaderProgramID, "chunkOffset"), offset_x, offset_y, offset_z);
-
-    // Are we rendering opaque or transparent faces
-    if(renderOpaque)
-    {
-        ChunkOpaqueVAO.Bind();
-        // Render our opaque faces
-        glDrawArrays(GL_TRIANGLES, 0, chunkOpaqueVertices.size());
-        ChunkOpaqueVAO.Unbind();
-    }
-    else
-    {
-        ChunkTransparentVAO.Bind();
-        // Render our transparent faces
-        glDrawArrays(GL_TRIANGLES, 0, chunkTransparentVertices.size());
-        ChunkTransparentVAO.Unbind();
+        Chunk *neighbour = neighbours[NeighbourIndex(dx, dy, dz)];
+        if(neighbour == nullptr)
+            continue;
+        // The layers around the block, as seen from the neighbour
+        GLint neighbourY = y - dy * (GLint)World::chunkHeightY;
+        neighbour->RebuildMeshSlabs(ChunkMesher::SlabsBetween(neighbourY - 1, neighbourY + 1));
     }
 }
 
 
 
-// Utility method for 1D chunk array. Set a block in the array
+// Utility method for chunk block storage. Set a block in the storage
 void Chunk::SetBlock(Block block)
 {
-    chunk[(GLint)block.position.x + (GLint)block.position.z*World::chunkWidthX + (GLint)block.position.y*World::chunkWidthX*World::chunkDepthZ] = block;
+    chunkBlocks.SetBlockType(block.position.x, block.position.y, block.position.z, block.blockTypeID);
 }
 
 
@@ -1074,57 +314,25 @@ void Chunk::SetBlock(Block block)
 // Set blockType for block
 void Chunk::SetBlockType(glm::vec3 position, GLint BlockTypeID)
 {
-    chunk[(GLint)position.x + (GLint)position.z*World::chunkWidthX + (GLint)position.y*World::chunkWidthX*World::chunkDepthZ].blockTypeID = BlockTypeID; 
+    chunkBlocks.SetBlockType(position.x, position.y, position.z, BlockTypeID);
 }
 
 
 
-// Utility method for 1D chunk array. Get a block in the array
+// Utility method for chunk block storage. Get a block in the storage
 Block Chunk::GetBlock(GLint x, GLint y, GLint z)
 {
-    return chunk[x + z*World::chunkWidthX + y*World::chunkWidthX*World::chunkDepthZ];
+    // Blocks are not stored as objects anymore, so build one on the fly
+    Block block;
+    block.position = glm::vec3(x, y, z);
+    block.blockTypeID = chunkBlocks.GetBlockType(x, y, z);
+    return block;
 }
 
 
 
-// Utility method for 1D chunk array. Get a block in the array
+// Utility method for chunk block storage. Get a block in the storage
 Block Chunk::GetBlock(glm::vec3 position)
 {
-    return chunk[(GLint)position.x + (GLint)position.z*World::chunkWidthX + (GLint)position.y*World::chunkWidthX*World::chunkDepthZ];
-}
-
-
-
-// Utility method for 1D chunk array. Set the position for a block in the array
-void Chunk::SetPosition(GLint x, GLint y, GLint z)
-{
-    chunk[x + z*World::chunkWidthX + y*World::chunkWidthX*World::chunkDepthZ].position = glm::vec3(x, y, z);
-}
-
-
-
-GLboolean Chunk::IsTransparent(GLint x, GLint y, GLint z)
-{
-    return blocks[std::to_string(chunk[x + z*World::chunkWidthX + y*World::chunkWidthX*World::chunkDepthZ].blockTypeID)]["transparent"];
-}
-
-
-
-GLboolean Chunk::IsTransparent(glm::vec3 position)
-{
-    return blocks[std::to_string(chunk[(GLint)position.x + (GLint)position.z*World::chunkWidthX + (GLint)position.y*World::chunkWidthX*World::chunkDepthZ].blockTypeID)]["transparent"];
-}
-
-
-
-GLboolean Chunk::IsFoliage(GLint x, GLint y, GLint z)
-{
-    return blocks[std::to_string(chunk[x + z*World::chunkWidthX + y*World::chunkWidthX*World::chunkDepthZ].blockTypeID)]["isFoliage"];
-}
-
-
-
-GLboolean Chunk::IsFoliage(glm::vec3 position)
-{
-    return blocks[std::to_string(chunk[(GLint)position.x + (GLint)position.z*World::chunkWidthX + (GLint)position.y*World::chunkWidthX*World::chunkDepthZ].blockTypeID)]["isFoliage"];
+    return GetBlock((GLint)position.x, (GLint)position.y, (GLint)position.z);
 }
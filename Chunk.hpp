@@ -1,23 +1,31 @@
 #pragma once
 
 #include "Block.hpp"
+#include "BlockStorage.hpp"
+#include "BlockRegistry.hpp"
+#include "LightStorage.hpp"
+#include "ChunkMesher.hpp"
+#include "ChunkSnapshot.hpp"
+#include "ChunkIndex.hpp"
+#include "ChunkArena.hpp"
+#include "FeaturePlacer.hpp"
+#include "ChunkSerializer.hpp"
 #include "Biomes.hpp"
 #include "WorldConstants.hpp"
-#include "VAO.hpp"
-#include "VBO.hpp"
-#include "EBO.hpp"
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
-#define GLM_ENABLE_EXPERIMENTAL // Need this to use the glm hashes
-#include "glm/gtx/hash.hpp" // Include hash maps for unordered_map
-#include <unordered_map> // For unordered_map
 #include <iostream>
 #include <vector> // For std::vector
 
 
 
+class ChunkBuffers;
+
+// A chunk's blocks and meshing state. Owns no GL objects, the chunk manager
+// looks after the GPU side of its mesh, so chunks can be created, generated
+// and meshed without a GL context
 class Chunk
 {
 public:
@@ -31,68 +39,111 @@ public:
     GLint chunk_position_x;
     GLint chunk_position_y;
     GLint chunk_position_z;
-    // 1D array with the chunk dimensions
-    Block chunk[World::chunkWidthX * World::chunkHeightY * World::chunkDepthZ];
+    // Palette compressed block type IDs for the chunk dimensions
+    BlockStorage chunkBlocks;
+    // Skylight and block light of every block. Only meaningful once we are lit
+    LightStorage light;
     // Min and max height of a chunk
     GLfloat heightMin = 1.0f;
-    GLfloat heightMax = World::heightLimit;
+    GLfloat heightMax = World::terrainHeight;
 
     // Which biome ID this chunk is
     GLuint biomeID = 0;
-    // A check for whether this chunk has its mesh created
-    GLboolean meshCreated = false;
+    // The 3x3x3 chunks around us (see NeighbourIndex), nullptr where nothing is loaded.
+    // The middle one is us. Kept up to date by the chunk index
+    Chunk *neighbours[27] = {};
+    // Where we are in the chunk index's list of chunks
+    GLuint chunkListIndex = 0;
+    // Lowest and highest y (in blocks, within the chunk) of any non-air block.
+    // Generation works them out from the terrain, then each uploaded mesh keeps
+    // them to what it holds. Keeps our bounding box tight for frustum culling
+    GLint occupiedMinY = 0;
+    GLint occupiedMaxY = World::chunkHeightY - 1;
+    // Whether a worker is generating our terrain right now. We can't be unloaded until it's done
+    GLboolean generating = false;
+    // Whether our terrain has been generated. Until then our blocks are not safe to read
+    GLboolean generated = false;
+    // Whether the light engine has lit our column. Until then our light is not
+    // safe to read, and light spreading from our neighbours stops at our border
+    GLboolean lit = false;
+    // Bit per mesh slab (see World::meshSlabHeight) whose blocks changed since our
+    // mesh was last queued. Starts out all set so the chunk manager builds our first mesh
+    GLuint dirtySlabs = World::allMeshSlabs;
+    // ID of the newest mesh job queued for this chunk, 0 if there is none in flight.
+    // Only a finished mesh with this ID gets uploaded
+    GLuint meshRequestID = 0;
+    // Level of detail of the mesh we last queued, 0 for full detail. Each level
+    // halves how many cells a side the mesh is built from
+    GLuint lodLevel = 0;
+    // Whether we merge coplanar faces into bigger quads (greedy meshing)
+    // or draw every visible face on its own
+    GLboolean greedyMeshing = World::greedyMeshingEnabled;
+    // Blocks our trees put in our neighbours, one entry per neighbour. Filled in
+    // by GenerateBlocks and applied by the chunk manager as those neighbours load
+    std::vector<FeatureEdits> outgoingFeatureEdits;
+    // Bit per neighbour (see NeighbourIndex) whose tree blocks are already in our
+    // blocks. Saved with us, so a reloaded chunk doesn't get them twice
+    GLuint appliedFeatureNeighbours = 0;
+    // Whether the player changed our blocks since we were generated or loaded.
+    // Only edited chunks are saved, the rest regenerate the same from the seed
+    GLboolean edited = false;
 
     // Constructor with positions of chunk passed in
     Chunk(GLint position_x, GLint position_y, GLint position_z, GLuint BiomeIndex);
     ~Chunk();
     // Generate our full chunk
     void GenerateBlocks(GLuint seed, GLint biomeTypeIDPosX, GLint biomeTypeIDPosZ, GLint biomeTypeIDNegX, GLint biomeTypeIDNegZ);
-    // Now that we have our model, actually send the geometry/mesh/batch to GPU
-    void RenderChunk(GLuint cubeShaderProgramID, GLboolean renderOpaque);
-    // Get block in 1D chunk array
+    // Copy out everything we save to disk
+    SavedChunk Save() const;
+    // Take our blocks from a save instead of generating them
+    void Load(SavedChunk &&saved);
+    // Get block in chunk block storage
     Block GetBlock(GLint x, GLint y, GLint z);
     Block GetBlock(glm::vec3 position);
     // Set the block type for a block
     void SetBlockType(glm::vec3 position, GLint BlockTypeID);
-    // Remesh our chunk
+    // Our position in chunks, the key the chunk index finds us by
+    glm::ivec3 GetPosition() const { return glm::ivec3(chunk_position_x, chunk_position_y, chunk_position_z); }
+    // Which entry of neighbours holds the chunk at offset dx, dy, dz (each -1 to 1) from us
+    static GLuint NeighbourIndex(GLint dx, GLint dy, GLint dz) { return (dx + 1) + (dy + 1) * 3 + (dz + 1) * 9; }
+    // Remesh our chunk. The current mesh stays on screen until the new one is uploaded
     void RebuildMesh();
+    // Remesh only the slabs in slabMask
+    void RebuildMeshSlabs(GLuint slabMask);
+    // Remesh the slabs the block at x, y, z shows up in after it changed, here and in
+    // every neighbour it touches, corners included since they share its AO
+    void RebuildMeshAround(GLint x, GLint y, GLint z);
+    // Copy our blocks and our generated neighbours' blocks so a worker thread can mesh
+    // the slabs in slabMask. Neighbours above and below are only copied if those slabs reach them.
+    // Our light and the light touching us from our lit neighbours goes along too
+    ChunkSnapshot TakeSnapshot(GLuint slabMask = World::allMeshSlabs);
+    // The same into a snapshot that is being reused, so copying reuses its storage
+    void TakeSnapshot(ChunkSnapshot &snapshot, GLuint slabMask);
+    // Whether we have anything to draw
+    GLboolean HasMesh() const { return opaqueVertexCount > 0 || transparentVertexCount > 0; }
+
+    /* GPU side of our mesh, only touched by the chunk manager on the main thread */
+    // How many vertices of each kind the uploaded mesh has
+    GLsizei opaqueVertexCount = 0;
+    GLsizei transparentVertexCount = 0;
+    // Each mesh slab's pages in the shared chunk arena, when World::multiDrawRendering is on
+    ChunkArena::Allocation opaqueAllocations[World::meshSlabCount];
+    ChunkArena::Allocation transparentAllocations[World::meshSlabCount];
+    // Lowest and highest y of any non-air block in each uploaded slab, minY > maxY if it has none
+    GLint slabMinY[World::meshSlabCount];
+    GLint slabMaxY[World::meshSlabCount];
+    // Our own buffers when it is off. Made on our first upload, and deleted by the
+    // chunk manager before it deletes us
+    ChunkBuffers *buffers = nullptr;
 
 private:
-    // All the buffers for opaque blocks for our chunk
-    VAO ChunkOpaqueVAO;
-    VBO ChunkOpaqueVBO;
-    // All the buffers for transparent blocks for our chunk
-    VAO ChunkTransparentVAO;
-    VBO ChunkTransparentVBO;
-    // Our chunk vertices and indices to send to GPU/shader
-    std::vector<GLuint> chunkOpaqueVertices;
-    std::vector<GLuint> chunkTransparentVertices;
 
-    // Determine block ambient occlusion
-    void DetermineAOTopFace(glm::vec3 position);
-    void DetermineAOFrontFace(glm::vec3 position);
-    void DetermineAOBackFace(glm::vec3 position);
-    void DetermineAOLeftFace(glm::vec3 position);
-    void DetermineAORightFace(glm::vec3 position);
-    // Minify full block chunk into only faces that need render (a mesh)
-    void RenderMesh();
-    /* Utility methods for 1D chunk array */
-    // Set block in 1D chunk array
+    /* Utility methods for chunk block storage */
+    // Set block type in chunk block storage
     void SetBlock(Block block);
-    // Set position of block in 1D chunk array
-    void SetPosition(GLint x, GLint y, GLint z);
-    // Check if a block is air in 1D chunk array
-    GLboolean IsTransparent(GLint x, GLint y, GLint z);
-    GLboolean IsTransparent(glm::vec3 position);
-    GLboolean IsFoliage(GLint x, GLint y, GLint z);
-    GLboolean IsFoliage(glm::vec3 position);
-    // Formula for checking 1D chunk block is: chunk[x + z*World::chunkWidthX + y*World::chunkWidthX*World::chunkDepthZ]
-
-    // Draw a single face of a block
-    void DrawFace(Block block, GLuint faceIndex);
 };
 
-// Keep track of where each chunk is located with hash map
-inline std::unordered_map<glm::vec3, Chunk *> chunks_; // A hash map of chunks, where the key is a vec2
+// Keep track of where each loaded chunk is located, keyed by its position in chunks
+inline ChunkIndex chunks_;
 
 
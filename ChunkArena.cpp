@@ -0,0 +1,341 @@
+#include "ChunkArena.hpp"
+#include "ChunkMesher.hpp"
+#include "QuadIndexBuffer.hpp"
+#include "TextureArray.hpp"
+#include "WorldConstants.hpp"
+
+#include <GLFW/glfw3.h> // For glfwGetProcAddress()
+#include <iostream>
+#include <iterator> // For std::prev
+
+
+
+// Our glad loader only covers GL 3.3, so the GL 4.3 multi-draw-indirect entry
+// point is looked up by hand when the context has it
+#ifndef GL_DRAW_INDIRECT_BUFFER
+#define GL_DRAW_INDIRECT_BUFFER 0x8F3F
+#endif
+typedef void (APIENTRYP MultiDrawArraysIndirectFunction)(GLenum mode, const void *indirect, GLsizei drawcount, GLsizei stride);
+typedef void (APIENTRYP MultiDrawElementsIndirectFunction)(GLenum mode, GLenum type, const void *indirect, GLsizei drawcount, GLsizei stride);
+static MultiDrawArraysIndirectFunction multiDrawArraysIndirect = nullptr;
+static MultiDrawElementsIndirectFunction multiDrawElementsIndirect = nullptr;
+
+// Bytes of one page of vertices, and of one page table entry
+static const GLsizeiptr pageBytes = World::chunkArenaPageVertices * ChunkMesher::vertexStride * sizeof(GLuint);
+static const GLsizeiptr pageTableEntryBytes = sizeof(glm::vec4);
+
+
+
+void ChunkArena::Init()
+{
+    // The cube shader's page table sampler needs a texture unit of its own even
+    // when it goes unused, samplers of different types can't share a unit
+    pageTableTextureUnit = textureSlotIndex;
+    textureSlotIndex++;
+    // The same goes for the quad record sampler, which chunks with their own buffers use too
+    recordTextureUnit = textureSlotIndex;
+    textureSlotIndex++;
+    if(!World::multiDrawRendering)
+        return;
+
+    pageCapacity = World::chunkArenaInitialPages;
+    freePages.clear();
+    freePages[0] = pageCapacity;
+
+    // The vertex buffer, laid out like a chunk's own VBO
+    glGenVertexArrays(1, &arenaVAO);
+    glGenBuffers(1, &arenaVBO);
+    glBindBuffer(GL_ARRAY_BUFFER, arenaVBO);
+    glBufferData(GL_ARRAY_BUFFER, pageCapacity * pageBytes, nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    // The page offset table, read through a buffer texture on its own texture unit
+    glGenBuffers(1, &pageTableBuffer);
+    glBindBuffer(GL_TEXTURE_BUFFER, pageTableBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, pageCapacity * pageTableEntryBytes, nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    glGenTextures(1, &pageTableTexture);
+    // With vertex pulling the shader reads the quads out of the vertex buffer through a buffer texture
+    if(World::vertexPulling)
+        glGenTextures(1, &recordTexture);
+
+    AttachBuffers();
+    CheckTextureBufferSize();
+
+    // Use the indirect multi-draws where the context is new enough, and
+    // glMultiDrawArrays (core since GL 1.4) or glMultiDrawElementsBaseVertex
+    // (core since GL 3.2) everywhere else
+    GLint majorVersion = 0, minorVersion = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &majorVersion);
+    glGetIntegerv(GL_MINOR_VERSION, &minorVersion);
+    if(majorVersion > 4 || (majorVersion == 4 && minorVersion >= 3))
+    {
+        multiDrawArraysIndirect = (MultiDrawArraysIndirectFunction)glfwGetProcAddress("glMultiDrawArraysIndirect");
+        multiDrawElementsIndirect = (MultiDrawElementsIndirectFunction)glfwGetProcAddress("glMultiDrawElementsIndirect");
+    }
+    indirectDraws = (ChunkMesher::drawsIndexed ? multiDrawElementsIndirect != nullptr : multiDrawArraysIndirect != nullptr);
+    if(indirectDraws)
+        glGenBuffers(1, &indirectBuffer);
+}
+
+
+
+ChunkArena::Allocation ChunkArena::Allocate(const std::vector<GLuint> &vertices, glm::vec3 chunkOffset)
+{
+    return Allocate(vertices.data(), vertices.size(), chunkOffset);
+}
+
+
+
+ChunkArena::Allocation ChunkArena::Allocate(const GLuint *vertices, size_t size, glm::vec3 chunkOffset)
+{
+    Allocation allocation;
+    allocation.vertexCount = size / ChunkMesher::vertexStride;
+    if(allocation.vertexCount == 0)
+        return allocation;
+
+    GLuint pageCount = (allocation.vertexCount + World::chunkArenaPageVertices - 1) / World::chunkArenaPageVertices;
+    if(!TakePages(pageCount, allocation.firstPage))
+    {
+        Grow(pageCount);
+        TakePages(pageCount, allocation.firstPage);
+    }
+    allocation.pageCount = pageCount;
+
+    // The mesh itself
+    glBindBuffer(GL_ARRAY_BUFFER, arenaVBO);
+    glBufferSubData(GL_ARRAY_BUFFER, allocation.firstPage * pageBytes, size * sizeof(GLuint), vertices);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    // Every page of it points at our chunk's offset
+    pageOffsets.assign(pageCount, glm::vec4(chunkOffset, 0.0f));
+    glBindBuffer(GL_TEXTURE_BUFFER, pageTableBuffer);
+    glBufferSubData(GL_TEXTURE_BUFFER, allocation.firstPage * pageTableEntryBytes, pageCount * pageTableEntryBytes, pageOffsets.data());
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+    return allocation;
+}
+
+
+
+void ChunkArena::Free(Allocation &allocation)
+{
+    if(allocation.pageCount > 0)
+        ReleasePages(allocation.firstPage, allocation.pageCount);
+    allocation = Allocation();
+}
+
+
+
+GLint ChunkArena::FirstVertex(const Allocation &allocation)
+{
+    return allocation.firstPage * World::chunkArenaPageVertices;
+}
+
+
+
+void ChunkArena::Draw(const std::vector<GLint> &firsts, const std::vector<GLsizei> &counts)
+{
+    if(firsts.empty())
+        return;
+
+    glBindVertexArray(arenaVAO);
+    if(ChunkMesher::drawsIndexed)
+    {
+        // Every draw reads the shared quad indices from the start, and base vertex
+        // moves them onto its mesh. gl_VertexID includes the base vertex, so the
+        // shader's page lookup works the same as for plain arrays
+        drawIndexCounts.resize(firsts.size());
+        for(GLuint i = 0; i < firsts.size(); i++)
+            drawIndexCounts[i] = ChunkMesher::DrawCount(counts[i]);
+        if(indirectDraws)
+        {
+            indirectElementCommands.resize(firsts.size());
+            for(GLuint i = 0; i < firsts.size(); i++)
+                indirectElementCommands[i] = { (GLuint)drawIndexCounts[i], 1, 0, firsts[i], 0 };
+            // Orphan and refill, so we never wait on the GPU reading last frame's commands
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer);
+            glBufferData(GL_DRAW_INDIRECT_BUFFER, indirectElementCommands.size() * sizeof(DrawElementsIndirectCommand), indirectElementCommands.data(), GL_STREAM_DRAW);
+            multiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, indirectElementCommands.size(), 0);
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+        }
+        else
+        {
+            drawIndexOffsets.resize(firsts.size(), nullptr);
+            glMultiDrawElementsBaseVertex(GL_TRIANGLES, drawIndexCounts.data(), GL_UNSIGNED_INT, drawIndexOffsets.data(), firsts.size(), firsts.data());
+        }
+    }
+    else
+    {
+        // Pulled records each draw as the 6 vertices of their quad, which find
+        // their record at gl_VertexID / 6
+        const std::vector<GLint> *arrayFirsts = &firsts;
+        const std::vector<GLsizei> *arrayCounts = &counts;
+        if(World::vertexPulling)
+        {
+            pulledFirsts.resize(firsts.size());
+            pulledCounts.resize(firsts.size());
+            for(GLuint i = 0; i < firsts.size(); i++)
+            {
+                pulledFirsts[i] = firsts[i] * ChunkMesher::indicesPerQuad;
+                pulledCounts[i] = ChunkMesher::DrawCount(counts[i]);
+            }
+            arrayFirsts = &pulledFirsts;
+            arrayCounts = &pulledCounts;
+        }
+
+        if(indirectDraws)
+        {
+            indirectCommands.resize(firsts.size());
+            for(GLuint i = 0; i < firsts.size(); i++)
+                indirectCommands[i] = { (GLuint)(*arrayCounts)[i], 1, (GLuint)(*arrayFirsts)[i], 0 };
+            // Orphan and refill, so we never wait on the GPU reading last frame's commands
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer);
+            glBufferData(GL_DRAW_INDIRECT_BUFFER, indirectCommands.size() * sizeof(DrawArraysIndirectCommand), indirectCommands.data(), GL_STREAM_DRAW);
+            multiDrawArraysIndirect(GL_TRIANGLES, nullptr, indirectCommands.size(), 0);
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+        }
+        else
+        {
+            glMultiDrawArrays(GL_TRIANGLES, arrayFirsts->data(), arrayCounts->data(), firsts.size());
+        }
+    }
+    glBindVertexArray(0);
+}
+
+
+
+void ChunkArena::Delete()
+{
+    glDeleteVertexArrays(1, &arenaVAO);
+    glDeleteBuffers(1, &arenaVBO);
+    glDeleteBuffers(1, &pageTableBuffer);
+    glDeleteTextures(1, &pageTableTexture);
+    if(recordTexture != 0)
+        glDeleteTextures(1, &recordTexture);
+    if(indirectBuffer != 0)
+        glDeleteBuffers(1, &indirectBuffer);
+}
+
+
+
+GLboolean ChunkArena::TakePages(GLuint pageCount, GLuint &firstPage)
+{
+    for(auto run = freePages.begin(); run != freePages.end(); run++)
+    {
+        if(run->second < pageCount)
+            continue;
+        firstPage = run->first;
+        GLuint pagesLeft = run->second - pageCount;
+        freePages.erase(run);
+        if(pagesLeft > 0)
+            freePages[firstPage + pageCount] = pagesLeft;
+        return true;
+    }
+    return false;
+}
+
+
+
+void ChunkArena::ReleasePages(GLuint firstPage, GLuint pageCount)
+{
+    // Merge with the free run right after us
+    auto next = freePages.lower_bound(firstPage);
+    if(next != freePages.end() && firstPage + pageCount == next->first)
+    {
+        pageCount += next->second;
+        next = freePages.erase(next);
+    }
+    // And with the one right before us
+    if(next != freePages.begin())
+    {
+        auto previous = std::prev(next);
+        if(previous->first + previous->second == firstPage)
+        {
+            previous->second += pageCount;
+            return;
+        }
+    }
+    freePages[firstPage] = pageCount;
+}
+
+
+
+void ChunkArena::Grow(GLuint minimumPages)
+{
+    GLuint oldCapacity = pageCapacity;
+    pageCapacity = std::max(pageCapacity * 2, pageCapacity + minimumPages);
+    CheckTextureBufferSize();
+
+    arenaVBO = ResizeBuffer(arenaVBO, oldCapacity * pageBytes, pageCapacity * pageBytes);
+    pageTableBuffer = ResizeBuffer(pageTableBuffer, oldCapacity * pageTableEntryBytes, pageCapacity * pageTableEntryBytes);
+    AttachBuffers();
+
+    // The new pages join (and merge with) the free runs
+    ReleasePages(oldCapacity, pageCapacity - oldCapacity);
+}
+
+
+
+void ChunkArena::AttachBuffers()
+{
+    // Point the VAO at the (possibly new) vertex buffer
+    glBindVertexArray(arenaVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, arenaVBO);
+    // Pulled records aren't vertex attributes. Each is drawn 6 times over, so an
+    // attribute would read far past the end of the buffer
+    if(!World::vertexPulling)
+    {
+        glVertexAttribIPointer(0, ChunkMesher::vertexStride, GL_UNSIGNED_INT, ChunkMesher::vertexStride * sizeof(GLuint), (void*)0);
+        glEnableVertexAttribArray(0);
+    }
+    quadIndexBuffer_.Bind();
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    // And the page table texture at the (possibly new) page table buffer,
+    // leaving whichever texture unit was active alone
+    GLint activeTexture = GL_TEXTURE0;
+    glGetIntegerv(GL_ACTIVE_TEXTURE, &activeTexture);
+    glActiveTexture(GL_TEXTURE0 + pageTableTextureUnit);
+    glBindTexture(GL_TEXTURE_BUFFER, pageTableTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, pageTableBuffer);
+    if(World::vertexPulling)
+    {
+        glActiveTexture(GL_TEXTURE0 + recordTextureUnit);
+        glBindTexture(GL_TEXTURE_BUFFER, recordTexture);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_RG32UI, arenaVBO);
+    }
+    glActiveTexture(activeTexture);
+}
+
+
+
+void ChunkArena::CheckTextureBufferSize() const
+{
+    GLint maxTextureBufferSize = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTextureBufferSize);
+    if(pageCapacity > (GLuint)maxTextureBufferSize)
+        std::cout << "Chunk arena page table has " << pageCapacity << " pages, more than the " << maxTextureBufferSize << " this GPU can read" << std::endl;
+    // Every record is one texel of the record texture, which covers the whole vertex buffer
+    GLuint64 recordTexels = (GLuint64)pageCapacity * World::chunkArenaPageVertices;
+    if(World::vertexPulling && recordTexels > (GLuint64)maxTextureBufferSize)
+        std::cout << "Chunk arena holds " << recordTexels << " quad records, more than the " << maxTextureBufferSize << " this GPU can read" << std::endl;
+}
+
+
+
+GLuint ChunkArena::ResizeBuffer(GLuint oldBuffer, GLsizeiptr oldSize, GLsizeiptr newSize)
+{
+    GLuint newBuffer;
+    glGenBuffers(1, &newBuffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, newBuffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, newSize, nullptr, GL_DYNAMIC_DRAW);
+    // Copy on the GPU, nothing comes back to us
+    glBindBuffer(GL_COPY_READ_BUFFER, oldBuffer);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, oldSize);
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    glDeleteBuffers(1, &oldBuffer);
+    return newBuffer;
+}
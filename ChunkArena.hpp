@@ -0,0 +1,130 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <algorithm> // For std::max
+#include <map> // For std::map
+#include <vector> // For std::vector
+
+
+
+// One big vertex buffer that every chunk mesh is sub-allocated from, so the
+// whole visible world draws with one multi-draw call per pass instead of a
+// bind, uniform and glDrawArrays per chunk.
+//
+// The buffer is split into pages of World::chunkArenaPageVertices vertices.
+// A mesh takes a run of whole pages, and a buffer texture holds the chunk
+// offset of every page. The cube shader finds its chunk's offset from
+// gl_VertexID / page size, which works for glMultiDrawArraysIndirect and for
+// GL 3.3's glMultiDrawArrays alike, since neither tells the shader which draw it is in.
+// Indexed quads draw through the shared quad index buffer with a base vertex
+// instead, which gl_VertexID includes, so the page lookup doesn't change. With
+// vertex pulling the buffer holds one record per quad, also read through a
+// buffer texture, and pages are pages of records
+class ChunkArena
+{
+public:
+    // Where a mesh lives in the arena. pageCount is 0 for an empty mesh
+    struct Allocation
+    {
+        GLuint firstPage = 0;
+        GLuint pageCount = 0;
+        GLsizei vertexCount = 0;
+    };
+
+    // Blank constructor, call Init once there is a GL context
+    ChunkArena(){};
+
+    // Create the vertex buffer, the page offset table and, on GL 4.3+, the indirect
+    // draw buffer. Only claims a texture unit if World::multiDrawRendering is off
+    void Init();
+    // Copy a mesh into free pages, growing the arena if none are left. chunkOffset
+    // is what the shader adds to the mesh's block positions
+    Allocation Allocate(const std::vector<GLuint> &vertices, glm::vec3 chunkOffset);
+    // The same for the size GLuints of vertices starting at vertices
+    Allocation Allocate(const GLuint *vertices, size_t size, glm::vec3 chunkOffset);
+    // Give an allocation's pages back and reset it to empty
+    void Free(Allocation &allocation);
+    // First vertex of an allocation, for a draw call
+    static GLint FirstVertex(const Allocation &allocation);
+
+    // Texture unit the page offset table is bound to, for the cube shader's sampler
+    GLuint GetPageTableTextureUnit() const { return pageTableTextureUnit; }
+    // Texture unit the quad records of the mesh being drawn are bound to, with World::vertexPulling
+    GLuint GetRecordTextureUnit() const { return recordTextureUnit; }
+    // Whether draws go through glMultiDraw*Indirect, otherwise glMultiDrawArrays or glMultiDrawElementsBaseVertex
+    GLboolean UsesIndirectDraws() const { return indirectDraws; }
+
+    // Draw count ranges (first vertex, vertex count) of the arena in one call.
+    // With World::indexedQuads the ranges are drawn as quads through the shared index buffer
+    void Draw(const std::vector<GLint> &firsts, const std::vector<GLsizei> &counts);
+    // Deletes all of the arena's GL objects
+    void Delete();
+
+private:
+    // The same layout as glMultiDrawArraysIndirect reads from the indirect buffer
+    struct DrawArraysIndirectCommand
+    {
+        GLuint count;
+        GLuint instanceCount;
+        GLuint first;
+        GLuint baseInstance;
+    };
+
+    // The same layout as glMultiDrawElementsIndirect reads from the indirect buffer
+    struct DrawElementsIndirectCommand
+    {
+        GLuint count;
+        GLuint instanceCount;
+        GLuint firstIndex;
+        GLint baseVertex;
+        GLuint baseInstance;
+    };
+
+    // Raw IDs rather than VAO/VBO objects, whose constructors need a GL context
+    // and we are created before there is one
+    GLuint arenaVAO = 0;
+    GLuint arenaVBO = 0;
+    // One RGBA32F texel per page, holding the offset of the chunk that owns it
+    GLuint pageTableBuffer = 0;
+    GLuint pageTableTexture = 0;
+    GLuint pageTableTextureUnit = 0;
+    // The vertex buffer seen as one RG32UI texel per quad record, with World::vertexPulling
+    GLuint recordTexture = 0;
+    GLuint recordTextureUnit = 0;
+    // Indirect draw commands, rewritten every draw
+    GLuint indirectBuffer = 0;
+    std::vector<DrawArraysIndirectCommand> indirectCommands;
+    std::vector<DrawElementsIndirectCommand> indirectElementCommands;
+    // Index counts of each draw, and where each starts in the index buffer (always the start)
+    std::vector<GLsizei> drawIndexCounts;
+    std::vector<const void *> drawIndexOffsets;
+    // First vertex and vertex count of each draw, with every record drawn as 6 vertices
+    std::vector<GLint> pulledFirsts;
+    std::vector<GLsizei> pulledCounts;
+    GLboolean indirectDraws = false;
+
+    // How many pages the buffers have room for
+    GLuint pageCapacity = 0;
+    // Runs of free pages, first page -> page count. Neighbouring runs are always merged
+    std::map<GLuint, GLuint> freePages;
+    // Scratch for the page table entries of the mesh being allocated
+    std::vector<glm::vec4> pageOffsets;
+
+    // Find pageCount free pages in a row, first fit. Returns false if there's no run that long
+    GLboolean TakePages(GLuint pageCount, GLuint &firstPage);
+    // Return a run of pages to the free runs, merging it with its neighbours
+    void ReleasePages(GLuint firstPage, GLuint pageCount);
+    // Double the arena (or more, to fit minimumPages), keeping everything already in it
+    void Grow(GLuint minimumPages);
+    // Point the VAO and the page table texture at our current buffers
+    void AttachBuffers();
+    // Warn if the page table, or the quad records with vertex pulling, hold more
+    // texels than the GPU's buffer textures can reach
+    void CheckTextureBufferSize() const;
+    // Make a buffer of newSize bytes holding the first oldSize bytes of oldBuffer, then delete oldBuffer
+    static GLuint ResizeBuffer(GLuint oldBuffer, GLsizeiptr oldSize, GLsizeiptr newSize);
+};
+
+// Every chunk mesh lives in here when World::multiDrawRendering is on
+inline ChunkArena chunkArena_;
@@ -0,0 +1,133 @@
+#include "ChunkBuffers.hpp"
+#include "ChunkArena.hpp"
+#include "QuadIndexBuffer.hpp"
+
+
+
+ChunkBuffers::ChunkBuffers()
+{
+    // Generate Vertex Array Object and binds it
+    /* Opaque VBO */
+    opaqueVAO.Bind();
+    opaqueVBO.Bind();
+    // Links VBO attributes such as coordinates and colors to VAO. Pulled
+    // records are read through opaqueRecords instead
+    if(!World::vertexPulling)
+        opaqueVAO.LinkAttribI(opaqueVBO, 0, ChunkMesher::vertexStride, GL_UNSIGNED_INT, ChunkMesher::vertexStride * sizeof(GLuint), (void*)0);
+    // Quads draw through the shared index buffer, if they are indexed
+    quadIndexBuffer_.Bind();
+    // Unbind all to prevent accidentally modifying them
+    opaqueVBO.Unbind();
+    opaqueVAO.Unbind();
+
+    /* Transparent VBO */
+    transparentVAO.Bind();
+    transparentVBO.Bind();
+    // Links VBO attributes such as coordinates and colors to VAO. Pulled
+    // records are read through transparentRecords instead
+    if(!World::vertexPulling)
+        transparentVAO.LinkAttribI(transparentVBO, 0, ChunkMesher::vertexStride, GL_UNSIGNED_INT, ChunkMesher::vertexStride * sizeof(GLuint), (void*)0);
+    // Quads draw through the shared index buffer, if they are indexed
+    quadIndexBuffer_.Bind();
+    // Unbind all to prevent accidentally modifying them
+    transparentVAO.Unbind();
+    transparentVBO.Unbind();
+    // The cube shader reads pulled records straight out of the VBOs
+    if(World::vertexPulling)
+    {
+        opaqueRecords = MakeRecordTexture(opaqueVBO.ID);
+        transparentRecords = MakeRecordTexture(transparentVBO.ID);
+    }
+}
+
+
+
+ChunkBuffers::~ChunkBuffers()
+{
+    // Delete all buffers when the chunk is unloaded
+    opaqueVAO.Delete();
+    opaqueVBO.Delete();
+    transparentVAO.Delete();
+    transparentVBO.Delete();    if(World::vertexPulling)
+    {
+        glDeleteTextures(1, &opaqueRecords);
+        glDeleteTextures(1, &transparentRecords);
+    }
+}
+
+
+
+void ChunkBuffers::Upload(const ChunkMesh &mesh)
+{
+    // Put our batch data in buffers
+    // Bind the VAO so OpenGL knows to use it
+    // Batch data for Opaque blocks
+    opaqueVAO.Bind();
+    opaqueVBO.InitVBO((GLuint *)mesh.opaqueVertices.data(), sizeof(GLuint) * mesh.opaqueVertices.size());
+    opaqueVAO.Unbind();
+
+    // Batch data for Transparent blocks
+    transparentVAO.Bind();
+    transparentVBO.InitVBO((GLuint *)mesh.transparentVertices.data(), sizeof(GLuint) * mesh.transparentVertices.size());
+    transparentVAO.Unbind();
+}
+
+
+
+void ChunkBuffers::Draw(GLboolean opaque, GLsizei vertexCount)
+{
+    // Are we rendering opaque or transparent faces
+    if(opaque)
+    {
+        opaqueVAO.Bind();
+        // Render our opaque faces
+        DrawVertices(vertexCount, opaqueRecords);
+        opaqueVAO.Unbind();
+    }
+    else
+    {
+        transparentVAO.Bind();
+        // Render our transparent faces
+        DrawVertices(vertexCount, transparentRecords);
+        transparentVAO.Unbind();
+    }
+}
+
+
+
+void ChunkBuffers::DrawVertices(GLsizei vertexCount, GLuint records)
+{
+    if(World::vertexPulling)
+    {
+        // Point the record sampler at our records, leaving whichever texture unit was active alone
+        GLint activeTexture = GL_TEXTURE0;
+        glGetIntegerv(GL_ACTIVE_TEXTURE, &activeTexture);
+        glActiveTexture(GL_TEXTURE0 + chunkArena_.GetRecordTextureUnit());
+        glBindTexture(GL_TEXTURE_BUFFER, records);
+        glActiveTexture(activeTexture);
+        glDrawArrays(GL_TRIANGLES, 0, ChunkMesher::DrawCount(vertexCount));
+    }
+    else if(ChunkMesher::drawsIndexed)
+    {
+        glDrawElements(GL_TRIANGLES, ChunkMesher::DrawCount(vertexCount), GL_UNSIGNED_INT, nullptr);
+    }
+    else
+    {
+        glDrawArrays(GL_TRIANGLES, 0, vertexCount);
+    }
+}
+
+
+
+GLuint ChunkBuffers::MakeRecordTexture(GLuint buffer)
+{
+    GLint activeTexture = GL_TEXTURE0;
+    glGetIntegerv(GL_ACTIVE_TEXTURE, &activeTexture);
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glActiveTexture(GL_TEXTURE0 + chunkArena_.GetRecordTextureUnit());
+    glBindTexture(GL_TEXTURE_BUFFER, texture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RG32UI, buffer);
+    glActiveTexture(activeTexture);
+    return texture;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "ChunkMesher.hpp"
+#include "VAO.hpp"
+#include "VBO.hpp"
+
+#include <glad/glad.h>
+
+
+
+// The VAOs and VBOs a chunk draws from when it is not in the shared chunk arena.
+// Kept out of Chunk so chunks can be created, generated and meshed without a
+// GL context. The chunk manager makes and deletes these on the main thread
+class ChunkBuffers
+{
+public:
+    // Constructor that generates the buffers and links the packed vertex attribute
+    ChunkBuffers();
+    // Destructor, deletes the buffers
+    ~ChunkBuffers();
+
+    // Replace what's in the buffers with a finished mesh
+    void Upload(const ChunkMesh &mesh);
+    // Draw the first vertexCount opaque or transparent vertices (records with World::vertexPulling)
+    void Draw(GLboolean opaque, GLsizei vertexCount);
+
+private:
+    // All the buffers for opaque blocks
+    VAO opaqueVAO;
+    VBO opaqueVBO;
+    // All the buffers for transparent blocks
+    VAO transparentVAO;
+    VBO transparentVBO;
+
+    // With World::vertexPulling, each VBO seen as one RG32UI texel per quad record
+    GLuint opaqueRecords = 0;
+    GLuint transparentRecords = 0;
+
+    // Draw the first vertexCount vertices (or records) of the bound VAO, whichever way quads are drawn
+    static void DrawVertices(GLsizei vertexCount, GLuint records);
+    // A buffer texture over a VBO's quad records. It follows whatever the VBO holds
+    static GLuint MakeRecordTexture(GLuint buffer);
+};
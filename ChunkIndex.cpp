@@ -0,0 +1,113 @@
+#include "ChunkIndex.hpp"
+#include "Chunk.hpp"
+#include "WorldConstants.hpp"
+
+
+
+ChunkIndex::ChunkIndex()
+{
+    // Enough for every chunk inside the unload distance without growing. The square
+    // around that circle bounds how many columns there can be, and the table stays at most half full
+    GLuint unloadSide = 2 * World::chunkUnloadDistance + 1;
+    GLuint mostChunks = unloadSide * unloadSide * World::chunksTall;
+    GLuint slotCount = 1;
+    while(slotCount < mostChunks * 2)
+        slotCount *= 2;
+    slots.resize(slotCount);
+    slotMask = slots.size() - 1;
+}
+
+
+
+void ChunkIndex::Add(Chunk *chunk)
+{
+    // Keep the table at most half full so probes stay short
+    if((chunkList.size() + 1) * 2 > slots.size())
+        Grow();
+
+    Insert(chunk);
+    chunk->chunkListIndex = chunkList.size();
+    chunkList.push_back(chunk);
+    LinkNeighbours(chunk, true);
+}
+
+
+
+void ChunkIndex::Remove(Chunk *chunk)
+{
+    glm::ivec3 position = chunk->GetPosition();
+    GLuint slot = Hash(position) & slotMask;
+    while(slots[slot].chunk != chunk)
+    {
+        if(slots[slot].chunk == nullptr)
+            return; // Not in the index
+        slot = (slot + 1) & slotMask;
+    }
+
+    // Empty the slot, then shift later entries of the same probe run back into
+    // the gap so lookups never stop early at it (no tombstones needed)
+    slots[slot].chunk = nullptr;
+    GLuint next = (slot + 1) & slotMask;
+    while(slots[next].chunk != nullptr)
+    {
+        GLuint home = Hash(slots[next].position) & slotMask;
+        // Move the entry if the gap sits between its home slot and where it is now
+        if(((next - home) & slotMask) >= ((next - slot) & slotMask))
+        {
+            slots[slot] = slots[next];
+            slots[next].chunk = nullptr;
+            slot = next;
+        }
+        next = (next + 1) & slotMask;
+    }
+
+    // Swap the last chunk into this chunk's place in the list
+    Chunk *last = chunkList.back();
+    chunkList[chunk->chunkListIndex] = last;
+    last->chunkListIndex = chunk->chunkListIndex;
+    chunkList.pop_back();
+
+    LinkNeighbours(chunk, false);
+}
+
+
+
+void ChunkIndex::Insert(Chunk *chunk)
+{
+    glm::ivec3 position = chunk->GetPosition();
+    GLuint slot = Hash(position) & slotMask;
+    while(slots[slot].chunk != nullptr)
+        slot = (slot + 1) & slotMask;
+    slots[slot].position = position;
+    slots[slot].chunk = chunk;
+}
+
+
+
+void ChunkIndex::Grow()
+{
+    slots.assign(slots.size() * 2, Slot());
+    slotMask = slots.size() - 1;
+    for(Chunk *chunk : chunkList)
+        Insert(chunk);
+}
+
+
+
+void ChunkIndex::LinkNeighbours(Chunk *chunk, GLboolean link)
+{
+    glm::ivec3 position = chunk->GetPosition();
+    for(GLint dz = -1; dz <= 1; dz++)
+    for(GLint dy = -1; dy <= 1; dy++)
+    for(GLint dx = -1; dx <= 1; dx++)
+    {
+        if(dx == 0 && dy == 0 && dz == 0)
+            continue;
+
+        Chunk *neighbour = Get(position + glm::ivec3(dx, dy, dz));
+        // We are neighbour -dx, -dy, -dz of our neighbour
+        chunk->neighbours[Chunk::NeighbourIndex(dx, dy, dz)] = (link ? neighbour : nullptr);
+        if(neighbour != nullptr)
+            neighbour->neighbours[Chunk::NeighbourIndex(-dx, -dy, -dz)] = (link ? chunk : nullptr);
+    }
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <vector> // For std::vector
+
+class Chunk;
+
+
+
+// Finds loaded chunks by their integer chunk position. An open addressing hash
+// table (linear probing) maps positions to chunks, and a plain list of the
+// chunks makes looping over all of them cheap. Looking up a position that
+// isn't loaded returns nullptr, it never adds anything.
+//
+// Adding and removing chunks also keeps every chunk's neighbour pointers up to
+// date, so code that walks from a chunk to the chunks around it doesn't need
+// to look anything up at all
+class ChunkIndex
+{
+public:
+    ChunkIndex();
+
+    // The chunk at a chunk position, or nullptr if there isn't one loaded
+    Chunk *Get(glm::ivec3 position) const
+    {
+        GLuint slot = Hash(position) & slotMask;
+        while(slots[slot].chunk != nullptr)
+        {
+            if(slots[slot].position == position)
+                return slots[slot].chunk;
+            slot = (slot + 1) & slotMask;
+        }
+        return nullptr;
+    }
+
+    // Add a chunk at its own chunk position. There must not already be one there
+    void Add(Chunk *chunk);
+    // Take a chunk out of the index. Does not delete it
+    void Remove(Chunk *chunk);
+    // How many chunks are loaded
+    GLuint Size() const { return chunkList.size(); }
+    GLboolean Empty() const { return chunkList.empty(); }
+
+    // Loop over every loaded chunk, in no particular order. Don't add or
+    // remove chunks while looping
+    std::vector<Chunk *>::const_iterator begin() const { return chunkList.begin(); }
+    std::vector<Chunk *>::const_iterator end() const { return chunkList.end(); }
+
+private:
+    struct Slot
+    {
+        glm::ivec3 position;
+        Chunk *chunk = nullptr; // nullptr means the slot is empty
+    };
+    std::vector<Slot> slots;  // Always a power of 2 long, and never more than half full
+    GLuint slotMask;
+    std::vector<Chunk *> chunkList;
+
+    static GLuint Hash(glm::ivec3 position)
+    {
+        // Mix each axis with a different large odd number so nearby chunks spread out
+        return (GLuint)position.x * 0x8DA6B343u ^ (GLuint)position.y * 0xD8163841u ^ (GLuint)position.z * 0xCB1AB31Fu;
+    }
+    // Put a chunk in the hash table only
+    void Insert(Chunk *chunk);
+    // Double the hash table and reinsert everything
+    void Grow();
+    // Point the chunk and its loaded neighbours at each other, or at nullptr when unlinking
+    void LinkNeighbours(Chunk *chunk, GLboolean link);
+};
@@ -1,19 +1,27 @@
 #include "ChunkManager.hpp"
 #include "Biomes.hpp"
+#include "JobSystem.hpp"
+#include "ChunkBuffers.hpp"
+#include "LightEngine.hpp"
+#include "Profiler.hpp"
 
 #include <FastNoise/FastNoise.h> // Noise generator
 #include <vector> // For std::vector
-#include <cmath> // Sqrt and pow
-#include <glm/gtx/vector_angle.hpp> // glm::rotate
+#include <cmath> // For floor and abs
+#include <algorithm> // For std::stable_sort
+#include <random> // For std::minstd_rand
 
 
 
-// Generate all of our chunks
+// Set up world generation and start loading chunks around the origin
 void ChunkManager::GenerateChunks()
 {
     if(World::seedLogging) // If we have seed logging enabled, print out the seed
         std::cout << "World seed: " << seed << std::endl;
-    srand(seed); // Seed random number generator with our world seed
+
+    // Every seed is its own world, with its own saves
+    if(World::worldSaving)
+        regionStorage.Open(std::string(World::saveDirectory) + "/" + std::to_string(seed));
 
     // Initialize FastNoise2
     auto OpenSimplex = FastNoise::New<FastNoise::OpenSimplex2>();
@@ -33,198 +41,547 @@ void ChunkManager::GenerateChunks()
     auto add = FastNoise::New<FastNoise::Add>();
     add->SetLHS(DomainScale);
     add->SetRHS(PositionOutput);
+    biomeNoise = add;
+
+    // Every chunk column within our load distance, nearest first. Each frame we
+    // walk this from the camera's chunk, so the closest missing chunks load first
+    GLint loadDistance = World::chunkDiameter;
+    for(GLint z = -1 * loadDistance; z <= loadDistance; z++)
+        for(GLint x = -1 * loadDistance; x <= loadDistance; x++)
+            if(x * x + z * z <= loadDistance * loadDistance)
+                loadOrder.push_back(glm::ivec2(x, z));
+    std::stable_sort(loadOrder.begin(), loadOrder.end(), [](const glm::ivec2 &a, const glm::ivec2 &b) {
+        return a.x * a.x + a.y * a.y < b.x * b.x + b.y * b.y;
+    });
+
+    StreamChunks(glm::vec3(0.0f, 0.0f, 0.0f));
+}
+
 
-    // Vector structure to hold our noise
-    std::vector<float> noiseOutput((chunkDiameter * 2 + 1) * (chunkDiameter * 2 + 1));
-    // Index for when we loop through our noiseOutput 
-    GLint noiseIndex = 0;
 
-    // Generate 2D heightmap noise
-    if(World::chunkDiameter > 0 )
-        add->GenUniformGrid2D(noiseOutput.data(), 0, 0, chunkDiameter * 2 + 1, chunkDiameter * 2 + 1, 0.0015f, seed);
+GLuint ChunkManager::BiomeAt(GLint x, GLint z)
+{
+    const GLuint biomeCount = sizeof(BiomeConfiguration) / sizeof(Biome_Configuration);
+    if(World::randomBiomeGenerationPerChunk)
+    {
+        // Random, but the same every time this chunk loads
+        std::minstd_rand biomeRandom(seed ^ (GLuint)x * 73856093u ^ (GLuint)z * 19349663u);
+        return biomeRandom() % biomeCount;
+    }
 
-    GLuint noise = 0;
+    // Sample the biome noise where this chunk's cell used to be in the old
+    // fixed grid (which started at -chunkDiameter), so worlds look the same as before
     GLfloat heightMax = 64.0f;
     GLfloat heightMin = 1.0f;
+    GLfloat noise = biomeNoise->GenSingle2D((x + (GLint)World::chunkDiameter) * 0.0015f, (z + (GLint)World::chunkDiameter) * 0.0015f, seed);
+    return ((GLint)((abs(noise) + 1) / 2 * (heightMax - heightMin) + heightMin) % ((GLint)heightMax - 1) + 1) % (biomeCount - 1); // mod biome count
+}
+
 
-    // Generate our chunks if they have not been generated yet
-    if(chunks_.empty())
+
+void ChunkManager::StreamChunks(glm::vec3 cameraPosition)
+{
+    // Take in chunks whose terrain the workers have finished
     {
-        for(GLint z = -1 * chunkDiameter; z <= chunkDiameter; z++)
+        std::lock_guard<std::mutex> lock(generatedChunksMutex);
+        for(Chunk *chunk : generatedChunks)
         {
-            for(GLint x = -1 * chunkDiameter; x <= chunkDiameter; x++)
-            {
-                // Set our new 2D noise
-                if(World::chunkDiameter > 0 )
-                    noise = ((GLint)((abs(noiseOutput[noiseIndex++]) + 1) / 2 * (heightMax - heightMin) + heightMin) % ((GLint)heightMax - 1) + 1) % (sizeof(BiomeConfiguration) / sizeof(Biome_Configuration) - 1); // mod biome count
-                for(GLint y = 0; y < World::chunksTall; y++)
-                {
-                    glm::vec3 position = glm::vec3(x, y, z);
-                    if(World::randomBiomeGenerationPerChunk)
-                        chunks_[position] = new Chunk(x, y, z, rand() % (sizeof(BiomeConfiguration) / sizeof(Biome_Configuration)));
-                    else
-                        chunks_[position] = new Chunk(x, y, z, noise);
-                }
-            }
+            chunk->generating = false;
+            chunk->generated = true;
+            ExchangeFeatureEdits(chunk);
         }
+        // Columns whose last chunk just came in get their light
+        for(Chunk *chunk : generatedChunks)
+            lightEngine_.LightColumn(chunk);
+        generatedChunks.clear();
+    }
 
+    GLint cameraChunkX = (GLint)floor(cameraPosition.x / (World::chunkWidthX * World::blockSize));
+    GLint cameraChunkZ = (GLint)floor(cameraPosition.z / (World::chunkDepthZ * World::blockSize));
 
-        // Loop through our chunks and generate their blocks, passing in the 
-        // biomes on adjacent chunks
-        for(GLint z = -1 * chunkDiameter; z <= chunkDiameter; z++)
+    // Unload chunks that have left the unload distance. It is bigger than the load
+    // distance, so chunks don't flicker in and out as the camera crosses a border
+    GLint unloadDistance = World::chunkUnloadDistance;
+    std::vector<Chunk *> unloadChunks;
+    for(Chunk *chunk : chunks_)
+    {
+        GLint dx = chunk->chunk_position_x - cameraChunkX;
+        GLint dz = chunk->chunk_position_z - cameraChunkZ;
+        // A worker is still writing into chunks that are generating, so they wait
+        if(dx * dx + dz * dz > unloadDistance * unloadDistance && !chunk->generating)
+            unloadChunks.push_back(chunk);
+    }
+    for(Chunk *chunk : unloadChunks)
+    {
+        if(chunk->edited)
+            regionStorage.Save(chunk->GetPosition(), chunk->Save());
+        chunks_.Remove(chunk);
+        ReleaseMesh(chunk);
+        delete chunk;
+    }
+
+    // Create the closest missing chunks and queue their terrain on the workers.
+    // Each one is an allocation plus a job that generates it or reads it back from its
+    // region file, so we cap how many we make per frame to keep the job queue short
+    GLuint chunksLoaded = 0;
+    for(const glm::ivec2 &offset : loadOrder)
+    {
+        if(chunksLoaded == World::chunkLoadsPerFrame)
+            break;
+
+        GLint x = cameraChunkX + offset.x;
+        GLint z = cameraChunkZ + offset.y;
+        for(GLint y = 0; y < (GLint)World::chunksTall; y++)
         {
-            for(GLint x = -1 * chunkDiameter; x <= chunkDiameter; x++)
-            {
-                for(GLint y = 0; y < World::chunksTall; y++)
-                {
-                    glm::vec3 position = glm::vec3(x, y, z);
-                    // Get the biomes for adjacent chunks
-                    GLint biomeTypeIDPosX = (x+1 <= chunkDiameter ? chunks_[glm::vec3(x+1, y, z)]->biomeID : Biomes::Null_Biome);
-                    GLint biomeTypeIDPosZ = (z+1 <= chunkDiameter ? chunks_[glm::vec3(x, y, z+1)]->biomeID : Biomes::Null_Biome);
-                    GLint biomeTypeIDNegX = (x-1 >= -1 * chunkDiameter ? chunks_[glm::vec3(x-1, y, z)]->biomeID : Biomes::Null_Biome);
-                    GLint biomeTypeIDNegZ = (z-1 >= -1 * chunkDiameter ? chunks_[glm::vec3(x, y, z-1)]->biomeID : Biomes::Null_Biome);
-                    chunks_[position]->GenerateBlocks(seed, biomeTypeIDPosX, biomeTypeIDPosZ, biomeTypeIDNegX, biomeTypeIDNegZ);
-                }
-            }
+            if(chunks_.Get(glm::ivec3(x, y, z)) != nullptr)
+                continue;
+
+            Chunk *chunk = new Chunk(x, y, z, BiomeAt(x, z));
+            chunk->generating = true;
+            chunks_.Add(chunk);
+            chunksLoaded++;
+
+            // Biomes come from noise, not from loaded chunks, so neighbours
+            // that aren't loaded yet still get the right biome
+            GLint biomeTypeIDPosX = BiomeAt(x+1, z);
+            GLint biomeTypeIDPosZ = BiomeAt(x, z+1);
+            GLint biomeTypeIDNegX = BiomeAt(x-1, z);
+            GLint biomeTypeIDNegZ = BiomeAt(x, z-1);
+            GLuint chunkSeed = seed;
+            JobSystem::Instance().Submit([this, chunk, chunkSeed, biomeTypeIDPosX, biomeTypeIDPosZ, biomeTypeIDNegX, biomeTypeIDNegZ]() {
+                ProfileScope generation(Profile_Generation);
+                // Chunks the player edited come back from their save, the rest regenerate
+                SavedChunk saved;
+                if(regionStorage.Load(chunk->GetPosition(), saved))
+                    chunk->Load(std::move(saved));
+                else
+                    chunk->GenerateBlocks(chunkSeed, biomeTypeIDPosX, biomeTypeIDPosZ, biomeTypeIDNegX, biomeTypeIDNegZ);
+
+                std::lock_guard<std::mutex> lock(generatedChunksMutex);
+                generatedChunks.push_back(chunk);
+            });
         }
     }
+
+    if(World::chunkGenerationLogging && chunksLoaded > 0)
+        std::cout << "Loaded " << chunksLoaded << " chunks, " << chunks_.Size() << " chunks in memory" << std::endl;
+}
+
+
+
+GLboolean ChunkManager::NeighboursLit(Chunk *chunk)
+{
+    for(GLint dz = -1; dz <= 1; dz++)
+    for(GLint dy = -1; dy <= 1; dy++)
+    for(GLint dx = -1; dx <= 1; dx++)
+    {
+        // Nothing is ever loaded above or below the world
+        GLint y = chunk->chunk_position_y + dy;
+        if(y < 0 || y >= (GLint)World::chunksTall)
+            continue;
+        Chunk *neighbour = chunk->neighbours[Chunk::NeighbourIndex(dx, dy, dz)];
+        if(neighbour == nullptr || !neighbour->lit)
+            return false;
+    }
+    return true;
 }
 
 
 
-// Returns area of triangle given 3 points
-GLfloat area(glm::vec3 pos1, glm::vec3 pos2, glm::vec3 pos3)
+GLuint ChunkManager::LODLevelFor(Chunk *chunk, glm::vec3 cameraPosition, GLfloat projectionScale)
 {
-    return abs((pos1.x*(pos2.z-pos3.z) + pos2.x*(pos3.z-pos1.z)+ pos3.x*(pos1.z-pos2.z))/2.0);
+    if(!World::levelOfDetail)
+        return 0;
+
+    // Whole columns share a level, so chunks only ever meet other levels on their sides
+    GLfloat closestX = glm::clamp(cameraPosition.x, chunk->offset_x, chunk->offset_x + World::chunkWidthX * World::blockSize);
+    GLfloat closestZ = glm::clamp(cameraPosition.z, chunk->offset_z, chunk->offset_z + World::chunkDepthZ * World::blockSize);
+    GLfloat distance = glm::length(glm::vec2(cameraPosition.x - closestX, cameraPosition.z - closestZ));
+
+    // A cell 2^level blocks wide can stick out up to 2^level - 1 blocks past the real surface
+    GLuint level = 0;
+    while(level < World::maxLODLevel && ((1u << (level + 1)) - 1) * World::blockSize * projectionScale <= World::lodPixelError * distance)
+        level++;
+    return level;
 }
 
 
 
-// Render all of our generated chunks
-void ChunkManager::RenderChunks(glm::vec3 cameraPosition, glm::vec3 cameraOrientation, GLuint cubeShaderProgramID)
+GLboolean ChunkManager::MeshIsEmpty(Chunk *chunk)
 {
-    // Only do the frustum culling math if the cameraPosition 
-    // and cameraOrientation has actually moved from the previous frame
-    if(previousCameraPosition != cameraPosition || previousCameraOrientation != cameraOrientation)
-    {
-        // Make camera position 10 blocks behind what it actually is
-        GLfloat posAdjustmentAmount = World::blockSize * World::chunkSize;
-        cameraPosition.x = (-1 * cameraOrientation.x) * posAdjustmentAmount + cameraPosition.x;
-        cameraPosition.z = (-1 * cameraOrientation.z) * posAdjustmentAmount + cameraPosition.z;
-
-        GLfloat rotateAngle = 70.0f;
-        // // If a chunk is closer than this distance, we will render it even if its behind us
-        GLfloat minRenderDistance = World::chunkSize * World::blockSize;//(World::chunkSize / (World::blockSize > 1 ? World::blockSize : (1 / World::blockSize))) * 2 * (World::blockSize > 1 ? World::blockSize : (1 / World::blockSize)); 
-
-        cameraOrientation = glm::normalize(cameraOrientation);
-        glm::vec3 cameraRotatedHorizontalPositive = glm::rotate(cameraOrientation, glm::radians(rotateAngle), glm::vec3(0, 1, 0));
-        glm::vec3 cameraRotatedHorizontalNegative = glm::rotate(cameraOrientation, glm::radians(-rotateAngle), glm::vec3(0, 1, 0));
-
-        GLfloat pointOffset = World::BlockRenderDistance * 3;
-        glm::vec3 triPoint1 = glm::vec3(pointOffset * cameraRotatedHorizontalPositive.x + cameraPosition.x, 0, pointOffset * cameraRotatedHorizontalPositive.z + cameraPosition.z);
-        glm::vec3 triPoint2 = glm::vec3(pointOffset * cameraRotatedHorizontalNegative.x + cameraPosition.x, 0, pointOffset * cameraRotatedHorizontalNegative.z + cameraPosition.z);
-
-        GLfloat totalArea = area(cameraPosition, triPoint1, triPoint2);
-
-        glm::vec3 chunkPosition = glm::vec3(0.0f, 0.0f, 0.0f);
-
-        // Distance from chunk to camera
-        GLfloat distanceBottomLeftCorner = 0.0f;
-        GLfloat distanceTopLeftCorner = 0.0f;
-        GLfloat distanceBottomRightCorner = 0.0f;
-        GLfloat distanceTopRightCorner = 0.0f;
-        // Render all of our chunks
-        for(GLint x = -1 * chunkDiameter; x <= chunkDiameter; x++)
+    GLint blockTypeID;
+    if(!chunk->chunkBlocks.IsUniform(blockTypeID))
+        return false;
+    if(blockTypeID == BlockRegistry::Air)
+        return true;
+    if(blockRegistry.IsTransparent(blockTypeID))
+        return false;
+
+    // A solid chunk only shows faces where a neighbour lets light in. Below the
+    // world counts as solid, above it as open sky
+    static const GLint faceOffsets[6][3] = { {0, 0, -1}, {0, 0, 1}, {-1, 0, 0}, {1, 0, 0}, {0, 1, 0}, {0, -1, 0} };
+    for(const GLint *offset : faceOffsets)
+    {
+        GLint y = chunk->chunk_position_y + offset[1];
+        if(y < 0)
+            continue;
+        if(y >= (GLint)World::chunksTall)
+            return false;
+        Chunk *neighbour = chunk->neighbours[Chunk::NeighbourIndex(offset[0], offset[1], offset[2])];
+        GLint neighbourBlockTypeID;
+        if(!neighbour->chunkBlocks.IsUniform(neighbourBlockTypeID) || blockRegistry.IsTransparent(neighbourBlockTypeID))
+            return false;
+    }
+    return true;
+}
+
+
+
+ChunkManager::~ChunkManager()
+{
+    // Mesh jobs hand their results back to us, so let them finish first
+    JobSystem::Instance().WaitForIdle();
+    for(MeshJob *job : finishedMeshes)
+        delete job;
+    for(MeshJob *job : spareMeshJobs)
+        delete job;
+
+    // Edited chunks are only saved as they unload, so save the ones still loaded.
+    // Destroying regionStorage then waits for all of them to be written
+    for(Chunk *chunk : chunks_)
+        if(chunk->edited && chunk->generated)
+            regionStorage.Save(chunk->GetPosition(), chunk->Save());
+}
+
+
+
+void ChunkManager::UpdateMeshes(glm::vec3 cameraPosition, GLfloat projectionScale)
+{
+    {
+        ProfileScope uploading(Profile_MeshUploads);
+        // Take as many finished meshes as fit in this frame's upload budget,
+        // always at least one so a big mesh can't hold up the queue forever
+        uploads.clear();
         {
-            for(GLint z = -1 * chunkDiameter; z <= chunkDiameter; z++)
+            std::lock_guard<std::mutex> lock(finishedMeshesMutex);
+            GLuint uploadBytes = 0;
+            while(!finishedMeshes.empty())
             {
-                for(GLint y = 0; y < World::chunksTall; y++)
-                {
-                    // Check if this chunk is in viewing frustum
-                    // Use distance formula to see if chunk in render distance
-                    chunkPosition = glm::vec3((GLfloat)x * (GLfloat)World::chunkSize * World::blockSize, (GLfloat)y * (GLfloat)World::chunkSize * World::blockSize, (GLfloat)z * (GLfloat)World::chunkSize * World::blockSize);
-                    distanceBottomLeftCorner = sqrt(pow(chunkPosition.x - cameraPosition.x, 2) + pow(chunkPosition.z - cameraPosition.z, 2));
-                    distanceTopLeftCorner = sqrt(pow(chunkPosition.x - cameraPosition.x, 2) + pow((chunkPosition.z) + ((GLfloat)World::chunkDepthZ * World::blockSize) - World::blockSize - cameraPosition.z, 2));
-                    distanceBottomRightCorner = sqrt(pow((chunkPosition.x) + ((GLfloat)World::chunkWidthX * World::blockSize) - World::blockSize - cameraPosition.x, 2) + pow(chunkPosition.z - cameraPosition.z, 2));
-                    distanceTopRightCorner = sqrt(pow((chunkPosition.x) + ((GLfloat)World::chunkWidthX * World::blockSize) - World::blockSize - cameraPosition.x, 2) + pow(chunkPosition.z + ((GLfloat)World::chunkDepthZ * World::blockSize) - World::blockSize - cameraPosition.z, 2));
-
-                    // If the distance from the camera to the chunk is less than our minimum distance, 
-                    // we want to always render it even if the chunk is behind us
-                    if(distanceBottomLeftCorner <= minRenderDistance || distanceBottomRightCorner <= minRenderDistance || distanceTopLeftCorner <= minRenderDistance || distanceTopRightCorner <= minRenderDistance)
-                    {
-                        chunks_[glm::vec3(x, y, z)]->RenderChunk(cubeShaderProgramID, true);
-                        chunks_[glm::vec3(x, y, z)]->shouldRender = true;
-                        chunksPassed++;
-                    }
-                    else if(distanceBottomLeftCorner <= World::BlockRenderDistance || distanceBottomRightCorner <= World::BlockRenderDistance || distanceTopLeftCorner <= World::BlockRenderDistance || distanceTopRightCorner <= World::BlockRenderDistance)
-                    {
-                        // Check if our point is inside triangle
-                        glm::vec3 point = glm::vec3(x * (World::chunkWidthX * World::blockSize), 0, z * (World::chunkDepthZ * World::blockSize));
-                        GLfloat totalPointArea = area(cameraPosition, triPoint2, point) + area(cameraPosition, triPoint1, point) + area(triPoint2, triPoint1, point);
-
-                        if(abs(totalPointArea - totalArea) <= 5)
-                        {
-                            chunks_[glm::vec3(x, y, z)]->RenderChunk(cubeShaderProgramID, true);
-                            chunks_[glm::vec3(x, y, z)]->shouldRender = true;
-                            chunksPassed++;
-                        }
-                        else
-                        {
-                            chunks_[glm::vec3(x, y, z)]->shouldRender = false;
-                            chunksFailed++;
-                        }
-                    }
-                    else
-                    {
-                        chunks_[glm::vec3(x, y, z)]->shouldRender = false;
-                        chunksFailed++;
-                    }
-                }
+                const ChunkMesh &mesh = finishedMeshes.front()->mesh;
+                GLuint meshBytes = sizeof(GLuint) * (mesh.opaqueVertices.size() + mesh.transparentVertices.size());
+                if(!uploads.empty() && uploadBytes + meshBytes > World::meshUploadBudget)
+                    break;
+                uploadBytes += meshBytes;
+                uploads.push_back(finishedMeshes.front());
+                finishedMeshes.pop_front();
             }
         }
-        previousCameraPosition = cameraPosition;
-        previousCameraOrientation = cameraOrientation;
+
+        for(MeshJob *job : uploads)
+        {
+            Chunk *chunk = chunks_.Get(job->position);
+            // Only upload the newest mesh we asked for
+            if(chunk != nullptr && chunk->meshRequestID == job->requestID)
+            {
+                UploadMesh(chunk, job->mesh);
+                chunk->meshRequestID = 0;
+            }
+            spareMeshJobs.push_back(job);
+        }
+    }
+
+    // Queue mesh jobs for chunks that changed. A chunk that changes again while
+    // its job is running gets queued once that job's mesh is uploaded
+    ProfileScope queueing(Profile_MeshQueue);
+    GLuint jobsQueued = 0;
+    for(Chunk *chunk : chunks_)
+    {
+        if(jobsQueued == World::meshJobsPerFrame)
+            break;
+        // A chunk whose level of detail changed is rebuilt whole at the new level
+        GLuint lodLevel = LODLevelFor(chunk, cameraPosition, projectionScale);
+        if(lodLevel != chunk->lodLevel)
+            chunk->RebuildMesh();
+        if(chunk->dirtySlabs == 0 || chunk->meshRequestID != 0)
+            continue;
+        // Wait until the chunk and everything around it has terrain and light, so
+        // its border faces, AO and light come out right the first time. Chunks on
+        // the edge of the loaded area stay unmeshed until the area grows past them
+        if(!NeighboursLit(chunk))
+            continue;
+
+        // Chunks with nothing to draw skip the snapshot and the worker altogether
+        if(MeshIsEmpty(chunk))
+        {
+            chunk->dirtySlabs = 0;
+            chunk->lodLevel = lodLevel;
+            UploadMesh(chunk, ChunkMesh());
+            continue;
+        }
+
+        // Only the slabs that changed are rebuilt, the rest of the chunk's mesh stays
+        // in the arena. Chunks with their own buffers upload their mesh in one piece,
+        // and level of detail meshes are cheap enough to always build whole
+        GLuint slabMask = (World::multiDrawRendering && lodLevel == 0 ? chunk->dirtySlabs : World::allMeshSlabs);
+        MeshJob *job;
+        if(spareMeshJobs.empty())
+        {
+            job = new MeshJob();
+        }
+        else
+        {
+            job = spareMeshJobs.back();
+            spareMeshJobs.pop_back();
+        }
+        job->position = chunk->GetPosition();
+        job->requestID = nextMeshRequestID++;
+        job->slabMask = slabMask;
+        job->lodLevel = lodLevel;
+        job->greedyMeshing = chunk->greedyMeshing;
+        chunk->TakeSnapshot(job->snapshot, slabMask);
+        job->mesh.Clear();
+        chunk->dirtySlabs = 0;
+        chunk->meshRequestID = job->requestID;
+        chunk->lodLevel = lodLevel;
+        jobsQueued++;
+
+        // Capturing only two pointers keeps the job small enough for std::function to store in place
+        JobSystem::Instance().Submit([this, job]() {
+            ProfileScope build(Profile_MeshBuilds);
+            if(job->lodLevel > 0)
+                ChunkMesher::BuildLODMesh(job->snapshot, job->lodLevel, job->mesh);
+            else
+                ChunkMesher::BuildMesh(job->snapshot, job->greedyMeshing, World::ambientOcclusionEnabled, job->slabMask, job->mesh);
+
+            std::lock_guard<std::mutex> lock(finishedMeshesMutex);
+            finishedMeshes.push_back(job);
+        });
+    }
+}
+
+
+
+// Render all of our loaded chunks that the camera can see
+void ChunkManager::RenderChunks(const glm::mat4 &viewProjectionMatrix, Shader &cubeShader)
+{
+    {
+        ProfileScope culling(Profile_Culling);
+        CullChunks(viewProjectionMatrix);
     }
-    else // Run this code if the camera orientation and position has not changed from previous frame
+
+    // With every mesh in the shared arena, each pass is a single multi-draw call
+    if(World::multiDrawRendering)
     {
-        for(GLint x = -1 * chunkDiameter; x <= chunkDiameter; x++)
+        for(GLboolean opaque : { GL_TRUE, GL_FALSE })
         {
-            for(GLint z = -1 * chunkDiameter; z <= chunkDiameter; z++)
+            ProfileScope pass(opaque ? Profile_OpaquePass : Profile_TransparentPass);
+            drawFirsts.clear();
+            drawCounts.clear();
+            for(GLuint i = 0; i < drawableChunks.size(); i++)
             {
-                for(GLint y = 0; y < World::chunksTall; y++)
+                if(!chunkVisible[i])
+                    continue;
+                const ChunkArena::Allocation *allocations = (opaque ? drawableChunks[i]->opaqueAllocations : drawableChunks[i]->transparentAllocations);
+                for(GLuint slab = 0; slab < World::meshSlabCount; slab++)
                 {
-                    chunks_[glm::vec3(x, y, z)]->RenderChunk(cubeShaderProgramID, true);
+                    if(allocations[slab].vertexCount == 0)
+                        continue;
+                    drawFirsts.push_back(ChunkArena::FirstVertex(allocations[slab]));
+                    drawCounts.push_back(allocations[slab].vertexCount);
                 }
             }
+            chunkArena_.Draw(drawFirsts, drawCounts);
+        }
+        return;
+    }
+
+    // Every chunk sets its offset through the same cached uniform location
+    GLint chunkOffsetLocation = cubeShader.GetUniformLocation("chunkOffset");
+
+    // Render opaque
+    {
+        ProfileScope pass(Profile_OpaquePass);
+        for(GLuint i = 0; i < drawableChunks.size(); i++)
+        {
+            Chunk *chunk = drawableChunks[i];
+            if(!chunk->shouldRender || chunk->opaqueVertexCount == 0)
+                continue;
+            glUniform3f(chunkOffsetLocation, chunk->offset_x, chunk->offset_y, chunk->offset_z);
+            chunk->buffers->Draw(true, chunk->opaqueVertexCount);
         }
     }
 
     // Render transparent
-    for(GLint x = -1 * chunkDiameter; x <= chunkDiameter; x++)
+    ProfileScope pass(Profile_TransparentPass);
+    for(Chunk *chunk : drawableChunks)
+    {
+        if(chunk->shouldRender && chunk->transparentVertexCount > 0)
+        {
+            glUniform3f(chunkOffsetLocation, chunk->offset_x, chunk->offset_y, chunk->offset_z);
+            chunk->buffers->Draw(false, chunk->transparentVertexCount);
+        }
+    }
+}
+
+
+
+// Find which loaded chunks with a mesh the camera can see. Fills drawableChunks and
+// chunkVisible, and sets each chunk's shouldRender
+void ChunkManager::CullChunks(const glm::mat4 &viewProjectionMatrix)
+{
+    frustum.Update(viewProjectionMatrix);
+
+    // Gather the bounding boxes of every chunk with something to draw, one
+    // array per corner coordinate so the frustum can test them in batches
+    drawableChunks.clear();
+    boxMinX.clear(); boxMinY.clear(); boxMinZ.clear();
+    boxMaxX.clear(); boxMaxY.clear(); boxMaxZ.clear();
+    for(Chunk *chunk : chunks_)
+    {
+        chunk->shouldRender = false;
+        if(!chunk->HasMesh())
+            continue;
+
+        // Full width and depth, but only as tall as the blocks actually in the chunk
+        drawableChunks.push_back(chunk);
+        boxMinX.push_back(chunk->offset_x);
+        boxMinY.push_back(chunk->offset_y + chunk->occupiedMinY * World::blockSize);
+        boxMinZ.push_back(chunk->offset_z);
+        boxMaxX.push_back(chunk->offset_x + World::chunkWidthX * World::blockSize);
+        boxMaxY.push_back(chunk->offset_y + (chunk->occupiedMaxY + 1) * World::blockSize);
+        boxMaxZ.push_back(chunk->offset_z + World::chunkDepthZ * World::blockSize);
+    }
+
+    chunkVisible.resize(drawableChunks.size());
+    GLuint visibleCount = frustum.CullBoxes(boxMinX.data(), boxMinY.data(), boxMinZ.data(), boxMaxX.data(), boxMaxY.data(), boxMaxZ.data(), drawableChunks.size(), chunkVisible.data());
+
+    cullingStats.chunksTested = drawableChunks.size();
+    cullingStats.chunksPassed = visibleCount;
+    cullingStats.chunksCulled = drawableChunks.size() - visibleCount;
+
+    for(GLuint i = 0; i < drawableChunks.size(); i++)
+        drawableChunks[i]->shouldRender = chunkVisible[i];
+}
+
+
+
+ChunkManager::CullingStats ChunkManager::GetCullingStats() const
+{
+    return cullingStats;
+}
+
+
+
+// Send a finished mesh to the GPU, replacing the slabs of the chunk's mesh it was built for
+void ChunkManager::UploadMesh(Chunk *chunk, const ChunkMesh &mesh)
+{
+    for(GLuint slab = 0; slab < World::meshSlabCount; slab++)
     {
-        for(GLint z = -1 * chunkDiameter; z <= chunkDiameter; z++)
+        if(!(mesh.slabMask & (1u << slab)))
+            continue;
+        chunk->slabMinY[slab] = mesh.slabMinY[slab];
+        chunk->slabMaxY[slab] = mesh.slabMaxY[slab];
+    }
+
+    if(World::multiDrawRendering)
+    {
+        // Swap the chunk's old slabs in the shared arena for the new ones
+        glm::vec3 chunkOffset = glm::vec3(chunk->offset_x, chunk->offset_y, chunk->offset_z);
+        chunk->opaqueVertexCount = 0;
+        chunk->transparentVertexCount = 0;
+        for(GLuint slab = 0; slab < World::meshSlabCount; slab++)
         {
-            for(GLint y = 0; y < World::chunksTall; y++)
+            if(mesh.slabMask & (1u << slab))
             {
-                if(chunks_[glm::vec3(x, y, z)]->shouldRender)
-                {
-                    chunks_[glm::vec3(x, y, z)]->RenderChunk(cubeShaderProgramID, false);
-                }
+                GLuint opaqueStart = (slab > 0 ? mesh.opaqueSlabEnds[slab - 1] : 0);
+                GLuint transparentStart = (slab > 0 ? mesh.transparentSlabEnds[slab - 1] : 0);
+                chunkArena_.Free(chunk->opaqueAllocations[slab]);
+                chunkArena_.Free(chunk->transparentAllocations[slab]);
+                chunk->opaqueAllocations[slab] = chunkArena_.Allocate(mesh.opaqueVertices.data() + opaqueStart, mesh.opaqueSlabEnds[slab] - opaqueStart, chunkOffset);
+                chunk->transparentAllocations[slab] = chunkArena_.Allocate(mesh.transparentVertices.data() + transparentStart, mesh.transparentSlabEnds[slab] - transparentStart, chunkOffset);
             }
+            chunk->opaqueVertexCount += chunk->opaqueAllocations[slab].vertexCount;
+            chunk->transparentVertexCount += chunk->transparentAllocations[slab].vertexCount;
         }
     }
-    // If our frustum culling logging is enabled, std::cout our results
-    if(World::frustumCullingLogging)
+    else
     {
-        std::cout << "Chunks Passed: " << chunksPassed << " Chunks Failed: " << chunksFailed << std::endl;
-        chunksFailed = 0;
-        chunksPassed = 0;
+        // Always the whole mesh, see UpdateMeshes
+        if(chunk->buffers == nullptr)
+            chunk->buffers = new ChunkBuffers();
+        chunk->buffers->Upload(mesh);
+        chunk->opaqueVertexCount = mesh.opaqueVertices.size() / ChunkMesher::vertexStride;
+        chunk->transparentVertexCount = mesh.transparentVertices.size() / ChunkMesher::vertexStride;
     }
-    else
+
+    chunk->occupiedMinY = World::chunkHeightY;
+    chunk->occupiedMaxY = -1;
+    for(GLuint slab = 0; slab < World::meshSlabCount; slab++)
     {
-        chunksFailed = 0;
-        chunksPassed = 0;
+        chunk->occupiedMinY = std::min(chunk->occupiedMinY, chunk->slabMinY[slab]);
+        chunk->occupiedMaxY = std::max(chunk->occupiedMaxY, chunk->slabMaxY[slab]);
     }
 }
 
 
+
+// Trees can reach over chunk borders, and the chunks on either side generate in
+// any order. Each chunk keeps the blocks its trees put in its neighbours, so
+// whichever of two neighbours finishes second does the handing over. Main thread only
+void ChunkManager::ExchangeFeatureEdits(Chunk *chunk)
+{
+    for(GLuint i = 0; i < 27; i++)
+    {
+        Chunk *neighbour = chunk->neighbours[i];
+        if(neighbour == nullptr || neighbour == chunk || !neighbour->generated)
+            continue;
+
+        // Blocks the neighbour's trees put in us. Seen from the neighbour we are
+        // at the opposite offset, which is the mirrored neighbour index
+        for(const FeatureEdits &edits : neighbour->outgoingFeatureEdits)
+            if(edits.neighbourIndex == 26 - i)
+                ApplyFeatureEdits(chunk, edits, i);
+    }
+
+    // Blocks our trees put in neighbours that generated before us
+    for(const FeatureEdits &edits : chunk->outgoingFeatureEdits)
+    {
+        Chunk *neighbour = chunk->neighbours[edits.neighbourIndex];
+        if(neighbour != nullptr && neighbour->generated)
+            ApplyFeatureEdits(neighbour, edits, 26 - edits.neighbourIndex);
+    }
+}
+
+
+
+void ChunkManager::ApplyFeatureEdits(Chunk *chunk, const FeatureEdits &edits, GLuint sourceIndex)
+{
+    // A chunk loaded from a save may have had them put in before it was saved
+    if(chunk->appliedFeatureNeighbours & (1u << sourceIndex))
+        return;
+    chunk->appliedFeatureNeighbours |= 1u << sourceIndex;
+
+    for(const FeatureBlock &block : edits.blocks)
+    {
+        GLint previousBlockTypeID = chunk->chunkBlocks.GetBlockType(block.x, block.y, block.z);
+        FeaturePlacer::ApplyBlock(chunk->chunkBlocks, block);
+        // A chunk that isn't lit yet gets these blocks' light along with the rest of its column
+        if(chunk->lit)
+            lightEngine_.BlockChanged(chunk, block.x, block.y, block.z, previousBlockTypeID);
+        chunk->RebuildMeshAround(block.x, block.y, block.z);
+    }
+}
+
+
+
+// Give back everything the chunk's mesh holds on the GPU
+void ChunkManager::ReleaseMesh(Chunk *chunk)
+{
+    for(GLuint slab = 0; slab < World::meshSlabCount; slab++)
+    {
+        chunkArena_.Free(chunk->opaqueAllocations[slab]);
+        chunkArena_.Free(chunk->transparentAllocations[slab]);
+    }
+    delete chunk->buffers; // Releases the chunk's VAOs and VBOs
+    chunk->buffers = nullptr;
+}
@@ -2,36 +2,115 @@
 
 #include "WorldConstants.hpp"
 #include "Chunk.hpp"
+#include "Frustum.hpp"
+#include "RegionStorage.hpp"
+#include "ShaderManager.hpp"
 
+#include <FastNoise/FastNoise.h> // Noise generator
 #include <stdlib.h> // For generating random numbers
+#include <deque> // For std::deque
+#include <mutex> // For std::mutex
 
 
 
 class ChunkManager
 {
 public:
-    GLint chunkDiameter = World::chunkDiameter; // This is square root of chunkAmount
-    // Keep track of where each chunk is located with hash map
-    // std::unordered_map<glm::vec3, Chunk *> chunks_; // A hash map of chunks, where the key is a vec2
-
-    GLint max_chunks_x;
-    GLint max_chunks_z;
-
     GLuint seed = World::randomSeed ? rand() % 1000000 : World::defaultSeed; // The seed for the noise generator    
 
     // Empty constructor
     ChunkManager(){};
+    // Destructor, waits for jobs that still point at us and saves the chunks the player edited
+    ~ChunkManager();
 
-    // Generate the chunks
+    // Set up world generation and start loading the chunks around the origin
     void GenerateChunks();
-    // Once chunks are generated, render them
-    void RenderChunks(glm::vec3 cameraPosition, glm::vec3 cameraOrientation, GLuint cubeShaderProgramID);
+    // Load the closest missing chunks around the camera and unload the ones
+    // that got too far away. Call once per frame
+    void StreamChunks(glm::vec3 cameraPosition);
+    // Render the chunks inside the camera's view frustum
+    void RenderChunks(const glm::mat4 &viewProjectionMatrix, Shader &cubeShader);
+    // Upload the meshes workers have finished, within this frame's upload budget,
+    // then queue mesh jobs for chunks whose blocks or level of detail changed.
+    // projectionScale is Camera::GetProjectionScale. Never waits on a worker
+    void UpdateMeshes(glm::vec3 cameraPosition, GLfloat projectionScale);
+
+    // How many chunks the last RenderChunks call tested against the view
+    // frustum, and how many of those it drew or culled
+    struct CullingStats
+    {
+        GLuint chunksTested = 0;
+        GLuint chunksPassed = 0;
+        GLuint chunksCulled = 0;
+    };
+    CullingStats GetCullingStats() const;
 
 private:
-    glm::vec3 previousCameraPosition;
-    glm::vec3 previousCameraOrientation;
-    GLuint chunksPassed = 0;
-    GLuint chunksFailed = 0;
+    // Picks which biome a chunk column is
+    FastNoise::SmartNode<> biomeNoise;
+    // Chunk column offsets within our load distance, nearest first
+    std::vector<glm::ivec2> loadOrder;
+    // Chunks whose terrain a worker has finished, waiting for the main thread
+    std::vector<Chunk *> generatedChunks;
+    std::mutex generatedChunksMutex;
+    // Where edited chunks are saved, and loaded back from instead of regenerating
+    RegionStorage regionStorage;
+
+    // Frustum culling state, kept between frames so the arrays don't reallocate
+    Frustum frustum;
+    std::vector<Chunk *> drawableChunks;
+    std::vector<GLfloat> boxMinX, boxMinY, boxMinZ, boxMaxX, boxMaxY, boxMaxZ;
+    std::vector<GLubyte> chunkVisible;
+    // First vertex and vertex count of each visible mesh in the chunk arena, for one multi-draw
+    std::vector<GLint> drawFirsts;
+    std::vector<GLsizei> drawCounts;
+    CullingStats cullingStats;
+
+    // Everything one mesh job works with. Jobs are reused once their mesh is
+    // uploaded, so the snapshot's block storage and the mesh's vertex vectors
+    // keep their memory and steady remeshing doesn't touch the heap
+    struct MeshJob
+    {
+        glm::ivec3 position;     // Which chunk it belongs to
+        GLuint requestID;        // Dropped if the chunk has queued a newer mesh since
+        GLuint slabMask;         // Which slabs to build
+        GLuint lodLevel;         // 0 for a full detail mesh
+        GLboolean greedyMeshing;
+        ChunkSnapshot snapshot;  // Workers only ever see this copy, never the chunk itself
+        ChunkMesh mesh;
+    };
+    // Jobs whose mesh a worker has built, waiting for the main thread to upload it
+    std::deque<MeshJob *> finishedMeshes;
+    std::mutex finishedMeshesMutex;
+    // Jobs that are done with, ready for the next mesh. Main thread only
+    std::vector<MeshJob *> spareMeshJobs;
+    // The finished jobs taken for this frame's uploads, kept so it doesn't reallocate
+    std::vector<MeshJob *> uploads;
+    GLuint nextMeshRequestID = 1;
+
+    // Frustum cull the chunks with a mesh, filling drawableChunks and chunkVisible
+    void CullChunks(const glm::mat4 &viewProjectionMatrix);
+    // Which biome the chunk column at x, z is. Only depends on the seed
+    GLuint BiomeAt(GLint x, GLint z);
+    // Whether the chunk and every chunk around it have their terrain and light
+    GLboolean NeighboursLit(Chunk *chunk);
+    // The coarsest level of detail whose error stays under World::lodPixelError
+    // pixels on screen, going by the horizontal distance to the chunk's column
+    GLuint LODLevelFor(Chunk *chunk, glm::vec3 cameraPosition, GLfloat projectionScale);
+    // Whether the chunk can't have any visible faces without meshing it: it's all air,
+    // or all one opaque block with nothing but that around its sides. True for most
+    // of the chunks in a tall column
+    GLboolean MeshIsEmpty(Chunk *chunk);
+    // Hand over the blocks the chunk's trees put in its generated neighbours, and
+    // take in the ones theirs put in it. Called once the chunk's terrain is done
+    void ExchangeFeatureEdits(Chunk *chunk);
+    // Put the tree blocks of the neighbour at sourceIndex (see Chunk::NeighbourIndex) into
+    // the chunk and remesh what they touch, unless the chunk already has them
+    void ApplyFeatureEdits(Chunk *chunk, const FeatureEdits &edits, GLuint sourceIndex);
+    // Send a finished mesh to the GPU, replacing the one the chunk draws. Main thread only
+    void UploadMesh(Chunk *chunk, const ChunkMesh &mesh);
+    // Give back the chunk's arena pages or buffers, before it is deleted
+    void ReleaseMesh(Chunk *chunk);
 };
 
 
@@ -0,0 +1,501 @@
+#include "ChunkMesher.hpp"
+#include "BlockRegistry.hpp"
+
+#include <algorithm> // For std::min and std::max
+
+
+
+// For each face: which block axis (0 = x, 1 = y, 2 = z) the face points
+// along, and which axes the quad's width (u) and height (v) run along.
+// This has to match the face tables in shaders/cube.vert
+static const GLuint normalAxis[6] = { 2, 2, 0, 0, 1, 1 };
+static const GLuint uAxis[6]      = { 0, 1, 1, 2, 0, 0 };
+static const GLuint vAxis[6]      = { 1, 0, 2, 1, 2, 2 };
+
+// Chunk size along each axis, and how far apart neighbouring blocks along
+// that axis are in a face mask
+static const GLuint axisSize[3]   = { World::chunkWidthX, World::chunkHeightY, World::chunkDepthZ };
+static const GLuint axisStride[3] = { 1, World::chunkWidthX * World::chunkDepthZ, World::chunkWidthX };
+
+// Bits of a face key
+static const GLuint keyTextureMask = 31;        // 5 Bits, texture ID
+static const GLuint keyAOShift = 5;             // 8 Bits, AO level of each corner
+static const GLuint keyAOMask = 255;
+static const GLuint keyTransparentShift = 13;   // 1 Bit, which vertex list it goes in
+static const GLuint keyLightShift = 14;         // 8 Bits, packed light the face looks into
+static const GLuint keyLightMask = 255;
+static const GLuint keyPresent = 1u << 31;      // Keeps a face with key fields of all 0 from reading as "no face"
+
+// Where the light goes in the second word of a vertex or record
+static const GLuint vertexLightShift = 18;
+
+// Which of the face's 4 corners each of a quad's vertices is. Indexed quads
+// have one vertex per corner, the shared index buffer puts them in this order
+static const GLuint vertexCorners[6] = { 0, 1, 2, 1, 0, 3 };
+static const GLuint indexedCorners[4] = { 0, 1, 2, 3 };
+
+// Which block each face looks at, in BlockFaces order
+static const GLint faceOffsets[6][3] = { {0, 0, -1}, {0, 0, 1}, {-1, 0, 0}, {1, 0, 0}, {0, 1, 0}, {0, -1, 0} };
+
+// Scratch face masks, a chunk's worth for each face direction. Every visible
+// face is recorded here before any quads are made. GreedyMesh hands them back
+// zeroed, so they only get cleared once per thread
+static thread_local std::vector<GLuint> faceMasks;
+
+
+
+void ChunkMesher::EmitQuad(std::vector<GLuint> &vertices, GLuint x, GLuint y, GLuint z, GLuint faceIndex, GLuint textureID, GLuint faceAO, GLuint faceLight, GLuint width, GLuint height)
+{
+    GLuint packedPosition = (x | y << 6 | z << 12 | faceIndex << 18 | textureID << 24);
+    GLuint packedSize = ((width - 1) | (height - 1) << 5 | (faceLight & keyLightMask) << vertexLightShift);
+
+    // Grow once and write the whole quad in place
+    size_t quadStart = vertices.size();
+    vertices.resize(quadStart + quadSize);
+    GLuint *quad = vertices.data() + quadStart;
+    if(World::vertexPulling)
+    {
+        // The shader works out the corners from the one record
+        quad[0] = packedPosition;
+        quad[1] = packedSize | (faceAO & keyAOMask) << 10;
+        return;
+    }
+
+    const GLuint *corners = (drawsIndexed ? indexedCorners : vertexCorners);
+    for(GLuint vertexID = 0; vertexID < verticesPerQuad; vertexID++)
+    {
+        GLuint corner = corners[vertexID];
+        GLuint vertexAO = (faceAO >> (corner * 2)) & 3;
+        quad[vertexID * vertexStride] = packedPosition | corner << 21 | vertexAO << 29;
+        quad[vertexID * vertexStride + 1] = packedSize;
+    }
+}
+
+
+
+GLuint ChunkMesher::FaceKey(GLuint textureID, GLuint faceAO, GLuint faceLight, GLboolean transparent)
+{
+    return keyPresent | (textureID & keyTextureMask) | (faceAO & keyAOMask) << keyAOShift | (GLuint)(transparent ? 1 : 0) << keyTransparentShift | (faceLight & keyLightMask) << keyLightShift;
+}
+
+
+
+// Greedy mesh one face direction of a grid of cells scale blocks wide, laid
+// out like a chunk's face mask but with chunk size / scale cells a side. Only
+// the cell layers from yBegin up to (not including) yEnd are meshed. Quads come
+// out in blocks, so a level of detail mesh draws with the same vertex format.
+// Without merge every face becomes its own quad
+static void GreedyMeshCells(GLuint *faceMask, GLuint faceIndex, GLuint scale, GLboolean merge, GLuint yBegin, GLuint yEnd, std::vector<GLuint> &opaqueVertices, std::vector<GLuint> &transparentVertices)
+{
+    const GLuint n = normalAxis[faceIndex];
+    const GLuint u = uAxis[faceIndex];
+    const GLuint v = vAxis[faceIndex];
+    const GLuint cells[3] = { axisSize[0] / scale, axisSize[1] / scale, axisSize[2] / scale };
+    const GLuint cellStride[3] = { 1, cells[0] * cells[2], cells[0] };
+    const GLuint strideU = cellStride[u];
+    const GLuint strideV = cellStride[v];
+    // The part of the grid we mesh along each axis, whichever of n, u and v is y
+    const GLuint begin[3] = { 0, yBegin, 0 };
+    const GLuint end[3]   = { cells[0], yEnd, cells[2] };
+    // Faces that look along a positive axis sit on the far side of their cell,
+    // which the shader puts one block past the quad's position
+    const GLuint farSide = (faceOffsets[faceIndex][n] > 0 ? scale - 1 : 0);
+
+    for(GLuint d = begin[n]; d < end[n]; d++)
+    for(GLuint posV = begin[v]; posV < end[v]; posV++)
+    for(GLuint posU = begin[u]; posU < end[u]; posU++)
+    {
+        GLuint start = d * cellStride[n] + posU * strideU + posV * strideV;
+        GLuint key = faceMask[start];
+        if(key == 0)
+            continue;
+
+        GLuint width = 1;
+        GLuint height = 1;
+        // Only faces with the same AO level on every corner can be stretched
+        GLuint faceAO = (key >> keyAOShift) & keyAOMask;
+        if(merge && faceAO == (faceAO & 3) * 0x55)
+        {
+            // Grow along u while the next face matches
+            while(posU + width < end[u] && faceMask[start + width * strideU] == key)
+                width++;
+
+            // Grow along v while the whole next row matches
+            while(posV + height < end[v])
+            {
+                GLuint rowStart = start + height * strideV;
+                GLuint i = 0;
+                while(i < width && faceMask[rowStart + i * strideU] == key)
+                    i++;
+                if(i < width)
+                    break;
+                height++;
+            }
+        }
+
+        // Consume the faces we merged
+        for(GLuint j = 0; j < height; j++)
+        for(GLuint i = 0; i < width; i++)
+            faceMask[start + i * strideU + j * strideV] = 0;
+
+        // Quads start at the block with the smallest u and v
+        GLuint position[3];
+        position[n] = d * scale + farSide;
+        position[u] = posU * scale;
+        position[v] = posV * scale;
+
+        std::vector<GLuint> &vertices = ((key >> keyTransparentShift) & 1 ? transparentVertices : opaqueVertices);
+        ChunkMesher::EmitQuad(vertices, position[0], position[1], position[2], faceIndex, key & keyTextureMask, faceAO, (key >> keyLightShift) & keyLightMask, width * scale, height * scale);
+    }
+}
+
+
+
+void ChunkMesher::GreedyMesh(GLuint *faceMask, GLuint faceIndex, GLuint yBegin, GLuint yEnd, std::vector<GLuint> &opaqueVertices, std::vector<GLuint> &transparentVertices)
+{
+    GreedyMeshCells(faceMask, faceIndex, 1, true, yBegin, yEnd, opaqueVertices, transparentVertices);
+}
+
+
+
+// The chunk plus a one block border taken from its neighbours, so every
+// neighbour lookup while meshing is a plain array read. y runs fastest, like
+// the loops in BuildMesh
+static const GLint paddedSizeX = World::chunkWidthX + 2;
+static const GLint paddedSizeY = World::chunkHeightY + 2;
+static const GLint paddedSizeZ = World::chunkDepthZ + 2;
+static const GLint paddedStrideX = paddedSizeY;
+static const GLint paddedStrideZ = paddedSizeY * paddedSizeX;
+static const GLint paddedVolume = paddedSizeX * paddedSizeY * paddedSizeZ;
+
+static inline GLint PaddedIndex(GLint x, GLint y, GLint z)
+{
+    return (y + 1) + (x + 1) * paddedStrideX + (z + 1) * paddedStrideZ;
+}
+
+// Block type IDs of the padded chunk, 1 wherever a block darkens the corners of
+// the faces next to it, and the packed light of every block a face can look into
+static thread_local std::vector<GLint> paddedBlocks;
+static thread_local std::vector<GLubyte> paddedOccluders;
+static thread_local std::vector<GLubyte> paddedLight;
+
+
+
+// Corner c of each face sits at facePositions[face][c] within its block. This
+// has to match the face position tables in shaders/cube.vert
+static const GLint facePositions[6][4][3] = {
+    { {0, 0, 0}, {1, 1, 0}, {1, 0, 0}, {0, 1, 0} }, // Back
+    { {0, 0, 1}, {1, 1, 1}, {0, 1, 1}, {1, 0, 1} }, // Front
+    { {0, 1, 1}, {0, 0, 0}, {0, 0, 1}, {0, 1, 0} }, // Left
+    { {1, 1, 1}, {1, 0, 0}, {1, 1, 0}, {1, 0, 1} }, // Right
+    { {0, 1, 0}, {1, 1, 1}, {1, 1, 0}, {0, 1, 1} }, // Top
+    { {0, 0, 1}, {1, 0, 0}, {1, 0, 1}, {0, 0, 0} }  // Bottom
+};
+
+// For each face corner, how far (in padded indices) from the block the two
+// side neighbours and the diagonal neighbour that shade it are. All three sit
+// in the layer the face looks into
+struct CornerOffsets
+{
+    GLint offsets[6][4][3];
+
+    CornerOffsets()
+    {
+        for(GLuint face = 0; face < 6; face++)
+        for(GLuint corner = 0; corner < 4; corner++)
+        {
+            GLint front[3] = { faceOffsets[face][0], faceOffsets[face][1], faceOffsets[face][2] };
+            GLint side1[3] = { front[0], front[1], front[2] };
+            GLint side2[3] = { front[0], front[1], front[2] };
+            // Step towards the corner along the face's two in-plane axes
+            side1[uAxis[face]] += facePositions[face][corner][uAxis[face]] * 2 - 1;
+            side2[vAxis[face]] += facePositions[face][corner][vAxis[face]] * 2 - 1;
+            GLint diagonal[3] = { side1[0] + side2[0] - front[0], side1[1] + side2[1] - front[1], side1[2] + side2[2] - front[2] };
+
+            offsets[face][corner][0] = PaddedIndex(side1[0], side1[1], side1[2]) - PaddedIndex(0, 0, 0);
+            offsets[face][corner][1] = PaddedIndex(side2[0], side2[1], side2[2]) - PaddedIndex(0, 0, 0);
+            offsets[face][corner][2] = PaddedIndex(diagonal[0], diagonal[1], diagonal[2]) - PaddedIndex(0, 0, 0);
+        }
+    }
+};
+static const CornerOffsets cornerOffsets;
+
+// How far (in padded indices) the block each face looks at is
+static const GLint faceNeighbourOffsets[6] = {
+    -paddedStrideZ, paddedStrideZ, -paddedStrideX, paddedStrideX, 1, -1
+};
+
+
+
+// Copy the snapshot's chunk and its one block border into the padded arrays,
+// for the layers from yBegin up to (not including) yEnd plus one more on either
+// side. The rest keeps whatever an earlier mesh left there and must not be read.
+// Blocks in chunks that are not loaded stay Unloaded and never occlude
+static void FillPaddedVolume(const ChunkSnapshot &snapshot, GLint yBegin, GLint yEnd)
+{
+    paddedBlocks.resize(paddedVolume);
+    paddedOccluders.resize(paddedVolume);
+    paddedLight.resize(paddedVolume);
+
+    for(GLint z = -1; z <= (GLint)World::chunkDepthZ;  z++)
+    for(GLint x = -1; x <= (GLint)World::chunkWidthX;  x++)
+    for(GLint y = yBegin - 1, i = PaddedIndex(x, y, z); y <= yEnd; y++, i++)
+    {
+        GLint blockTypeID = snapshot.GetBlockType(x, y, z);
+        paddedBlocks[i] = blockTypeID;
+        paddedOccluders[i] = (blockTypeID != ChunkSnapshot::Unloaded && blockTypeID != BlockRegistry::Air && (!blockRegistry.IsTransparent(blockTypeID) || blockRegistry.IsFoliage(blockTypeID)));
+        paddedLight[i] = snapshot.GetLight(x, y, z);
+    }
+}
+
+
+
+// Whether we can see through a block to the face next to it. Blocks in
+// chunks that are not loaded count as solid, so we don't draw walls along
+// the edge of the world
+static inline GLboolean IsTransparent(GLint blockTypeID)
+{
+    return blockTypeID != ChunkSnapshot::Unloaded && blockRegistry.IsTransparent(blockTypeID);
+}
+
+
+
+// Occlusion level (0 = open, 3 = fully shaded) of all 4 corners of a face,
+// 2 bits per corner with corner 0 in the low bits. Two side neighbours shade
+// a corner fully no matter what is on the diagonal
+static inline GLuint FaceAO(GLint paddedIndex, GLuint faceIndex)
+{
+    const GLubyte *occluders = paddedOccluders.data() + paddedIndex;
+    GLuint faceAO = 0;
+    for(GLuint corner = 0; corner < 4; corner++)
+    {
+        const GLint *offsets = cornerOffsets.offsets[faceIndex][corner];
+        GLuint side1 = occluders[offsets[0]];
+        GLuint side2 = occluders[offsets[1]];
+        GLuint diagonal = occluders[offsets[2]];
+        faceAO |= (side1 + side2 + (diagonal | (side1 & side2))) << (corner * 2);
+    }
+    return faceAO;
+}
+
+
+
+// Record a visible face in the face masks, and count it towards the vertex list it goes in
+static inline void RecordFace(GLuint x, GLuint y, GLuint z, GLint blockTypeID, GLuint faceIndex, GLuint faceAO, GLuint faceLight, GLuint faceCounts[2])
+{
+    GLuint textureID = blockRegistry.FaceTexture(blockTypeID, faceIndex); // 5 Bits, 0-31
+    GLboolean transparent = blockRegistry.IsTransparent(blockTypeID);
+    faceMasks[faceIndex * World::chunkVolume + x + z * World::chunkWidthX + y * World::chunkWidthX * World::chunkDepthZ] = ChunkMesher::FaceKey(textureID, faceAO, faceLight, transparent);
+    faceCounts[transparent ? 1 : 0]++;
+}
+
+
+
+// Make room for a quad per recorded face, the most the faces can turn into, so
+// emitting them never reallocates. A mesh's vectors that are big enough already stay as they are
+static void ReserveFaces(ChunkMesh &mesh, const GLuint faceCounts[2])
+{
+    mesh.opaqueVertices.reserve(mesh.opaqueVertices.size() + faceCounts[0] * ChunkMesher::quadSize);
+    mesh.transparentVertices.reserve(mesh.transparentVertices.size() + faceCounts[1] * ChunkMesher::quadSize);
+}
+
+
+
+void ChunkMesher::BuildMesh(const ChunkSnapshot &snapshot, GLboolean greedyMeshing, GLboolean ambientOcclusion, GLuint slabMask, ChunkMesh &mesh)
+{
+    mesh.slabMask = slabMask & World::allMeshSlabs;
+    if(mesh.slabMask == 0)
+        return;
+
+    // Every visible face is recorded first, then turned into quads
+    if(faceMasks.empty())
+        faceMasks.assign(6 * World::chunkVolume, 0);
+
+    // One pass over the part of the snapshot we need, everything after reads the padded copy
+    GLuint lowestSlab = 0, highestSlab = World::meshSlabCount - 1;
+    while(!(mesh.slabMask & (1u << lowestSlab)))
+        lowestSlab++;
+    while(!(mesh.slabMask & (1u << highestSlab)))
+        highestSlab--;
+    FillPaddedVolume(snapshot, lowestSlab * World::meshSlabHeight, (highestSlab + 1) * World::meshSlabHeight);
+
+    // Opaque and transparent faces recorded over all the slabs we build
+    GLuint faceCounts[2] = { 0, 0 };
+    for(GLuint slab = 0; slab < World::meshSlabCount; slab++)
+    {
+        mesh.slabMinY[slab] = World::chunkHeightY;
+        mesh.slabMaxY[slab] = -1;
+        if(!(mesh.slabMask & (1u << slab)))
+            continue;
+
+        GLint yBegin = slab * World::meshSlabHeight;
+        GLint yEnd = yBegin + World::meshSlabHeight;
+        GLint slabMinY = World::chunkHeightY, slabMaxY = -1;
+        for(GLint z = 0; z < (GLint)World::chunkDepthZ; z++)
+        for(GLint x = 0; x < (GLint)World::chunkWidthX; x++)
+        for(GLint y = yBegin; y < yEnd; y++)
+        {
+            GLint paddedIndex = PaddedIndex(x, y, z);
+            GLint blockTypeID = paddedBlocks[paddedIndex];
+            if(blockTypeID == BlockRegistry::Air)
+                continue;
+            slabMinY = std::min(slabMinY, y);
+            slabMaxY = std::max(slabMaxY, y);
+
+            // Transparent blocks only get their top and bottom faces, unless they are foliage
+            GLboolean drawSides = !blockRegistry.IsTransparent(blockTypeID) || blockRegistry.IsFoliage(blockTypeID);
+
+            for(GLuint faceIndex = 0; faceIndex < 6; faceIndex++)
+            {
+                if(faceIndex < BlockFaces::Top_Face && !drawSides)
+                    continue;
+                // A face only needs drawing if we can see it through the block next to it
+                GLint neighbourIndex = paddedIndex + faceNeighbourOffsets[faceIndex];
+                if(!IsTransparent(paddedBlocks[neighbourIndex]))
+                    continue;
+
+                GLuint faceAO = (ambientOcclusion ? FaceAO(paddedIndex, faceIndex) : 0);
+                RecordFace(x, y, z, blockTypeID, faceIndex, faceAO, paddedLight[neighbourIndex], faceCounts);
+            }
+        }
+        mesh.slabMinY[slab] = slabMinY;
+        mesh.slabMaxY[slab] = slabMaxY;
+        mesh.minY = std::min(mesh.minY, slabMinY);
+        mesh.maxY = std::max(mesh.maxY, slabMaxY);
+    }
+
+    ReserveFaces(mesh, faceCounts);
+    for(GLuint slab = 0; slab < World::meshSlabCount; slab++)
+    {
+        if(mesh.slabMask & (1u << slab))
+        {
+            // Merge the slab's faces into as few quads as we can, or give each its own
+            GLuint yBegin = slab * World::meshSlabHeight;
+            for(GLuint faceIndex = 0; faceIndex < 6; faceIndex++)
+                GreedyMeshCells(faceMasks.data() + faceIndex * World::chunkVolume, faceIndex, 1, greedyMeshing, yBegin, yBegin + World::meshSlabHeight, mesh.opaqueVertices, mesh.transparentVertices);
+        }
+        mesh.opaqueSlabEnds[slab] = mesh.opaqueVertices.size();
+        mesh.transparentSlabEnds[slab] = mesh.transparentVertices.size();
+    }
+}
+
+
+
+// Block type of each cell of a level of detail mesh, plus a layer of cells from
+// the chunks above and below. x runs fastest, then z, then y, like a face mask
+static thread_local std::vector<GLint> lodCells;
+
+
+
+// The block a level of detail cell stands for: its highest opaque block, or if
+// it has none its highest see-through block, or air. Anything solid makes the
+// cell solid, so a coarse mesh always covers at least what the full one does
+static GLint CellBlockType(const ChunkSnapshot &snapshot, GLint cellX, GLint cellY, GLint cellZ, GLint scale)
+{
+    GLint seeThroughBlockTypeID = BlockRegistry::Air;
+    for(GLint y = (cellY + 1) * scale - 1; y >= cellY * scale; y--)
+    for(GLint z = cellZ * scale; z < (cellZ + 1) * scale; z++)
+    for(GLint x = cellX * scale; x < (cellX + 1) * scale; x++)
+    {
+        GLint blockTypeID = snapshot.GetBlockType(x, y, z);
+        // A whole neighbouring chunk is either loaded or not
+        if(blockTypeID == ChunkSnapshot::Unloaded)
+            return ChunkSnapshot::Unloaded;
+        if(blockTypeID == BlockRegistry::Air)
+            continue;
+        if(!blockRegistry.IsTransparent(blockTypeID))
+            return blockTypeID;
+        if(seeThroughBlockTypeID == BlockRegistry::Air)
+            seeThroughBlockTypeID = blockTypeID;
+    }
+    return seeThroughBlockTypeID;
+}
+
+
+
+void ChunkMesher::BuildLODMesh(const ChunkSnapshot &snapshot, GLuint lodLevel, ChunkMesh &mesh)
+{
+    const GLint scale = 1 << lodLevel;
+    const GLint cellsX = World::chunkWidthX / scale;
+    const GLint cellsY = World::chunkHeightY / scale;
+    const GLint cellsZ = World::chunkDepthZ / scale;
+    const GLint cellLayer = cellsX * cellsZ;
+    const GLint slabCells = World::meshSlabHeight / scale;
+    static const GLint cellOffsets[6][3] = { {0, 0, -1}, {0, 0, 1}, {-1, 0, 0}, {1, 0, 0}, {0, 1, 0}, {0, -1, 0} };
+    // Distant chunks are only seen from above the ground, so they are drawn in full daylight
+    const GLuint skyLight = LightStorage::Pack(LightStorage::maxLevel, 0);
+
+    mesh.slabMask = World::allMeshSlabs;
+    if(faceMasks.empty())
+        faceMasks.assign(6 * World::chunkVolume, 0);
+
+    // Downsample the chunk, and the cell layers touching it above and below
+    lodCells.resize(cellLayer * (cellsY + 2));
+    for(GLint cellY = -1; cellY <= cellsY; cellY++)
+    for(GLint cellZ = 0; cellZ < cellsZ; cellZ++)
+    for(GLint cellX = 0; cellX < cellsX; cellX++)
+        lodCells[cellX + cellZ * cellsX + (cellY + 1) * cellLayer] = CellBlockType(snapshot, cellX, cellY, cellZ, scale);
+
+    GLuint faceCounts[2] = { 0, 0 };
+    for(GLuint slab = 0; slab < World::meshSlabCount; slab++)
+    {
+        GLint yBegin = slab * slabCells;
+        GLint yEnd = yBegin + slabCells;
+        mesh.slabMinY[slab] = World::chunkHeightY;
+        mesh.slabMaxY[slab] = -1;
+        for(GLint cellY = yBegin; cellY < yEnd; cellY++)
+        for(GLint cellZ = 0; cellZ < cellsZ; cellZ++)
+        for(GLint cellX = 0; cellX < cellsX; cellX++)
+        {
+            GLint blockTypeID = lodCells[cellX + cellZ * cellsX + (cellY + 1) * cellLayer];
+            if(blockTypeID == BlockRegistry::Air)
+                continue;
+            mesh.slabMinY[slab] = std::min(mesh.slabMinY[slab], cellY * scale);
+            mesh.slabMaxY[slab] = std::max(mesh.slabMaxY[slab], cellY * scale + scale - 1);
+
+            GLboolean transparent = blockRegistry.IsTransparent(blockTypeID);
+            GLboolean drawSides = !transparent || blockRegistry.IsFoliage(blockTypeID);
+            for(GLuint faceIndex = 0; faceIndex < 6; faceIndex++)
+            {
+                if(faceIndex < BlockFaces::Top_Face && !drawSides)
+                    continue;
+                // Faces on the chunk's sides are always drawn. They hang down as skirts
+                // that close the gaps against neighbours meshed at another level
+                GLint neighbourX = cellX + cellOffsets[faceIndex][0];
+                GLint neighbourY = cellY + cellOffsets[faceIndex][1];
+                GLint neighbourZ = cellZ + cellOffsets[faceIndex][2];
+                GLboolean onSide = (neighbourX < 0 || neighbourX >= cellsX || neighbourZ < 0 || neighbourZ >= cellsZ);
+                if(!onSide && !IsTransparent(lodCells[neighbourX + neighbourZ * cellsX + (neighbourY + 1) * cellLayer]))
+                    continue;
+
+                GLuint textureID = blockRegistry.FaceTexture(blockTypeID, faceIndex);
+                faceMasks[faceIndex * World::chunkVolume + cellX + cellZ * cellsX + cellY * cellLayer] = FaceKey(textureID, 0, skyLight, transparent);
+                faceCounts[transparent ? 1 : 0]++;
+            }
+        }
+        mesh.minY = std::min(mesh.minY, mesh.slabMinY[slab]);
+        mesh.maxY = std::max(mesh.maxY, mesh.slabMaxY[slab]);
+    }
+
+    ReserveFaces(mesh, faceCounts);
+    for(GLuint slab = 0; slab < World::meshSlabCount; slab++)
+    {
+        for(GLuint faceIndex = 0; faceIndex < 6; faceIndex++)
+            GreedyMeshCells(faceMasks.data() + faceIndex * World::chunkVolume, faceIndex, scale, true, slab * slabCells, (slab + 1) * slabCells, mesh.opaqueVertices, mesh.transparentVertices);
+        mesh.opaqueSlabEnds[slab] = mesh.opaqueVertices.size();
+        mesh.transparentSlabEnds[slab] = mesh.transparentVertices.size();
+    }
+}
+
+
+
+GLuint ChunkMesher::SlabsBetween(GLint minY, GLint maxY)
+{
+    minY = std::max(minY, 0);
+    maxY = std::min(maxY, (GLint)World::chunkHeightY - 1);
+    if(minY > maxY)
+        return 0;
+    GLuint firstSlab = minY / World::meshSlabHeight;
+    GLuint lastSlab = maxY / World::meshSlabHeight;
+    return ((2u << lastSlab) - 1) & ~((1u << firstSlab) - 1);
+}
@@ -0,0 +1,138 @@
+#pragma once
+
+#include "Block.hpp"
+#include "ChunkSnapshot.hpp"
+#include "WorldConstants.hpp"
+
+#include <glad/glad.h>
+#include <vector> // For std::vector
+
+
+
+// Turns visible block faces into packed vertices. Knows nothing about
+// OpenGL objects, so it can run (and be benchmarked) without a context.
+//
+// Every vertex is two GLuints:
+//   Word 0: x 6 Bits | y 6 Bits | z 6 Bits | faceID 3 Bits | corner 3 Bits | textureID 5 Bits | AO level 2 Bits
+//   Word 1: quad width - 1 5 Bits | quad height - 1 5 Bits | (unused 8 Bits) | block light 4 Bits | skylight 4 Bits
+// The light is the light of the block the face looks into, the same over the whole quad.
+// With World::indexedQuads a quad is its 4 corners, drawn through the shared
+// quad index buffer. Otherwise it is 6 vertices, corners 0 1 2 1 0 3.
+//
+// With World::vertexPulling a quad is a single record of the same two words,
+// which the cube shader reads from a buffer texture and turns into the quad's
+// 6 vertices. The corner and AO bits of word 0 stay 0, the AO of all 4
+// corners goes in word 1 instead:
+//   Word 1: quad width - 1 5 Bits | quad height - 1 5 Bits | AO level of corners 0-3 2 Bits each | block light 4 Bits | skylight 4 Bits
+// The width and height of a quad run along the face's texture u and v axes:
+//   Back: x, y   Front: y, x   Left: y, z   Right: z, y   Top/Bottom: x, z
+// The vertices for one chunk, built by BuildMesh and uploaded by the render thread.
+// The chunk is meshed in horizontal slabs of World::meshSlabHeight blocks, and
+// quads never cross a slab border, so one slab can be rebuilt on its own. Each
+// vector holds the slabs one after another, lowest first
+struct ChunkMesh
+{
+    std::vector<GLuint> opaqueVertices;
+    std::vector<GLuint> transparentVertices;
+    // Bit per slab this mesh was built for. Slabs that aren't in it have no
+    // vertices here, and whatever the chunk already drew for them stays
+    GLuint slabMask = World::allMeshSlabs;
+    // Where each slab's vertices end in the two vectors
+    GLuint opaqueSlabEnds[World::meshSlabCount] = {};
+    GLuint transparentSlabEnds[World::meshSlabCount] = {};
+    // Lowest and highest y of any non-air block in each slab, for a tight bounding box.
+    // minY > maxY if the slab is all air
+    GLint slabMinY[World::meshSlabCount];
+    GLint slabMaxY[World::meshSlabCount];
+    // The same over every slab we built
+    GLint minY = World::chunkHeightY;
+    GLint maxY = -1;
+
+    // An empty mesh for every slab
+    ChunkMesh()
+    {
+        Clear();
+    }
+
+    // Empty the mesh again, keeping the vectors' memory so the next mesh built
+    // into it doesn't have to allocate any
+    void Clear()
+    {
+        opaqueVertices.clear();
+        transparentVertices.clear();
+        slabMask = World::allMeshSlabs;
+        for(GLuint slab = 0; slab < World::meshSlabCount; slab++)
+        {
+            opaqueSlabEnds[slab] = 0;
+            transparentSlabEnds[slab] = 0;
+            slabMinY[slab] = World::chunkHeightY;
+            slabMaxY[slab] = -1;
+        }
+        minY = World::chunkHeightY;
+        maxY = -1;
+    }
+};
+
+namespace ChunkMesher
+{
+    // How many GLuints one vertex takes up
+    const GLuint vertexStride = 2;
+    // Whether quads are drawn through the shared quad index buffer
+    const GLboolean drawsIndexed = (World::indexedQuads && !World::vertexPulling);
+    // How many vertices one quad takes up: one record, its 4 corners or two whole triangles
+    const GLuint verticesPerQuad = (World::vertexPulling ? 1 : (drawsIndexed ? 4 : 6));
+    // How many indices draw one quad, two triangles
+    const GLuint indicesPerQuad = 6;
+    // The most quads one mesh can have, every face of every block
+    const GLuint maxQuadsPerMesh = World::chunkVolume * 6;
+
+    // How many GLuints one quad takes up
+    const GLuint quadSize = vertexStride * verticesPerQuad;
+
+    // How many vertices or indices to draw for vertexCount vertices (or records) of quads
+    inline GLsizei DrawCount(GLsizei vertexCount)
+    {
+        return (verticesPerQuad == 1 || drawsIndexed ? vertexCount / verticesPerQuad * indicesPerQuad : vertexCount);
+    }
+
+    // Append the vertices (or record) of a quad starting at block x, y, z. faceAO holds
+    // the ambient occlusion level (0-3) of each of the face's 4 corners, 2 bits
+    // each with corner 0 in the low bits. faceLight is the packed light (see
+    // LightStorage) of the block the face looks into
+    void EmitQuad(std::vector<GLuint> &vertices, GLuint x, GLuint y, GLuint z, GLuint faceIndex, GLuint textureID, GLuint faceAO, GLuint faceLight, GLuint width, GLuint height);
+
+    // Everything that has to match for two faces to be merged, packed into one
+    // non-zero GLuint. 0 in a face mask means there is no face there
+    GLuint FaceKey(GLuint textureID, GLuint faceAO, GLuint faceLight, GLboolean transparent);
+
+    // Greedy mesh one face direction. faceMask holds a FaceKey (or 0) for every
+    // block in the chunk, indexed like x + z*chunkWidthX + y*chunkWidthX*chunkDepthZ.
+    // Coplanar faces with the same key are merged into the biggest rectangles we
+    // can find. Faces whose AO differs between corners are left as single quads,
+    // since a merged quad can only interpolate AO across its own 4 corners.
+    // Only the layers from yBegin up to (not including) yEnd are read, and quads
+    // don't reach outside them. Those layers are cleared as they are consumed,
+    // so the mask comes back all zeros
+    void GreedyMesh(GLuint *faceMask, GLuint faceIndex, GLuint yBegin, GLuint yEnd, std::vector<GLuint> &opaqueVertices, std::vector<GLuint> &transparentVertices);
+
+    // Mesh the middle chunk of a snapshot, working out which faces are visible
+    // and their ambient occlusion and light. Faces against neighbours that are not loaded
+    // are left out. Only reads the snapshot and the block registry, so any
+    // number of threads can build meshes at once. Without ambientOcclusion every
+    // vertex is fully lit. Only the slabs in slabMask are built, and the snapshot
+    // only needs the blocks within one block of them. The mesh has to be empty.
+    // Every visible face is counted before any vertex is written, and the vectors
+    // are reserved for that many up front, so a mesh that was built before and
+    // Cleared is refilled without a single heap allocation
+    void BuildMesh(const ChunkSnapshot &snapshot, GLboolean greedyMeshing, GLboolean ambientOcclusion, GLuint slabMask, ChunkMesh &mesh);
+
+    // Mesh the middle chunk of a snapshot at a level of detail: lodLevel 1, 2 or 3
+    // merges each 2, 4 or 8 block cube into one cell before meshing. No ambient
+    // occlusion and everything is fully sky lit, and faces on the chunk's sides are always drawn as skirts, so
+    // neighbours at different levels meet without cracks. Builds every slab, and
+    // like BuildMesh takes an empty mesh and reserves its vectors up front
+    void BuildLODMesh(const ChunkSnapshot &snapshot, GLuint lodLevel, ChunkMesh &mesh);
+
+    // Which slabs hold blocks from minY to maxY (chunk y, clamped to the chunk)
+    GLuint SlabsBetween(GLint minY, GLint maxY);
+}
@@ -0,0 +1,256 @@
+#include "ChunkSerializer.hpp"
+#include "BlockRegistry.hpp"
+
+#include <algorithm> // For std::min
+#include <string> // For std::string
+
+
+
+// Runs shorter than this are cheaper to store as literals
+static const size_t minimumRunLength = 3;
+// A control byte below 128 starts a literal of (byte + 1) bytes, and one
+// from 128 up repeats the next byte (byte - 128 + minimumRunLength) times
+static const size_t maxLiteralLength = 128;
+static const size_t maxRunLength = 127 + minimumRunLength;
+
+
+
+// Little endian writes, whatever the machine's byte order is
+template <typename T>
+static void Write(std::vector<GLubyte> &bytes, T value)
+{
+    for(size_t i = 0; i < sizeof(T); i++)
+        bytes.push_back((GLubyte)((uint64_t)value >> (i * 8)));
+}
+
+
+
+// Reads values back in the order Write wrote them. Reading past the end
+// marks the reader as failed and returns 0 instead
+struct ByteReader
+{
+    const GLubyte *at;
+    const GLubyte *end;
+    GLboolean failed = false;
+
+    template <typename T>
+    T Read()
+    {
+        if((size_t)(end - at) < sizeof(T))
+        {
+            failed = true;
+            at = end;
+            return 0;
+        }
+        uint64_t value = 0;
+        for(size_t i = 0; i < sizeof(T); i++)
+            value |= (uint64_t)*at++ << (i * 8);
+        return (T)value;
+    }
+};
+
+
+
+// Block type ID to index in the chunk's name table, adding the name the first time we see the ID
+static uint16_t NameIndex(GLint blockTypeID, GLint *nameIndices, std::vector<GLint> &names)
+{
+    GLint &index = nameIndices[blockTypeID + 1];
+    if(index == -1)
+    {
+        index = names.size();
+        names.push_back(blockTypeID);
+    }
+    return index;
+}
+
+
+
+void ChunkSerializer::Save(const SavedChunk &chunk, std::vector<GLubyte> &bytes)
+{
+    // Sections and edits go in body first, since the name table in front of
+    // them is only complete once they have all been written
+    std::vector<GLubyte> body;
+    std::vector<GLint> names;
+    GLint nameIndices[BlockRegistry::maxBlockTypes + 1];
+    for(GLint &index : nameIndices)
+        index = -1;
+
+    for(GLuint i = 0; i < BlockStorage::sectionCount; i++)
+    {
+        const BlockSection &section = chunk.blocks.GetSection(i);
+        Write<uint8_t>(body, section.GetBitsPerBlock());
+        Write<uint16_t>(body, section.GetPalette().size());
+        for(GLint blockTypeID : section.GetPalette())
+            Write<uint16_t>(body, NameIndex(blockTypeID, nameIndices, names));
+        for(uint64_t word : section.GetData())
+            Write<uint64_t>(body, word);
+    }
+
+    Write<uint16_t>(body, chunk.outgoingFeatureEdits.size());
+    for(const FeatureEdits &edits : chunk.outgoingFeatureEdits)
+    {
+        Write<uint8_t>(body, edits.neighbourIndex);
+        Write<uint32_t>(body, edits.blocks.size());
+        for(const FeatureBlock &block : edits.blocks)
+        {
+            Write<uint8_t>(body, block.x);
+            Write<uint8_t>(body, block.y);
+            Write<uint8_t>(body, block.z);
+            Write<uint16_t>(body, NameIndex(block.blockTypeID, nameIndices, names));
+        }
+    }
+
+    std::vector<GLubyte> header;
+    Write<uint32_t>(header, formatVersion);
+    Write<uint32_t>(header, chunk.appliedFeatureNeighbours);
+    Write<uint16_t>(header, names.size());
+    for(GLint blockTypeID : names)
+    {
+        const std::string &name = blockRegistry.GetName(blockTypeID);
+        Write<uint8_t>(header, name.size());
+        header.insert(header.end(), name.begin(), name.end());
+    }
+    header.insert(header.end(), body.begin(), body.end());
+
+    bytes.clear();
+    Compress(header, bytes);
+}
+
+
+
+GLboolean ChunkSerializer::Load(const GLubyte *bytes, size_t size, SavedChunk &chunk)
+{
+    std::vector<GLubyte> data;
+    if(!Decompress(bytes, size, data))
+        return false;
+
+    ByteReader reader = { data.data(), data.data() + data.size() };
+    if(reader.Read<uint32_t>() != formatVersion)
+        return false;
+    chunk.appliedFeatureNeighbours = reader.Read<uint32_t>();
+
+    // Map the saved names back to this run's block type IDs
+    std::vector<GLint> blockTypeIDs(reader.Read<uint16_t>());
+    for(GLint &blockTypeID : blockTypeIDs)
+    {
+        size_t length = reader.Read<uint8_t>();
+        if((size_t)(reader.end - reader.at) < length)
+            return false;
+        blockTypeID = blockRegistry.GetID(std::string((const char *)reader.at, length));
+        reader.at += length;
+    }
+
+    std::vector<GLint> palette;
+    std::vector<uint64_t> words;
+    for(GLuint i = 0; i < BlockStorage::sectionCount; i++)
+    {
+        GLuint bitsPerBlock = reader.Read<uint8_t>();
+        palette.resize(reader.Read<uint16_t>());
+        for(GLint &blockTypeID : palette)
+        {
+            uint16_t nameIndex = reader.Read<uint16_t>();
+            if(nameIndex >= blockTypeIDs.size())
+                return false;
+            blockTypeID = blockTypeIDs[nameIndex];
+        }
+        words.resize(World::blockSectionSize * World::blockSectionSize * World::blockSectionSize * bitsPerBlock / 64);
+        for(uint64_t &word : words)
+            word = reader.Read<uint64_t>();
+        if(reader.failed || !chunk.blocks.GetSection(i).Load(palette, bitsPerBlock, words))
+            return false;
+    }
+
+    chunk.outgoingFeatureEdits.resize(reader.Read<uint16_t>());
+    for(FeatureEdits &edits : chunk.outgoingFeatureEdits)
+    {
+        edits.neighbourIndex = reader.Read<uint8_t>();
+        uint32_t blockCount = reader.Read<uint32_t>();
+        // Every block takes 5 bytes, so a count past what's left is corrupt
+        if(edits.neighbourIndex >= 27 || blockCount > (size_t)(reader.end - reader.at) / 5)
+            return false;
+        edits.blocks.resize(blockCount);
+        for(FeatureBlock &block : edits.blocks)
+        {
+            block.x = reader.Read<uint8_t>();
+            block.y = reader.Read<uint8_t>();
+            block.z = reader.Read<uint8_t>();
+            uint16_t nameIndex = reader.Read<uint16_t>();
+            if(block.x >= World::chunkWidthX || block.y >= World::chunkHeightY || block.z >= World::chunkDepthZ || nameIndex >= blockTypeIDs.size())
+                return false;
+            block.blockTypeID = blockTypeIDs[nameIndex];
+        }
+    }
+
+    return !reader.failed;
+}
+
+
+
+void ChunkSerializer::Compress(const std::vector<GLubyte> &bytes, std::vector<GLubyte> &compressed)
+{
+    size_t i = 0;
+    size_t literalStart = 0;
+    while(i <= bytes.size())
+    {
+        // How long the run of equal bytes starting here is
+        size_t runLength = 0;
+        if(i < bytes.size())
+        {
+            runLength = 1;
+            while(i + runLength < bytes.size() && runLength < maxRunLength && bytes[i + runLength] == bytes[i])
+                runLength++;
+        }
+
+        // Flush the literal bytes before a run (or the end of the data)
+        if(runLength >= minimumRunLength || i == bytes.size())
+        {
+            while(literalStart < i)
+            {
+                size_t length = std::min(i - literalStart, maxLiteralLength);
+                compressed.push_back(length - 1);
+                compressed.insert(compressed.end(), bytes.begin() + literalStart, bytes.begin() + literalStart + length);
+                literalStart += length;
+            }
+        }
+        if(i == bytes.size())
+            break;
+
+        if(runLength >= minimumRunLength)
+        {
+            compressed.push_back(128 + runLength - minimumRunLength);
+            compressed.push_back(bytes[i]);
+            i += runLength;
+            literalStart = i;
+        }
+        else
+        {
+            i++;
+        }
+    }
+}
+
+
+
+GLboolean ChunkSerializer::Decompress(const GLubyte *compressed, size_t size, std::vector<GLubyte> &bytes)
+{
+    size_t i = 0;
+    while(i < size)
+    {
+        GLubyte control = compressed[i++];
+        if(control < 128)
+        {
+            size_t length = control + 1;
+            if(size - i < length)
+                return false;
+            bytes.insert(bytes.end(), compressed + i, compressed + i + length);
+            i += length;
+        }
+        else
+        {
+            if(i == size)
+                return false;
+            bytes.insert(bytes.end(), control - 128 + minimumRunLength, compressed[i++]);
+        }
+    }
+    return true;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "BlockStorage.hpp"
+#include "FeaturePlacer.hpp"
+
+#include <glad/glad.h>
+#include <vector> // For std::vector
+
+
+
+// Everything about a chunk we keep on disk. A copy of the chunk's state, so the
+// region writer thread can serialize it while the chunk keeps changing (or is gone)
+struct SavedChunk
+{
+    BlockStorage blocks;
+    // Tree blocks the chunk puts in its neighbours, see Chunk::outgoingFeatureEdits
+    std::vector<FeatureEdits> outgoingFeatureEdits;
+    // See Chunk::appliedFeatureNeighbours
+    GLuint appliedFeatureNeighbours = 0;
+};
+
+
+
+// Turns chunks into the compressed bytes stored in region files and back.
+// Blocks are written the way BlockStorage already keeps them, as a palette plus
+// bit-packed indices per section, with the palettes pointing into a per-chunk
+// table of block names (so saves survive blocks.json renumbering its IDs).
+// The whole thing is then run-length encoded. Safe to call from any thread
+namespace ChunkSerializer
+{
+    // Bumped whenever the byte layout changes. Chunks saved with another version
+    // are ignored (and regenerated) instead of misread
+    const GLuint formatVersion = 1;
+
+    // Serialize and compress a chunk, replacing what was in bytes
+    void Save(const SavedChunk &chunk, std::vector<GLubyte> &bytes);
+    // Decompress and read back a chunk. Returns false if the bytes are not a valid chunk
+    GLboolean Load(const GLubyte *bytes, size_t size, SavedChunk &chunk);
+
+    // Run-length encode bytes, appending to compressed. Packed block indices of
+    // layered terrain are long runs of the same few bytes, so this does well on them
+    void Compress(const std::vector<GLubyte> &bytes, std::vector<GLubyte> &compressed);
+    // Undo Compress, appending to bytes. Returns false if the data is cut short
+    GLboolean Decompress(const GLubyte *compressed, size_t size, std::vector<GLubyte> &bytes);
+}
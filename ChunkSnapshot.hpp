@@ -0,0 +1,142 @@
+#pragma once
+
+#include "Block.hpp"
+#include "BlockStorage.hpp"
+#include "LightStorage.hpp"
+#include "WorldConstants.hpp"
+
+#include <glad/glad.h>
+#include <memory> // For std::unique_ptr
+
+
+
+// A frozen copy of a chunk's blocks and the blocks of the 26 chunks around it,
+// plus the light its faces look into, taken on the main thread so a worker can
+// mesh the chunk while the player keeps editing the real one. Nothing in here
+// points back at a Chunk
+class ChunkSnapshot
+{
+public:
+    // What GetBlockType returns for blocks in a neighbouring chunk that is not loaded
+    static const GLint Unloaded = -2;
+
+    // Copy in the blocks of the chunk at offset dx, dy, dz (each -1 to 1) from the
+    // snapshot's own chunk. 0, 0, 0 is the chunk being meshed. A snapshot that
+    // held blocks there before copies into the same storage, which only
+    // allocates if the new blocks need bigger palettes than the old ones
+    void SetChunk(GLint dx, GLint dy, GLint dz, const BlockStorage &blocks)
+    {
+        GLuint index = ChunkIndex(dx, dy, dz);
+        if(chunks[index] == nullptr)
+            chunks[index].reset(new BlockStorage(blocks));
+        else
+            *chunks[index] = blocks;
+        loadedChunks |= 1u << index;
+    }
+
+    // Copy in the light of the chunk being meshed. Like SetChunk this reuses the
+    // array an earlier snapshot copied in
+    void SetLight(const LightStorage &light)
+    {
+        centerLight = light;
+    }
+
+    // Copy in the layer of light touching the chunk from the neighbour on the
+    // other side of its face faceIndex (see BlockFaces). Faces only ever look
+    // straight out of the chunk, so that is all of a neighbour's light we need
+    void SetBorderLight(GLuint faceIndex, const LightStorage &light)
+    {
+        const GLint size = World::chunkSize;
+        // The neighbour's layer that touches us, as a fixed coordinate along the face's axis
+        const GLint layer = (faceIndex == Back_Face || faceIndex == Left_Face || faceIndex == Bottom_Face ? size - 1 : 0);
+        for(GLint b = 0; b < size; b++)
+        for(GLint a = 0; a < size; a++)
+        {
+            GLint x = a, y = b, z = layer;
+            if(faceIndex == Left_Face || faceIndex == Right_Face)
+            {
+                x = layer;
+                z = a;
+            }
+            else if(faceIndex == Top_Face || faceIndex == Bottom_Face)
+            {
+                y = layer;
+                z = b;
+            }
+            borderLight[faceIndex][a + b * size] = light.Get(LightStorage::Index(x, y, z));
+        }
+        loadedBorders |= 1u << faceIndex;
+    }
+
+    // Forget every chunk, keeping their storage around for the next SetChunk calls
+    void Clear()
+    {
+        loadedChunks = 0;
+        loadedBorders = 0;
+    }
+
+    // Block type ID at x, y, z relative to the snapshot's own chunk. Each
+    // coordinate can be one block outside the chunk, from -1 to chunk size
+    GLint GetBlockType(GLint x, GLint y, GLint z) const
+    {
+        GLint dx = (x < 0 ? -1 : (x >= (GLint)World::chunkWidthX  ? 1 : 0));
+        GLint dy = (y < 0 ? -1 : (y >= (GLint)World::chunkHeightY ? 1 : 0));
+        GLint dz = (z < 0 ? -1 : (z >= (GLint)World::chunkDepthZ  ? 1 : 0));
+        GLuint index = ChunkIndex(dx, dy, dz);
+        if(!(loadedChunks & (1u << index)))
+            return Unloaded;
+        return chunks[index]->GetBlockType(x - dx * (GLint)World::chunkWidthX, y - dy * (GLint)World::chunkHeightY, z - dz * (GLint)World::chunkDepthZ);
+    }
+
+    // Packed light (see LightStorage) at x, y, z relative to the snapshot's own chunk.
+    // At most one coordinate can be one block outside the chunk, like the block a
+    // face looks at. Anything else, or a neighbour with no light, reads as dark
+    GLubyte GetLight(GLint x, GLint y, GLint z) const
+    {
+        const GLint size = World::chunkSize;
+        GLuint faceIndex;
+        GLint a, b;
+        if(z < 0 || z >= size)
+        {
+            faceIndex = (z < 0 ? Back_Face : Front_Face);
+            a = x;
+            b = y;
+        }
+        else if(x < 0 || x >= size)
+        {
+            faceIndex = (x < 0 ? Left_Face : Right_Face);
+            a = z;
+            b = y;
+        }
+        else if(y < 0 || y >= size)
+        {
+            faceIndex = (y < 0 ? Bottom_Face : Top_Face);
+            a = x;
+            b = z;
+        }
+        else
+        {
+            return centerLight.Get(LightStorage::Index(x, y, z));
+        }
+        if(a < 0 || a >= size || b < 0 || b >= size || !(loadedBorders & (1u << faceIndex)))
+            return 0;
+        return borderLight[faceIndex][a + b * size];
+    }
+
+private:
+    // The 3x3x3 block of chunks around (and including) the one being meshed
+    std::unique_ptr<BlockStorage> chunks[27];
+    // Bit per ChunkIndex set for the chunks that hold blocks right now. Storage
+    // for the rest may be left over from an earlier snapshot
+    GLuint loadedChunks = 0;
+    // Light of the middle chunk, and of the layer of each face neighbour that touches it
+    LightStorage centerLight;
+    GLubyte borderLight[6][World::chunkSize * World::chunkSize];
+    // Bit per face whose borderLight holds light right now
+    GLuint loadedBorders = 0;
+
+    static GLuint ChunkIndex(GLint dx, GLint dy, GLint dz)
+    {
+        return (dx + 1) + (dy + 1) * 3 + (dz + 1) * 9;
+    }
+};
@@ -0,0 +1,115 @@
+#include "FeaturePlacer.hpp"
+#include "Chunk.hpp"
+#include "Biomes.hpp"
+#include "BlockRegistry.hpp"
+
+#include <algorithm> // For std::min and std::max
+
+
+
+// Tree shape: a trunk of logs, then a 5x5 layer of leaves and a 3x3 layer on top
+static const GLint treeTrunkHeight = 6;
+
+
+
+GLuint FeaturePlacer::ColumnHash(GLuint seed, GLint worldX, GLint worldZ)
+{
+    GLuint hash = seed * 0x9E3779B1u ^ (GLuint)worldX * 0x85EBCA77u ^ (GLuint)worldZ * 0xC2B2AE3Du;
+    // Finish with a few multiply/xorshift rounds so neighbouring columns come out unrelated
+    hash ^= hash >> 15;
+    hash *= 0x2C1B3C6Du;
+    hash ^= hash >> 12;
+    hash *= 0x297A2D39u;
+    hash ^= hash >> 15;
+    return hash;
+}
+
+
+
+// Put a feature block at x, y, z relative to the chunk, which may be outside it
+static void PlaceBlock(Chunk &chunk, GLint x, GLint y, GLint z, GLint blockTypeID, std::vector<FeatureEdits> &outsideEdits)
+{
+    GLint dx = (x < 0 ? -1 : (x >= (GLint)World::chunkWidthX  ? 1 : 0));
+    GLint dy = (y < 0 ? -1 : (y >= (GLint)World::chunkHeightY ? 1 : 0));
+    GLint dz = (z < 0 ? -1 : (z >= (GLint)World::chunkDepthZ  ? 1 : 0));
+
+    FeatureBlock block;
+    block.x = x - dx * (GLint)World::chunkWidthX;
+    block.y = y - dy * (GLint)World::chunkHeightY;
+    block.z = z - dz * (GLint)World::chunkDepthZ;
+    block.blockTypeID = blockTypeID;
+
+    if(dx == 0 && dy == 0 && dz == 0)
+    {
+        FeaturePlacer::ApplyBlock(chunk.chunkBlocks, block);
+        chunk.occupiedMinY = std::min(chunk.occupiedMinY, y);
+        chunk.occupiedMaxY = std::max(chunk.occupiedMaxY, y);
+        return;
+    }
+
+    // Nothing grows past the top or bottom of the world
+    GLint chunkY = chunk.chunk_position_y + dy;
+    if(chunkY < 0 || chunkY >= (GLint)World::chunksTall)
+        return;
+
+    GLuint neighbourIndex = Chunk::NeighbourIndex(dx, dy, dz);
+    for(FeatureEdits &edits : outsideEdits)
+    {
+        if(edits.neighbourIndex == neighbourIndex)
+        {
+            edits.blocks.push_back(block);
+            return;
+        }
+    }
+    outsideEdits.push_back(FeatureEdits{ neighbourIndex, { block } });
+}
+
+
+
+void FeaturePlacer::PlaceTrees(Chunk &chunk, GLuint seed, const GLint *surfaceHeights, std::vector<FeatureEdits> &outsideEdits)
+{
+    const Biome_Configuration &biome = BiomeConfiguration[chunk.biomeID];
+    if(biome.TreeFrequency == -1)
+        return;
+
+    const GLint oakLogBlockID = blockRegistry.GetID("Oak_Log");
+    const GLint oakLeavesBlockID = blockRegistry.GetID("Oak_Leaves");
+    const GLint chunkBottomY = chunk.chunk_position_y * (GLint)World::chunkHeightY;
+
+    for(GLint z = 0; z < (GLint)World::chunkDepthZ; z++)
+    for(GLint x = 0; x < (GLint)World::chunkWidthX; x++)
+    {
+        // The chunk holding the bottom of the trunk grows the tree
+        GLint y = surfaceHeights[x + z * World::chunkWidthX] - chunkBottomY;
+        if(y < 0 || y >= (GLint)World::chunkHeightY)
+            continue;
+
+        GLint worldX = chunk.chunk_position_x * (GLint)World::chunkWidthX + x;
+        GLint worldZ = chunk.chunk_position_z * (GLint)World::chunkDepthZ + z;
+        if(ColumnHash(seed, worldX, worldZ) % biome.TreeFrequency != 0)
+            continue;
+        // No trees growing out of water
+        if(chunk.chunkBlocks.GetBlockType(x, y, z) != BlockRegistry::Air)
+            continue;
+
+        for(GLint i = 0; i < treeTrunkHeight; i++)
+            PlaceBlock(chunk, x, y + i, z, oakLogBlockID, outsideEdits);
+
+        GLint leavesY = y + treeTrunkHeight;
+        for(GLint j = -2; j <= 2; j++)
+        for(GLint i = -2; i <= 2; i++)
+            PlaceBlock(chunk, x + i, leavesY, z + j, oakLeavesBlockID, outsideEdits);
+        for(GLint j = -1; j <= 1; j++)
+        for(GLint i = -1; i <= 1; i++)
+            PlaceBlock(chunk, x + i, leavesY + 1, z + j, oakLeavesBlockID, outsideEdits);
+    }
+}
+
+
+
+void FeaturePlacer::ApplyBlock(BlockStorage &blocks, const FeatureBlock &block)
+{
+    GLint existing = blocks.GetBlockType(block.x, block.y, block.z);
+    if(existing == BlockRegistry::Air || (blockRegistry.IsFoliage(existing) && !blockRegistry.IsFoliage(block.blockTypeID)))
+        blocks.SetBlockType(block.x, block.y, block.z, block.blockTypeID);
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "BlockStorage.hpp"
+#include "WorldConstants.hpp"
+
+#include <glad/glad.h>
+#include <vector> // For std::vector
+
+class Chunk;
+
+
+
+// One block a feature (like a tree) puts down, in the coordinates of the chunk it lands in
+struct FeatureBlock
+{
+    GLubyte x, y, z;
+    GLint blockTypeID;
+};
+
+// The blocks a chunk's features put in one of its neighbours
+struct FeatureEdits
+{
+    GLuint neighbourIndex; // Which neighbour, see Chunk::NeighbourIndex
+    std::vector<FeatureBlock> blocks;
+};
+
+
+
+// Places trees (and anything else that grows on top of the terrain) once a
+// chunk's ground is down. Whether a column grows a tree only depends on the
+// world seed and the column's world position, never on what generated
+// before it, so the same seed always grows the same forest no matter which
+// order or which threads chunks generate on.
+//
+// Blocks a feature puts outside its own chunk are handed back as
+// FeatureEdits. The chunk keeps them, and neighbours apply them whenever
+// they (or it) finish generating (see ChunkManager::ExchangeFeatureEdits)
+namespace FeaturePlacer
+{
+    // A well mixed hash of the seed and a world column
+    GLuint ColumnHash(GLuint seed, GLint worldX, GLint worldZ);
+
+    // Grow the trees rooted in the chunk's columns. surfaceHeights holds the world y
+    // of the first air block above the ground in each column, x fastest. Blocks that
+    // land in other chunks are added to outsideEdits instead
+    void PlaceTrees(Chunk &chunk, GLuint seed, const GLint *surfaceHeights, std::vector<FeatureEdits> &outsideEdits);
+
+    // Put a feature's block down. Features only grow into air, and tree trunks
+    // push through leaves, so overlapping features come out the same whichever
+    // is applied first
+    void ApplyBlock(BlockStorage &blocks, const FeatureBlock &block);
+}
@@ -0,0 +1,92 @@
+#include "Frustum.hpp"
+
+#include <cmath> // For sqrt
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define FRUSTUM_USE_SSE
+#include <xmmintrin.h> // SSE intrinsics
+#endif
+
+
+
+void Frustum::Update(const glm::mat4 &viewProjectionMatrix)
+{
+    // Gribb and Hartmann: each plane is the last row of the matrix plus or
+    // minus one of the other rows. glm matrices are column major, so row i is m[0][i], m[1][i], ...
+    const glm::mat4 &m = viewProjectionMatrix;
+    glm::vec4 row0 = glm::vec4(m[0][0], m[1][0], m[2][0], m[3][0]);
+    glm::vec4 row1 = glm::vec4(m[0][1], m[1][1], m[2][1], m[3][1]);
+    glm::vec4 row2 = glm::vec4(m[0][2], m[1][2], m[2][2], m[3][2]);
+    glm::vec4 row3 = glm::vec4(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+    planes[0] = row3 + row0; // Left
+    planes[1] = row3 - row0; // Right
+    planes[2] = row3 + row1; // Bottom
+    planes[3] = row3 - row1; // Top
+    planes[4] = row3 + row2; // Near
+    planes[5] = row3 - row2; // Far
+
+    // Normalize so w is a real distance
+    for(glm::vec4 &plane : planes)
+        plane /= sqrt(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z);
+}
+
+
+
+GLuint Frustum::CullBoxes(const GLfloat *minX, const GLfloat *minY, const GLfloat *minZ,
+                          const GLfloat *maxX, const GLfloat *maxY, const GLfloat *maxZ,
+                          GLuint count, GLubyte *visible) const
+{
+    // For each plane only the box corner furthest along the plane's normal
+    // matters: if even that corner is behind the plane, the whole box is.
+    // Which corner that is only depends on the normal's signs, so we pick
+    // the min or max array per axis once per plane instead of per box
+    const GLfloat *cornerX[6], *cornerY[6], *cornerZ[6];
+    for(GLuint p = 0; p < 6; p++)
+    {
+        cornerX[p] = (planes[p].x >= 0.0f ? maxX : minX);
+        cornerY[p] = (planes[p].y >= 0.0f ? maxY : minY);
+        cornerZ[p] = (planes[p].z >= 0.0f ? maxZ : minZ);
+    }
+
+    GLuint visibleCount = 0;
+    GLuint i = 0;
+#ifdef FRUSTUM_USE_SSE
+    const __m128 zero = _mm_setzero_ps();
+    for(; i + 4 <= count; i += 4)
+    {
+        // All 4 lanes start out inside, and drop out at the first plane they are behind
+        __m128 inside = _mm_cmpeq_ps(zero, zero);
+        for(GLuint p = 0; p < 6; p++)
+        {
+            __m128 distance = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(_mm_set1_ps(planes[p].x), _mm_loadu_ps(cornerX[p] + i)),
+                           _mm_mul_ps(_mm_set1_ps(planes[p].y), _mm_loadu_ps(cornerY[p] + i))),
+                _mm_add_ps(_mm_mul_ps(_mm_set1_ps(planes[p].z), _mm_loadu_ps(cornerZ[p] + i)),
+                           _mm_set1_ps(planes[p].w)));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, zero));
+        }
+
+        GLint mask = _mm_movemask_ps(inside);
+        for(GLuint lane = 0; lane < 4; lane++)
+        {
+            visible[i + lane] = (mask >> lane) & 1;
+            visibleCount += visible[i + lane];
+        }
+    }
+#endif
+
+    // Whatever is left over (or everything, without SSE)
+    for(; i < count; i++)
+    {
+        GLubyte inside = 1;
+        for(GLuint p = 0; p < 6; p++)
+        {
+            GLfloat distance = planes[p].x * cornerX[p][i] + planes[p].y * cornerY[p][i] + planes[p].z * cornerZ[p][i] + planes[p].w;
+            inside &= (distance >= 0.0f);
+        }
+        visible[i] = inside;
+        visibleCount += inside;
+    }
+    return visibleCount;
+}
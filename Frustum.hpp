@@ -0,0 +1,28 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+
+
+// The six planes of a camera's view frustum, for throwing away boxes the
+// camera can't see before we draw them
+class Frustum
+{
+public:
+    // Pull the planes out of a projection * view matrix
+    void Update(const glm::mat4 &viewProjectionMatrix);
+
+    // Test count axis aligned boxes, given as separate arrays of their min and
+    // max corners, against the frustum. visible[i] is set to 1 if box i is at
+    // least partly inside, otherwise 0. Runs 4 boxes at a time where SSE is
+    // available. Returns how many boxes are visible
+    GLuint CullBoxes(const GLfloat *minX, const GLfloat *minY, const GLfloat *minZ,
+                     const GLfloat *maxX, const GLfloat *maxY, const GLfloat *maxZ,
+                     GLuint count, GLubyte *visible) const;
+
+private:
+    // Left, right, bottom, top, near, far. xyz is the normal pointing into the
+    // frustum, w the distance, so dot(normal, point) + w >= 0 means inside
+    glm::vec4 planes[6];
+};
@@ -1,6 +1,8 @@
 #include "GUI.hpp"
 #include "WorldConstants.hpp"
 
+#include <algorithm> // For std::min
+
 
 
 // Vertex information for GUI
@@ -27,6 +29,27 @@ GLfloat crosshairVertices[] = {
 
 
 
+// Where the profiler graph goes, in normalized device coordinates, and how many
+// milliseconds its full height stands for
+static const GLfloat profilerGraphLeft = -0.98f, profilerGraphBottom = -0.98f;
+static const GLfloat profilerGraphWidth = 0.6f, profilerGraphHeight = 0.4f;
+static const GLfloat profilerGraphMs = 33.3f;
+
+// Color of each main thread section in the graph, in ProfileSection order
+static const glm::vec4 profilerSectionColors[] = {
+    glm::vec4(0.9f, 0.9f, 0.9f, 1.0f), // Input
+    glm::vec4(0.2f, 0.6f, 1.0f, 1.0f), // Streaming
+    glm::vec4(1.0f, 0.6f, 0.1f, 1.0f), // Mesh uploads
+    glm::vec4(1.0f, 0.9f, 0.2f, 1.0f), // Mesh queue
+    glm::vec4(0.7f, 0.3f, 0.9f, 1.0f), // Culling
+    glm::vec4(0.2f, 0.8f, 0.3f, 1.0f), // Opaque pass
+    glm::vec4(0.5f, 1.0f, 0.8f, 1.0f), // Transparent pass
+    glm::vec4(1.0f, 0.4f, 0.7f, 1.0f), // GUI
+    glm::vec4(0.9f, 0.2f, 0.2f, 1.0f), // Swap
+};
+
+
+
 GUI::GUI() : guiShaderProgram("shaders/gui.vert", "shaders/gui.frag")  // Member-Initializer List
 {
     GuiVAO.Bind();
@@ -37,6 +60,12 @@ GUI::GUI() : guiShaderProgram("shaders/gui.vert", "shaders/gui.frag")  // Member
 	// Unbind all to prevent accidentally modifying them
 	GuiVBO.Unbind();
     GuiVAO.Unbind();
+
+    ProfilerVAO.Bind();
+    ProfilerVBO.Bind();
+    ProfilerVAO.LinkAttrib(ProfilerVBO, 0, 2, GL_FLOAT, 2 * sizeof(GLfloat), (void*)0);
+    ProfilerVBO.Unbind();
+    ProfilerVAO.Unbind();
 }
 
 
@@ -46,8 +75,72 @@ void GUI::RenderCrosshair()
     // Render the crosshair
     GuiVAO.Bind();
     guiShaderProgram.Activate();
+    guiShaderProgram.SetVec4("guiColor", glm::vec4(1.0f, 1.0f, 1.0f, 1.0f));
     glDrawArrays(GL_TRIANGLES, 0, sizeof(crosshairVertices) / sizeof(GLfloat) / 2);
     GuiVAO.Unbind();
 }
 
 
+
+// Add a rectangle as two triangles
+static void AddRectangle(std::vector<GLfloat> &vertices, GLfloat left, GLfloat bottom, GLfloat right, GLfloat top)
+{
+    GLfloat corners[] = { left, bottom, right, bottom, right, top, right, top, left, top, left, bottom };
+    vertices.insert(vertices.end(), corners, corners + 12);
+}
+
+
+
+void GUI::RenderProfiler(const Profiler &profiler)
+{
+    // One bar per frame, newest on the right. Each bar stacks the frame's main
+    // thread sections bottom to top, so a spike shows which section caused it
+    GLuint frameCount = profiler.GetSampleCount();
+    GLfloat barWidth = profilerGraphWidth / Profiler::historyFrames;
+    GLfloat msToHeight = profilerGraphHeight / profilerGraphMs;
+
+    // Every section's rectangles go after each other, with where each one starts
+    profilerVertices.clear();
+    GLuint sectionStarts[Profile_SectionCount + 1];
+    std::vector<GLfloat> stackTops(frameCount, profilerGraphBottom);
+    GLuint sectionCount = sizeof(profilerSectionColors) / sizeof(profilerSectionColors[0]);
+    for(GLuint section = 0; section < sectionCount; section++)
+    {
+        sectionStarts[section] = profilerVertices.size() / 2;
+        for(GLuint framesAgo = 0; framesAgo < frameCount; framesAgo++)
+        {
+            GLfloat ms = profiler.GetSample(framesAgo).cpuMs[section];
+            if(ms <= 0.0f)
+                continue;
+            GLfloat right = profilerGraphLeft + profilerGraphWidth - framesAgo * barWidth;
+            GLfloat top = std::min(stackTops[framesAgo] + ms * msToHeight, profilerGraphBottom + profilerGraphHeight);
+            AddRectangle(profilerVertices, right - barWidth, stackTops[framesAgo], right, top);
+            stackTops[framesAgo] = top;
+        }
+    }
+    sectionStarts[sectionCount] = profilerVertices.size() / 2;
+    // Lines at 60 and 30 frames per second
+    for(GLfloat ms : { 16.7f, 33.3f })
+    {
+        GLfloat y = profilerGraphBottom + ms * msToHeight;
+        AddRectangle(profilerVertices, profilerGraphLeft, y - 0.002f, profilerGraphLeft + profilerGraphWidth, y + 0.002f);
+    }
+
+    ProfilerVAO.Bind();
+    ProfilerVBO.Bind();
+    glBufferData(GL_ARRAY_BUFFER, profilerVertices.size() * sizeof(GLfloat), profilerVertices.data(), GL_STREAM_DRAW);
+    guiShaderProgram.Activate();
+    for(GLuint section = 0; section < sectionCount; section++)
+    {
+        if(sectionStarts[section + 1] == sectionStarts[section])
+            continue;
+        guiShaderProgram.SetVec4("guiColor", profilerSectionColors[section]);
+        glDrawArrays(GL_TRIANGLES, sectionStarts[section], sectionStarts[section + 1] - sectionStarts[section]);
+    }
+    guiShaderProgram.SetVec4("guiColor", glm::vec4(1.0f, 1.0f, 1.0f, 0.5f));
+    glDrawArrays(GL_TRIANGLES, sectionStarts[sectionCount], profilerVertices.size() / 2 - sectionStarts[sectionCount]);
+    ProfilerVBO.Unbind();
+    ProfilerVAO.Unbind();
+}
+
+
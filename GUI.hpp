@@ -3,6 +3,9 @@
 #include "ShaderManager.hpp"
 #include "VAO.hpp"
 #include "VBO.hpp"
+#include "Profiler.hpp"
+
+#include <vector> // For std::vector
 
 class GUI
 {
@@ -10,6 +13,8 @@ public:
     GUI();
 
     void RenderCrosshair();
+    // Draw the profiler's recent frames as a stacked graph of section times, in the bottom left corner
+    void RenderProfiler(const Profiler &profiler);
 
     Shader guiShaderProgram{"shaders/gui.vert", "shaders/gui.frag"};
 
@@ -17,6 +22,10 @@ private:
     // Buffers for the GUI
     VAO GuiVAO;
     VBO GuiVBO;
+    // Buffers for the profiler graph, refilled every frame it is shown
+    VAO ProfilerVAO;
+    VBO ProfilerVBO;
+    std::vector<GLfloat> profilerVertices;
 };
 
 
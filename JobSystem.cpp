@@ -0,0 +1,103 @@
+#include "JobSystem.hpp"
+
+
+
+JobSystem::JobSystem()
+{
+    // Leave one hardware thread for the main (render) thread
+    GLuint hardwareThreads = std::thread::hardware_concurrency();
+    GLuint workerCount = (hardwareThreads > 1 ? hardwareThreads - 1 : 1);
+
+    for(GLuint i = 0; i < workerCount; i++)
+        workers.emplace_back(&JobSystem::WorkerLoop, this);
+}
+
+
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(jobsMutex);
+        stopping = true;
+    }
+    jobAvailable.notify_all();
+
+    for(std::thread &worker : workers)
+        worker.join();
+}
+
+
+
+void JobSystem::Submit(std::function<void()> job)
+{
+    {
+        std::lock_guard<std::mutex> lock(jobsMutex);
+        jobs.push_back(std::move(job));
+    }
+    jobAvailable.notify_one();
+}
+
+
+
+void JobSystem::WaitForIdle()
+{
+    std::unique_lock<std::mutex> lock(jobsMutex);
+    while(!jobs.empty() || runningJobs > 0)
+    {
+        std::function<void()> job;
+        if(TakeJob(job))
+        {
+            // Help out instead of waiting
+            lock.unlock();
+            job();
+            lock.lock();
+            runningJobs--;
+        }
+        else
+        {
+            jobFinished.wait(lock);
+        }
+    }
+}
+
+
+
+GLuint JobSystem::GetWorkerCount() const
+{
+    return workers.size();
+}
+
+
+
+void JobSystem::WorkerLoop()
+{
+    std::unique_lock<std::mutex> lock(jobsMutex);
+    while(true)
+    {
+        jobAvailable.wait(lock, [this] { return stopping || !jobs.empty(); });
+        // Finish whatever is queued before stopping
+        if(jobs.empty() && stopping)
+            return;
+
+        std::function<void()> job;
+        TakeJob(job);
+        lock.unlock();
+        job();
+        lock.lock();
+        runningJobs--;
+        jobFinished.notify_all();
+    }
+}
+
+
+
+GLboolean JobSystem::TakeJob(std::function<void()> &job)
+{
+    if(jobs.empty())
+        return false;
+
+    job = std::move(jobs.front());
+    jobs.pop_front();
+    runningJobs++;
+    return true;
+}
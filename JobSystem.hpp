@@ -0,0 +1,49 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <condition_variable> // For std::condition_variable
+#include <deque> // For std::deque
+#include <functional> // For std::function
+#include <mutex> // For std::mutex
+#include <thread> // For std::thread
+#include <vector> // For std::vector
+
+
+
+// A pool of worker threads, one per spare hardware thread, that run jobs
+// pushed from the main thread. Jobs must not touch OpenGL, only the main
+// thread owns the context
+class JobSystem
+{
+public:
+    // Singleton Design
+    static JobSystem &Instance()
+    {
+        static JobSystem instance;
+        return instance;
+    }
+    JobSystem();  // Constructor, starts the workers
+    ~JobSystem(); // Destructor, finishes queued jobs and joins the workers
+
+    // Queue a job for the next free worker
+    void Submit(std::function<void()> job);
+    // Block until every submitted job has finished. The calling thread runs
+    // queued jobs too while it waits, so it is never just sitting idle
+    void WaitForIdle();
+    // How many worker threads we started
+    GLuint GetWorkerCount() const;
+
+private:
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> jobs;
+    std::mutex jobsMutex;
+    std::condition_variable jobAvailable; // Signalled when a job is queued or we are stopping
+    std::condition_variable jobFinished;  // Signalled when a running job completes
+    GLuint runningJobs = 0;
+    GLboolean stopping = false;
+
+    // What each worker thread runs until we are destroyed
+    void WorkerLoop();
+    // Pop the next job, if there is one. Must hold jobsMutex
+    GLboolean TakeJob(std::function<void()> &job);
+};
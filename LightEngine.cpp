@@ -0,0 +1,344 @@
+#include "LightEngine.hpp"
+#include "BlockRegistry.hpp"
+
+#include <algorithm> // For std::max
+
+
+
+// Where each channel sits in a packed light byte (see LightStorage)
+static const GLuint skyShift = 4;
+static const GLuint blockShift = 0;
+
+// Which way each face looks, in BlockFaces order
+static const GLint faceOffsets[6][3] = { {0, 0, -1}, {0, 0, 1}, {-1, 0, 0}, {1, 0, 0}, {0, 1, 0}, {0, -1, 0} };
+
+
+
+// Light level of one channel of a block
+static inline GLuint Level(const Chunk *chunk, GLuint index, GLuint shift)
+{
+    return (chunk->light.Get(index) >> shift) & 15;
+}
+
+// Set one channel of a block's light, and remesh whatever shows it
+static inline void SetLevel(Chunk *chunk, GLint x, GLint y, GLint z, GLuint shift, GLuint level)
+{
+    GLuint index = LightStorage::Index(x, y, z);
+    chunk->light.Set(index, (chunk->light.Get(index) & ~(15u << shift)) | level << shift);
+    chunk->RebuildMeshAround(x, y, z);
+}
+
+
+
+// Step from block x, y, z of chunk to the block next to it through face faceIndex,
+// moving into the neighbouring chunk if it is over the border. False if that
+// chunk isn't loaded or lit, light stops there
+static inline GLboolean Neighbour(Chunk *&chunk, GLint &x, GLint &y, GLint &z, GLuint faceIndex)
+{
+    x += faceOffsets[faceIndex][0];
+    y += faceOffsets[faceIndex][1];
+    z += faceOffsets[faceIndex][2];
+    GLint dx = (x < 0 ? -1 : (x >= (GLint)World::chunkWidthX  ? 1 : 0));
+    GLint dy = (y < 0 ? -1 : (y >= (GLint)World::chunkHeightY ? 1 : 0));
+    GLint dz = (z < 0 ? -1 : (z >= (GLint)World::chunkDepthZ  ? 1 : 0));
+    if(dx != 0 || dy != 0 || dz != 0)
+    {
+        chunk = chunk->neighbours[Chunk::NeighbourIndex(dx, dy, dz)];
+        x -= dx * (GLint)World::chunkWidthX;
+        y -= dy * (GLint)World::chunkHeightY;
+        z -= dz * (GLint)World::chunkDepthZ;
+    }
+    return chunk != nullptr && chunk->lit;
+}
+
+
+
+void LightEngine::Propagate(std::vector<LightNode> &adds, GLuint shift)
+{
+    // The queue is a plain vector we read from the front of, so it never gives memory back
+    for(size_t head = 0; head < adds.size(); head++)
+    {
+        // Copied out, pushing can move the vector
+        LightNode node = adds[head];
+        GLuint level = Level(node.chunk, LightStorage::Index(node.x, node.y, node.z), shift);
+        if(level <= 1)
+            continue;
+
+        for(GLuint faceIndex = 0; faceIndex < 6; faceIndex++)
+        {
+            Chunk *chunk = node.chunk;
+            GLint x = node.x, y = node.y, z = node.z;
+            if(!Neighbour(chunk, x, y, z, faceIndex))
+                continue;
+            // Full skylight keeps going straight down as far as it can
+            GLuint spread = (shift == skyShift && faceIndex == Bottom_Face && level == LightStorage::maxLevel ? level : level - 1);
+            if(Level(chunk, LightStorage::Index(x, y, z), shift) >= spread)
+                continue;
+            if(blockRegistry.IsOpaque(chunk->chunkBlocks.GetBlockType(x, y, z)))
+                continue;
+
+            SetLevel(chunk, x, y, z, shift, spread);
+            adds.push_back(LightNode{ chunk, (GLubyte)x, (GLubyte)y, (GLubyte)z, (GLubyte)spread });
+        }
+    }
+    adds.clear();
+}
+
+
+
+void LightEngine::Unpropagate(std::vector<LightNode> &removals, std::vector<LightNode> &adds, GLuint shift)
+{
+    for(size_t head = 0; head < removals.size(); head++)
+    {
+        LightNode node = removals[head];
+        for(GLuint faceIndex = 0; faceIndex < 6; faceIndex++)
+        {
+            Chunk *chunk = node.chunk;
+            GLint x = node.x, y = node.y, z = node.z;
+            if(!Neighbour(chunk, x, y, z, faceIndex))
+                continue;
+            GLuint level = Level(chunk, LightStorage::Index(x, y, z), shift);
+            if(level == 0)
+                continue;
+
+            // Dimmer neighbours (and full skylight straight below) could only have had
+            // their light from the removed block, the rest keep it and fill back in
+            GLboolean litByNode = level < node.level || (shift == skyShift && faceIndex == Bottom_Face && node.level == LightStorage::maxLevel);
+            if(!litByNode)
+            {
+                adds.push_back(LightNode{ chunk, (GLubyte)x, (GLubyte)y, (GLubyte)z, (GLubyte)level });
+                continue;
+            }
+            SetLevel(chunk, x, y, z, shift, 0);
+            removals.push_back(LightNode{ chunk, (GLubyte)x, (GLubyte)y, (GLubyte)z, (GLubyte)level });
+
+            // A dimmer block that glows itself lights back up straight away
+            GLuint emission = (shift == blockShift ? blockRegistry.Emission(chunk->chunkBlocks.GetBlockType(x, y, z)) : 0);
+            if(emission > 0)
+            {
+                SetLevel(chunk, x, y, z, shift, emission);
+                adds.push_back(LightNode{ chunk, (GLubyte)x, (GLubyte)y, (GLubyte)z, (GLubyte)emission });
+            }
+        }
+    }
+    removals.clear();
+}
+
+
+
+GLboolean LightEngine::LightColumn(Chunk *chunk)
+{
+    Chunk *column[World::chunksTall];
+    for(GLint chunkY = 0; chunkY < (GLint)World::chunksTall; chunkY++)
+    {
+        column[chunkY] = chunks_.Get(glm::ivec3(chunk->chunk_position_x, chunkY, chunk->chunk_position_z));
+        if(column[chunkY] == nullptr || !column[chunkY]->generated || column[chunkY]->lit)
+            return false;
+    }
+
+    // Skylight straight down each column of blocks until something opaque stops it.
+    // skyFloor is the lowest y (counting from the bottom of the world) it reaches
+    const GLuint columnCount = World::chunkWidthX * World::chunkDepthZ;
+    const GLubyte fullSky = LightStorage::Pack(LightStorage::maxLevel, 0);
+    GLboolean open[columnCount];
+    GLint skyFloor[columnCount];
+    GLuint openCount = columnCount;
+    for(GLuint i = 0; i < columnCount; i++)
+    {
+        open[i] = true;
+        skyFloor[i] = World::heightLimit;
+    }
+    for(GLint chunkY = World::chunksTall - 1; chunkY >= 0; chunkY--)
+    {
+        Chunk *current = column[chunkY];
+        GLint blockTypeID;
+        GLboolean uniform = current->chunkBlocks.IsUniform(blockTypeID);
+        // The open sky above the ground and the solid rock under it need no array
+        if(uniform && openCount == columnCount && !blockRegistry.IsOpaque(blockTypeID))
+        {
+            current->light.Fill(fullSky);
+            for(GLuint i = 0; i < columnCount; i++)
+                skyFloor[i] = chunkY * World::chunkHeightY;
+            continue;
+        }
+        current->light.Fill(0);
+        if(uniform && blockRegistry.IsOpaque(blockTypeID))
+        {
+            for(GLuint i = 0; i < columnCount; i++)
+                open[i] = false;
+            openCount = 0;
+        }
+
+        for(GLint y = World::chunkHeightY - 1; y >= 0 && openCount > 0; y--)
+        for(GLint z = 0; z < (GLint)World::chunkDepthZ; z++)
+        for(GLint x = 0; x < (GLint)World::chunkWidthX; x++)
+        {
+            GLuint i = x + z * World::chunkWidthX;
+            if(!open[i])
+                continue;
+            if(blockRegistry.IsOpaque(current->chunkBlocks.GetBlockType(x, y, z)))
+            {
+                open[i] = false;
+                openCount--;
+                continue;
+            }
+            current->light.Set(LightStorage::Index(x, y, z), fullSky);
+            skyFloor[i] = chunkY * World::chunkHeightY + y;
+        }
+    }
+    for(Chunk *current : column)
+        current->lit = true;
+
+    // Where a column of blocks gets the sky further down than the one next to it,
+    // the open blocks beside the lower one light sideways into the higher one
+    for(GLint z = 0; z < (GLint)World::chunkDepthZ; z++)
+    for(GLint x = 0; x < (GLint)World::chunkWidthX; x++)
+    {
+        GLint i = x + z * World::chunkWidthX;
+        GLint top = skyFloor[i];
+        if(x > 0)
+            top = std::max(top, skyFloor[i - 1]);
+        if(x < (GLint)World::chunkWidthX - 1)
+            top = std::max(top, skyFloor[i + 1]);
+        if(z > 0)
+            top = std::max(top, skyFloor[i - World::chunkWidthX]);
+        if(z < (GLint)World::chunkDepthZ - 1)
+            top = std::max(top, skyFloor[i + World::chunkWidthX]);
+        for(GLint columnY = skyFloor[i]; columnY < top; columnY++)
+            skyAdds.push_back(LightNode{ column[columnY / World::chunkHeightY], (GLubyte)x, (GLubyte)(columnY % World::chunkHeightY), (GLubyte)z, LightStorage::maxLevel });
+    }
+
+    // Glowing blocks. Only sections whose palette has one in it are searched
+    for(Chunk *current : column)
+    for(GLuint sectionIndex = 0; sectionIndex < BlockStorage::sectionCount; sectionIndex++)
+    {
+        GLboolean glows = false;
+        for(GLint blockTypeID : current->chunkBlocks.GetSection(sectionIndex).GetPalette())
+            glows |= (blockRegistry.Emission(blockTypeID) > 0);
+        if(!glows)
+            continue;
+
+        const GLint sectionSize = World::blockSectionSize;
+        GLint sectionX = sectionIndex % BlockStorage::sectionsX * sectionSize;
+        GLint sectionZ = sectionIndex / BlockStorage::sectionsX % BlockStorage::sectionsZ * sectionSize;
+        GLint sectionY = sectionIndex / (BlockStorage::sectionsX * BlockStorage::sectionsZ) * sectionSize;
+        for(GLint y = sectionY; y < sectionY + sectionSize; y++)
+        for(GLint z = sectionZ; z < sectionZ + sectionSize; z++)
+        for(GLint x = sectionX; x < sectionX + sectionSize; x++)
+        {
+            GLuint emission = blockRegistry.Emission(current->chunkBlocks.GetBlockType(x, y, z));
+            if(emission == 0)
+                continue;
+            SetLevel(current, x, y, z, blockShift, emission);
+            blockAdds.push_back(LightNode{ current, (GLubyte)x, (GLubyte)y, (GLubyte)z, (GLubyte)emission });
+        }
+    }
+
+    ExchangeBorderLight(column);
+    Propagate(skyAdds, skyShift);
+    Propagate(blockAdds, blockShift);
+    return true;
+}
+
+
+
+void LightEngine::ExchangeBorderLight(Chunk *const column[World::chunksTall])
+{
+    for(GLuint faceIndex = Back_Face; faceIndex <= Right_Face; faceIndex++)
+    for(GLint chunkY = 0; chunkY < (GLint)World::chunksTall; chunkY++)
+    {
+        Chunk *current = column[chunkY];
+        Chunk *neighbour = current->neighbours[Chunk::NeighbourIndex(faceOffsets[faceIndex][0], 0, faceOffsets[faceIndex][2])];
+        if(neighbour == nullptr || !neighbour->lit)
+            continue;
+
+        // Our layer of blocks against that side, and the neighbour's against ours
+        for(GLint y = 0; y < (GLint)World::chunkHeightY; y++)
+        for(GLint a = 0; a < (GLint)World::chunkSize; a++)
+        {
+            GLint x = a, z = a, neighbourX = a, neighbourZ = a;
+            if(faceIndex == Back_Face || faceIndex == Front_Face)
+            {
+                z = (faceIndex == Back_Face ? 0 : World::chunkDepthZ - 1);
+                neighbourZ = World::chunkDepthZ - 1 - z;
+            }
+            else
+            {
+                x = (faceIndex == Left_Face ? 0 : World::chunkWidthX - 1);
+                neighbourX = World::chunkWidthX - 1 - x;
+            }
+
+            GLubyte ours = current->light.Get(LightStorage::Index(x, y, z));
+            GLubyte theirs = neighbour->light.Get(LightStorage::Index(neighbourX, y, neighbourZ));
+            // Whichever side is more than a level brighter spreads into the other
+            for(GLuint shift : { skyShift, blockShift })
+            {
+                GLuint ourLevel = (ours >> shift) & 15;
+                GLuint theirLevel = (theirs >> shift) & 15;
+                std::vector<LightNode> &adds = (shift == skyShift ? skyAdds : blockAdds);
+                if(ourLevel > theirLevel + 1)
+                    adds.push_back(LightNode{ current, (GLubyte)x, (GLubyte)y, (GLubyte)z, (GLubyte)ourLevel });
+                else if(theirLevel > ourLevel + 1)
+                    adds.push_back(LightNode{ neighbour, (GLubyte)neighbourX, (GLubyte)y, (GLubyte)neighbourZ, (GLubyte)theirLevel });
+            }
+        }
+    }
+}
+
+
+
+void LightEngine::BlockChanged(Chunk *chunk, GLint x, GLint y, GLint z, GLint previousBlockTypeID)
+{
+    // Light only cares whether a block stops it and how much it glows. Skylight
+    // only changes if whether it stops light did
+    GLint blockTypeID = chunk->chunkBlocks.GetBlockType(x, y, z);
+    GLboolean opaque = blockRegistry.IsOpaque(blockTypeID);
+    GLuint emission = blockRegistry.Emission(blockTypeID);
+    GLboolean opacityChanged = (opaque != blockRegistry.IsOpaque(previousBlockTypeID));
+    if(!opacityChanged && emission == blockRegistry.Emission(previousBlockTypeID))
+        return;
+
+    // Take away the block's light, and everything it lit
+    GLubyte light = chunk->light.Get(LightStorage::Index(x, y, z));
+    if(opacityChanged && LightStorage::SkyLight(light) > 0)
+    {
+        SetLevel(chunk, x, y, z, skyShift, 0);
+        skyRemovals.push_back(LightNode{ chunk, (GLubyte)x, (GLubyte)y, (GLubyte)z, (GLubyte)LightStorage::SkyLight(light) });
+    }
+    if(LightStorage::BlockLight(light) > 0)
+    {
+        SetLevel(chunk, x, y, z, blockShift, 0);
+        blockRemovals.push_back(LightNode{ chunk, (GLubyte)x, (GLubyte)y, (GLubyte)z, (GLubyte)LightStorage::BlockLight(light) });
+    }
+    Unpropagate(skyRemovals, skyAdds, skyShift);
+    Unpropagate(blockRemovals, blockAdds, blockShift);
+
+    // Then let the light around it back in, and its own out
+    if(!opaque)
+    {
+        for(GLuint faceIndex = 0; faceIndex < 6; faceIndex++)
+        {
+            Chunk *neighbour = chunk;
+            GLint neighbourX = x, neighbourY = y, neighbourZ = z;
+            if(!Neighbour(neighbour, neighbourX, neighbourY, neighbourZ, faceIndex))
+                continue;
+            LightNode node{ neighbour, (GLubyte)neighbourX, (GLubyte)neighbourY, (GLubyte)neighbourZ, 0 };
+            if(opacityChanged)
+                skyAdds.push_back(node);
+            blockAdds.push_back(node);
+        }
+        // Nothing sits above the top of the world to hand the sky down
+        if(opacityChanged && chunk->chunk_position_y == (GLint)World::chunksTall - 1 && y == (GLint)World::chunkHeightY - 1)
+        {
+            SetLevel(chunk, x, y, z, skyShift, LightStorage::maxLevel);
+            skyAdds.push_back(LightNode{ chunk, (GLubyte)x, (GLubyte)y, (GLubyte)z, LightStorage::maxLevel });
+        }
+    }
+    if(emission > 0)
+    {
+        SetLevel(chunk, x, y, z, blockShift, emission);
+        blockAdds.push_back(LightNode{ chunk, (GLubyte)x, (GLubyte)y, (GLubyte)z, (GLubyte)emission });
+    }
+    Propagate(skyAdds, skyShift);
+    Propagate(blockAdds, blockShift);
+}
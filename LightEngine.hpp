@@ -0,0 +1,61 @@
+#pragma once
+
+#include "Chunk.hpp"
+#include "WorldConstants.hpp"
+
+#include <glad/glad.h>
+#include <vector> // For std::vector
+
+
+
+// Voxel lighting for every loaded chunk. Skylight falls straight down from the
+// top of the world without dimming, and block light starts at blocks with an
+// emission in blocks.json. Both then spread out a level dimmer per block with
+// breadth first flood fills, through any block that isn't opaque, across chunk
+// borders.
+//
+// A whole column of chunks is lit at once, when the last of them has its
+// terrain. After that every block change only relights the blocks around it:
+// the light it blocked or gave off is flood filled away, then the light around
+// it is flood filled back in. The queues are kept between calls, so once they
+// have grown an edit relights without touching the heap. Chunks whose light
+// changed get their meshes rebuilt. Main thread only, like the blocks it reads
+class LightEngine
+{
+public:
+    // Light the column of chunks the chunk is in, if every chunk in it has its
+    // terrain and it isn't lit yet. Light already in the lit columns around it
+    // spreads in, and its own spreads out into them. Returns whether it got lit
+    GLboolean LightColumn(Chunk *chunk);
+    // Relight around the block at x, y, z of a lit chunk after it changed from
+    // previousBlockTypeID to whatever is there now
+    void BlockChanged(Chunk *chunk, GLint x, GLint y, GLint z, GLint previousBlockTypeID);
+
+private:
+    // One block in a flood fill
+    struct LightNode
+    {
+        Chunk *chunk;
+        GLubyte x, y, z;
+        // The light level the block had, for removals
+        GLubyte level;
+    };
+    // Blocks to spread light out from, and blocks whose light was taken away and
+    // has to be taken from whatever it lit, for skylight and block light
+    std::vector<LightNode> skyAdds, blockAdds;
+    std::vector<LightNode> skyRemovals, blockRemovals;
+
+    // Spread light out from every block in the queue, then empty it. shift
+    // picks the channel, the high 4 bits of the packed light for skylight
+    void Propagate(std::vector<LightNode> &adds, GLuint shift);
+    // Darken everything the blocks in removals lit, then empty it. Blocks lit
+    // from somewhere else go in adds, to fill the dark back in from
+    void Unpropagate(std::vector<LightNode> &removals, std::vector<LightNode> &adds, GLuint shift);
+    // Flood fill in the light of the lit columns on each side of the column
+    // wherever they are brighter than it, and the other way around
+    void ExchangeBorderLight(Chunk *const column[World::chunksTall]);
+};
+
+// Lights every loaded chunk. The chunk manager lights columns as they generate,
+// and anything that changes a lit chunk's blocks tells it
+inline LightEngine lightEngine_;
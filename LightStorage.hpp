@@ -0,0 +1,65 @@
+#pragma once
+
+#include "WorldConstants.hpp"
+
+#include <glad/glad.h>
+#include <vector> // For std::vector
+
+
+
+// Light levels of every block of one chunk, a byte per block: skylight in the
+// high 4 bits and block light in the low 4, each 0 (dark) to 15. A chunk whose
+// blocks all have the same light (the open sky above the ground, solid rock
+// below it) keeps one value and no array at all
+class LightStorage
+{
+public:
+    // Brightest light level, what the open sky and the brightest blocks give
+    static const GLuint maxLevel = 15;
+
+    // Every block starts out with the same packed light, dark unless told otherwise
+    explicit LightStorage(GLubyte light = 0) : uniformLight(light) {}
+
+    // Pack a skylight and a block light level into one byte
+    static GLubyte Pack(GLuint skyLight, GLuint blockLight) { return (GLubyte)(skyLight << 4 | blockLight); }
+    static GLuint SkyLight(GLubyte light) { return light >> 4; }
+    static GLuint BlockLight(GLubyte light) { return light & 15; }
+
+    // Formula for a block is: [x + z*chunkWidthX + y*chunkWidthX*chunkDepthZ], like a face mask
+    static GLuint Index(GLint x, GLint y, GLint z)
+    {
+        return x + z * World::chunkWidthX + y * World::chunkWidthX * World::chunkDepthZ;
+    }
+
+    // Packed light of the block at index
+    GLubyte Get(GLuint index) const { return levels.empty() ? uniformLight : levels[index]; }
+    // Set the packed light of the block at index. The first value that differs
+    // from the rest of a uniform chunk gives it its array
+    void Set(GLuint index, GLubyte light)
+    {
+        if(levels.empty())
+        {
+            if(light == uniformLight)
+                return;
+            levels.assign(World::chunkVolume, uniformLight);
+        }
+        levels[index] = light;
+    }
+    // Give every block the same packed light, freeing the array
+    void Fill(GLubyte light)
+    {
+        std::vector<GLubyte>().swap(levels);
+        uniformLight = light;
+    }
+    // Whether every block has the same light, and which
+    GLboolean IsUniform(GLubyte &light) const
+    {
+        light = uniformLight;
+        return levels.empty();
+    }
+
+private:
+    // Empty while every block has uniformLight
+    std::vector<GLubyte> levels;
+    GLubyte uniformLight = 0;
+};
@@ -2,12 +2,40 @@
 #include "WindowManager.hpp"
 #include "WorldConstants.hpp"
 #include "Chunk.hpp"
+#include "LightEngine.hpp"
 #include "Block.hpp"
+#include "BlockRegistry.hpp"
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h> 
 #include <iostream>
-#include <math.h>  
+
+
+
+// Split a world block position into the position of the chunk holding it and
+// the block's position inside that chunk
+static glm::ivec3 WorldToChunk(glm::ivec3 worldPosition, glm::ivec3 &localPosition)
+{
+    const glm::ivec3 chunkSize(World::chunkWidthX, World::chunkHeightY, World::chunkDepthZ);
+    glm::ivec3 chunkPosition;
+    for(GLint axis = 0; axis < 3; axis++)
+    {
+        // Round towards negative infinity, so block -1 is in chunk -1
+        chunkPosition[axis] = (worldPosition[axis] >= 0 ? worldPosition[axis] : worldPosition[axis] - chunkSize[axis] + 1) / chunkSize[axis];
+        localPosition[axis] = worldPosition[axis] - chunkPosition[axis] * chunkSize[axis];
+    }
+    return chunkPosition;
+}
+
+
+
+// The loaded chunk at a chunk position, or nullptr if it isn't loaded or a
+// worker is still generating its terrain
+static Chunk *GetGeneratedChunk(glm::ivec3 position)
+{
+    Chunk *chunk = chunks_.Get(position);
+    return (chunk != nullptr && chunk->generated ? chunk : nullptr);
+}
 
 
 
@@ -56,67 +84,9 @@ void Player::ProcessInput(glm::vec3 playerPosition, glm::vec3 playerOrientation)
             // Reset our timer for counting elapsed time
             previous_seconds = current_seconds;
 
-            // Determine which chunk we are in
-            glm::vec3 playerCurrentChunk = glm::vec3(floor((GLfloat)playerPosition.x / (GLfloat)World::chunkWidthX), floor((GLfloat)playerPosition.y / (GLfloat)World::chunkHeightY), floor((GLfloat)playerPosition.z / (GLfloat)World::chunkDepthZ));
-
-            if(chunks_.find(playerCurrentChunk) != chunks_.end())
-            {
-                // Get our chunk offsets so we can determine the local position of blocks
-                // in their chunk given their world/global position
-                GLint chunk_offset_x = chunks_[playerCurrentChunk]->offset_x;
-                GLint chunk_offset_y = chunks_[playerCurrentChunk]->offset_y;
-                GLint chunk_offset_z = chunks_[playerCurrentChunk]->offset_z;
-
-                GLfloat stepScaleAmount = 0.1f ;
-                GLuint index = 0;
-                // Step forward 100 times towards the player's orientation until we hit a limit
-                // or we hit a block we can break
-                glm::vec3 tempPlayerPosition = glm::vec3((GLint)playerPosition.x - chunk_offset_x + (playerPosition.x < 0 ? -1 : 0), (GLint)playerPosition.y - chunk_offset_y, (GLint)playerPosition.z - chunk_offset_z + (playerPosition.z < 0 ? -1 : 0));
-                while(chunks_[playerCurrentChunk]->GetBlock(tempPlayerPosition).blockTypeID == blocks["Air"]["index"] && index < World::playerReachScaleAmount)
-                {
-                    playerPosition = glm::vec3(playerPosition.x + playerOrientation.x * stepScaleAmount , playerPosition.y + playerOrientation.y * stepScaleAmount , playerPosition.z + playerOrientation.z * stepScaleAmount );
-                    playerCurrentChunk = glm::vec3(floor(playerPosition.x / ((GLfloat)World::chunkWidthX )), floor(playerPosition.y / ((GLfloat)World::chunkHeightY )), floor(playerPosition.z / ((GLfloat)World::chunkDepthZ )));
-                    // If the new block position we step forward to is in a chunk that is not rendered, break out of the loop
-                    if(playerPosition.y < 0 || chunks_.find(playerCurrentChunk) == chunks_.end())// We went out of bounds
-                    {
-                        break;
-                    }
-                    chunk_offset_x = chunks_[playerCurrentChunk]->offset_x;
-                    chunk_offset_y = chunks_[playerCurrentChunk]->offset_y;
-                    chunk_offset_z = chunks_[playerCurrentChunk]->offset_z;
-                    tempPlayerPosition = glm::vec3((GLint)playerPosition.x - chunk_offset_x + (playerPosition.x < 0 ? -1 : 0), (GLint)playerPosition.y - chunk_offset_y, (GLint)playerPosition.z - chunk_offset_z + (playerPosition.z < 0 ? -1 : 0));
-                    index++;
-                }
-                // If we did not go out of bounds
-                if (chunks_.find(playerCurrentChunk) != chunks_.end() && chunks_[playerCurrentChunk]->GetBlock(tempPlayerPosition).blockTypeID != blocks["Air"]["index"])
-                {
-                    // Set the block we are in to air
-                    chunks_[playerCurrentChunk]->SetBlockType(tempPlayerPosition, blocks["Air"]["index"]);
-                    // Rebuild mesh
-                    chunks_[playerCurrentChunk]->RebuildMesh();
-                    // If this block is on a chunk border, also
-                    // update that bordering's chunks mesh
-                    if (tempPlayerPosition.x == 0 && chunks_.find(glm::vec3(playerCurrentChunk.x - 1, playerCurrentChunk.y, playerCurrentChunk.z)) != chunks_.end())
-                    {
-                        chunks_[glm::vec3(playerCurrentChunk.x - 1, playerCurrentChunk.y, playerCurrentChunk.z)]->RebuildMesh();
-                    }
-                    else if (tempPlayerPosition.x == World::chunkWidthX - 1 && chunks_.find(glm::vec3(playerCurrentChunk.x + 1, playerCurrentChunk.y, playerCurrentChunk.z)) != chunks_.end())
-                    {
-                        chunks_[glm::vec3(playerCurrentChunk.x + 1, playerCurrentChunk.y, playerCurrentChunk.z)]->RebuildMesh();
-                    }
-
-                    // For now we are not updating y level chunk borders
-
-                    if (tempPlayerPosition.z == 0 && chunks_.find(glm::vec3(playerCurrentChunk.x, playerCurrentChunk.y, playerCurrentChunk.z - 1)) != chunks_.end())
-                    {
-                        chunks_[glm::vec3(playerCurrentChunk.x, playerCurrentChunk.y, playerCurrentChunk.z - 1)]->RebuildMesh();
-                    }
-                    else if (tempPlayerPosition.z == World::chunkDepthZ - 1 && chunks_.find(glm::vec3(playerCurrentChunk.x, playerCurrentChunk.y, playerCurrentChunk.z + 1)) != chunks_.end())
-                    {
-                        chunks_[glm::vec3(playerCurrentChunk.x, playerCurrentChunk.y, playerCurrentChunk.z + 1)]->RebuildMesh();
-                    }
-                }
-            }
+            RaycastHit target = PickBlock(playerPosition, playerOrientation);
+            if(target.hit)
+                SetWorldBlock(target.block, BlockRegistry::Air);
         }
     }
 
@@ -129,76 +99,64 @@ void Player::ProcessInput(glm::vec3 playerPosition, glm::vec3 playerOrientation)
             // Reset our timer for counting elapsed time
             previous_seconds = current_seconds;
 
-            // Determine which chunk we are in
-            glm::vec3 playerCurrentChunk = glm::vec3(floor((GLfloat)playerPosition.x / (GLfloat)World::chunkWidthX), floor((GLfloat)playerPosition.y / (GLfloat)World::chunkHeightY), floor((GLfloat)playerPosition.z / (GLfloat)World::chunkDepthZ));
-
-            if(chunks_.find(playerCurrentChunk) != chunks_.end())
+            // Place against the face we are looking at, if that spot is loaded and empty.
+            // A ray that starts inside a block has no face to place against.
+            // Holding shift places a glowing block instead of grass
+            GLint placedBlockTypeID = blockRegistry.GetID(glfwGetKey(window_, GLFW_KEY_LEFT_SHIFT) == GLFW_PRESS ? "Glowstone" : "Grass_Top");
+            RaycastHit target = PickBlock(playerPosition, playerOrientation);
+            if(target.hit && target.normal != glm::ivec3(0))
             {
-                // Get our chunk offsets so we can determine the local position of blocks
-                // in their chunk given their world/global position
-                GLint chunk_offset_x = chunks_[playerCurrentChunk]->offset_x;
-                GLint chunk_offset_y = chunks_[playerCurrentChunk]->offset_y;
-                GLint chunk_offset_z = chunks_[playerCurrentChunk]->offset_z;
-
-                GLfloat stepScaleAmount = 0.1f ;
-                GLuint index = 0;
-                // Step forward 100 times towards the player's orientation until we hit a limit
-                // or we hit a block we can break
-                glm::vec3 tempPlayerPosition = glm::vec3((GLint)playerPosition.x - chunk_offset_x + (playerPosition.x < 0 ? -1 : 0), (GLint)playerPosition.y - chunk_offset_y, (GLint)playerPosition.z - chunk_offset_z + (playerPosition.z < 0 ? -1 : 0));
-                while(chunks_[playerCurrentChunk]->GetBlock(tempPlayerPosition).blockTypeID == blocks["Air"]["index"] && index < World::playerReachScaleAmount)
-                {
-                    playerPosition = glm::vec3(playerPosition.x + playerOrientation.x * stepScaleAmount , playerPosition.y + playerOrientation.y * stepScaleAmount , playerPosition.z + playerOrientation.z * stepScaleAmount );
-                    playerCurrentChunk = glm::vec3(floor(playerPosition.x / ((GLfloat)World::chunkWidthX )), floor(playerPosition.y / ((GLfloat)World::chunkHeightY )), floor(playerPosition.z / ((GLfloat)World::chunkDepthZ )));
-                    // If the new block position we step forward to is in a chunk that is not rendered, break out of the loop
-                    if(playerPosition.y < 0 || chunks_.find(playerCurrentChunk) == chunks_.end())// We went out of bounds
-                    {
-                        break;
-                    }
-                    chunk_offset_x = chunks_[playerCurrentChunk]->offset_x;
-                    chunk_offset_y = chunks_[playerCurrentChunk]->offset_y;
-                    chunk_offset_z = chunks_[playerCurrentChunk]->offset_z;
-                    tempPlayerPosition = glm::vec3((GLint)playerPosition.x - chunk_offset_x + (playerPosition.x < 0 ? -1 : 0), (GLint)playerPosition.y - chunk_offset_y, (GLint)playerPosition.z - chunk_offset_z + (playerPosition.z < 0 ? -1 : 0));
-                    index++;
-                }
-                // Go back one spot so we are back to air
-                playerPosition = glm::vec3(playerPosition.x - playerOrientation.x * stepScaleAmount , playerPosition.y - playerOrientation.y * stepScaleAmount , playerPosition.z - playerOrientation.z * stepScaleAmount );
-                playerCurrentChunk = glm::vec3(floor(playerPosition.x / ((GLfloat)World::chunkWidthX )), floor(playerPosition.y / ((GLfloat)World::chunkHeightY )), floor(playerPosition.z / ((GLfloat)World::chunkDepthZ )));
-                chunk_offset_x = chunks_[playerCurrentChunk]->offset_x;
-                chunk_offset_y = chunks_[playerCurrentChunk]->offset_y;
-                chunk_offset_z = chunks_[playerCurrentChunk]->offset_z;
-                tempPlayerPosition = glm::vec3((GLint)playerPosition.x - chunk_offset_x + (playerPosition.x < 0 ? -1 : 0), (GLint)playerPosition.y - chunk_offset_y, (GLint)playerPosition.z - chunk_offset_z + (playerPosition.z < 0 ? -1 : 0));
-                // If we did not go out of bounds and the block is air, we can place a block
-                if (chunks_.find(playerCurrentChunk) != chunks_.end() && chunks_[playerCurrentChunk]->GetBlock(tempPlayerPosition).blockTypeID == blocks["Air"]["index"])
-                {
-                    // Set the block we are in
-                    chunks_[playerCurrentChunk]->SetBlockType(tempPlayerPosition, blocks["Grass_Top"]["index"]);
-                    // Rebuild mesh
-                    chunks_[playerCurrentChunk]->RebuildMesh();
-                    // If this block is on a chunk border, also
-                    // update that bordering's chunks mesh
-                    if (tempPlayerPosition.x == 0 && chunks_.find(glm::vec3(playerCurrentChunk.x - 1, playerCurrentChunk.y, playerCurrentChunk.z)) != chunks_.end())
-                    {
-                        chunks_[glm::vec3(playerCurrentChunk.x - 1, playerCurrentChunk.y, playerCurrentChunk.z)]->RebuildMesh();
-                    }
-                    else if (tempPlayerPosition.x == World::chunkWidthX - 1 && chunks_.find(glm::vec3(playerCurrentChunk.x + 1, playerCurrentChunk.y, playerCurrentChunk.z)) != chunks_.end())
-                    {
-                        chunks_[glm::vec3(playerCurrentChunk.x + 1, playerCurrentChunk.y, playerCurrentChunk.z)]->RebuildMesh();
-                    }
-
-                    // For now we are not updating y level chunk borders
-
-                    if (tempPlayerPosition.z == 0 && chunks_.find(glm::vec3(playerCurrentChunk.x, playerCurrentChunk.y, playerCurrentChunk.z - 1)) != chunks_.end())
-                    {
-                        chunks_[glm::vec3(playerCurrentChunk.x, playerCurrentChunk.y, playerCurrentChunk.z - 1)]->RebuildMesh();
-                    }
-                    else if (tempPlayerPosition.z == World::chunkDepthZ - 1 && chunks_.find(glm::vec3(playerCurrentChunk.x, playerCurrentChunk.y, playerCurrentChunk.z + 1)) != chunks_.end())
-                    {
-                        chunks_[glm::vec3(playerCurrentChunk.x, playerCurrentChunk.y, playerCurrentChunk.z + 1)]->RebuildMesh();
-                    }
-                }
+                glm::ivec3 chunkPosition;
+                Chunk *chunk = GetGeneratedChunk(WorldToChunk(target.placeCell, chunkPosition));
+                if(chunk != nullptr && chunk->GetBlock(chunkPosition.x, chunkPosition.y, chunkPosition.z).blockTypeID == BlockRegistry::Air)
+                    SetWorldBlock(target.placeCell, placedBlockTypeID);
             }
         }
     }
 }
 
 
+
+RaycastHit Player::PickBlock(glm::vec3 playerPosition, glm::vec3 playerOrientation) const
+{
+    // Consecutive cells are nearly always in the same chunk, so only look the chunk up when that changes
+    glm::ivec3 cachedChunkPosition(0);
+    Chunk *cachedChunk = nullptr;
+    GLboolean cached = false;
+    return VoxelRaycast::Cast(playerPosition, playerOrientation, World::playerReach, [&](glm::ivec3 worldPosition) -> GLint {
+        glm::ivec3 localPosition;
+        glm::ivec3 chunkPosition = WorldToChunk(worldPosition, localPosition);
+        // Above and below the world is empty, not unloaded, so the ray carries on
+        // down to (or up to) the terrain
+        if(chunkPosition.y < 0 || chunkPosition.y >= (GLint)World::chunksTall)
+            return BlockRegistry::Air;
+        if(!cached || chunkPosition != cachedChunkPosition)
+        {
+            cachedChunk = GetGeneratedChunk(chunkPosition);
+            cachedChunkPosition = chunkPosition;
+            cached = true;
+        }
+        if(cachedChunk == nullptr)
+            return VoxelRaycast::Unloaded;
+        return cachedChunk->GetBlock(localPosition.x, localPosition.y, localPosition.z).blockTypeID;
+    });
+}
+
+
+
+void Player::SetWorldBlock(glm::ivec3 worldPosition, GLint blockTypeID)
+{
+    glm::ivec3 localPosition;
+    Chunk *chunk = GetGeneratedChunk(WorldToChunk(worldPosition, localPosition));
+    if(chunk == nullptr)
+        return;
+
+    GLint previousBlockTypeID = chunk->chunkBlocks.GetBlockType(localPosition.x, localPosition.y, localPosition.z);
+    chunk->SetBlockType(glm::vec3(localPosition), blockTypeID);
+    chunk->edited = true;
+    // Relight around the block, remeshing wherever its light changed
+    if(chunk->lit)
+        lightEngine_.BlockChanged(chunk, localPosition.x, localPosition.y, localPosition.z, previousBlockTypeID);
+    // Rebuild our mesh, and the meshes of any chunks the block borders
+    chunk->RebuildMeshAround(localPosition.x, localPosition.y, localPosition.z);
+}
@@ -4,6 +4,8 @@
 #include <GLFW/glfw3.h>
 #include <glm/glm.hpp>
 
+#include "VoxelRaycast.hpp"
+
 
 
 class Player
@@ -14,7 +16,13 @@ public:
     // Poll events
     void ProcessInput(glm::vec3 playerPosition, glm::vec3 playerOrientation);
 
+    // The first block the player is looking at within reach, if any
+    RaycastHit PickBlock(glm::vec3 playerPosition, glm::vec3 playerOrientation) const;
+
 private:
     GLFWwindow *window_;
 
+    // Set a block by world position in whatever chunk holds it, and rebuild the meshes it shows up in
+    void SetWorldBlock(glm::ivec3 worldPosition, GLint blockTypeID);
+
 };
\ No newline at end of file
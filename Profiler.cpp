@@ -0,0 +1,232 @@
+#include "Profiler.hpp"
+
+#include <fstream> // For std::ofstream
+#include <iostream>
+
+
+
+// Name and whether it gets GPU timestamps, for each section in ProfileSection order
+static const struct { const char *name; GLboolean gpu; } sectionInfo[Profile_SectionCount] = {
+    { "input",            false },
+    { "streaming",        false },
+    { "mesh_uploads",     true  },
+    { "mesh_queue",       false },
+    { "culling",          false },
+    { "opaque_pass",      true  },
+    { "transparent_pass", true  },
+    { "gui",              true  },
+    { "swap",             false },
+    { "generation",       false },
+    { "mesh_builds",      false },
+};
+// The query slot timing the whole frame on the GPU
+static const GLuint frameQuery = Profile_SectionCount;
+
+
+
+Profiler::~Profiler()
+{
+    // We are first used after the window exists, so we are destroyed before it and its context
+    if(queriesCreated)
+        glDeleteQueries(queryLatency * (Profile_SectionCount + 1) * 2, &queries[0][0][0]);
+}
+
+
+
+void Profiler::BeginFrame()
+{
+    if(!World::profilerEnabled)
+        return;
+
+    // Needs a GL context, which doesn't exist yet when we are constructed
+    if(!queriesCreated)
+    {
+        glGenQueries(queryLatency * (Profile_SectionCount + 1) * 2, &queries[0][0][0]);
+        for(GLuint slot = 0; slot < queryLatency; slot++)
+            for(GLuint i = 0; i <= Profile_SectionCount; i++)
+                queriesIssued[slot][i] = false;
+        queriesCreated = true;
+    }
+
+    // This frame reuses the queries of the frame queryLatency frames ago, so read those first
+    GLuint slot = frameNumber % queryLatency;
+    ReadQueries(slot);
+
+    FrameSample &sample = CurrentSample();
+    sample.frameNumber = frameNumber;
+    sample.frameMs = 0.0f;
+    sample.gpuFrameMs = -1.0f;
+    for(GLuint i = 0; i < Profile_SectionCount; i++)
+    {
+        sample.cpuMs[i] = -1.0f;
+        sample.gpuMs[i] = -1.0f;
+    }
+
+    frameStart = std::chrono::steady_clock::now();
+    glQueryCounter(queries[slot][frameQuery][0], GL_TIMESTAMP);
+    queriesIssued[slot][frameQuery] = true;
+}
+
+
+
+void Profiler::EndFrame()
+{
+    if(!World::profilerEnabled)
+        return;
+
+    GLuint slot = frameNumber % queryLatency;
+    glQueryCounter(queries[slot][frameQuery][1], GL_TIMESTAMP);
+
+    FrameSample &sample = CurrentSample();
+    sample.frameMs = std::chrono::duration<GLfloat, std::milli>(std::chrono::steady_clock::now() - frameStart).count();
+    // Worker time is whatever finished since the last frame
+    for(GLuint i = 0; i < Profile_SectionCount; i++)
+        if(IsWorkerSection((ProfileSection)i))
+            sample.cpuMs[i] = workerNanoseconds[i].exchange(0) / 1000000.0f;
+
+    frameNumber++;
+}
+
+
+
+void Profiler::BeginSection(ProfileSection section)
+{
+    if(!World::profilerEnabled || !queriesCreated)
+        return;
+
+    sectionStarts[section] = std::chrono::steady_clock::now();
+    if(sectionInfo[section].gpu)
+    {
+        GLuint slot = frameNumber % queryLatency;
+        glQueryCounter(queries[slot][section][0], GL_TIMESTAMP);
+        queriesIssued[slot][section] = true;
+    }
+}
+
+
+
+void Profiler::EndSection(ProfileSection section)
+{
+    if(!World::profilerEnabled || !queriesCreated)
+        return;
+
+    // A section that runs more than once a frame adds up
+    FrameSample &sample = CurrentSample();
+    GLfloat ms = std::chrono::duration<GLfloat, std::milli>(std::chrono::steady_clock::now() - sectionStarts[section]).count();
+    sample.cpuMs[section] = (sample.cpuMs[section] < 0.0f ? ms : sample.cpuMs[section] + ms);
+    if(sectionInfo[section].gpu)
+        glQueryCounter(queries[frameNumber % queryLatency][section][1], GL_TIMESTAMP);
+}
+
+
+
+void Profiler::AddWorkerTime(ProfileSection section, uint64_t nanoseconds)
+{
+    workerNanoseconds[section] += nanoseconds;
+}
+
+
+
+const FrameSample &Profiler::GetSample(GLuint framesAgo) const
+{
+    return samples[(frameNumber - 1 - framesAgo) % historyFrames];
+}
+
+
+
+GLuint Profiler::GetSampleCount() const
+{
+    return (frameNumber < historyFrames ? frameNumber : historyFrames);
+}
+
+
+
+GLboolean Profiler::WriteCSV(const std::string &path) const
+{
+    std::ofstream file(path);
+    if(!file.is_open())
+    {
+        std::cout << "Could not write profile " << path << std::endl;
+        return false;
+    }
+
+    file << "frame,frame_cpu_ms,frame_gpu_ms";
+    for(GLuint i = 0; i < Profile_SectionCount; i++)
+    {
+        file << "," << sectionInfo[i].name << "_cpu_ms";
+        if(sectionInfo[i].gpu)
+            file << "," << sectionInfo[i].name << "_gpu_ms";
+    }
+    file << "\n";
+
+    // Empty cells for times we don't have
+    auto writeTime = [&file](GLfloat ms) {
+        file << ",";
+        if(ms >= 0.0f)
+            file << ms;
+    };
+    for(GLint framesAgo = GetSampleCount() - 1; framesAgo >= 0; framesAgo--)
+    {
+        const FrameSample &sample = GetSample(framesAgo);
+        file << sample.frameNumber;
+        writeTime(sample.frameMs);
+        writeTime(sample.gpuFrameMs);
+        for(GLuint i = 0; i < Profile_SectionCount; i++)
+        {
+            writeTime(sample.cpuMs[i]);
+            if(sectionInfo[i].gpu)
+                writeTime(sample.gpuMs[i]);
+        }
+        file << "\n";
+    }
+    std::cout << "Wrote the last " << GetSampleCount() << " frames of profiling to " << path << std::endl;
+    return true;
+}
+
+
+
+const char *Profiler::SectionName(ProfileSection section)
+{
+    return sectionInfo[section].name;
+}
+
+
+
+GLboolean Profiler::HasGPUTime(ProfileSection section)
+{
+    return sectionInfo[section].gpu;
+}
+
+
+
+void Profiler::ReadQueries(GLuint slot)
+{
+    // The frame that last used this slot, if it is still in our history
+    if(frameNumber < queryLatency)
+        return;
+    GLuint queriedFrame = frameNumber - queryLatency;
+    FrameSample &sample = samples[queriedFrame % historyFrames];
+
+    for(GLuint i = 0; i <= Profile_SectionCount; i++)
+    {
+        if(!queriesIssued[slot][i])
+            continue;
+        queriesIssued[slot][i] = false;
+
+        // Still not done after queryLatency frames means the GPU is far behind,
+        // skip this one rather than wait for it
+        GLint available = 0;
+        glGetQueryObjectiv(queries[slot][i][1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if(!available)
+            continue;
+
+        GLuint64 start, end;
+        glGetQueryObjectui64v(queries[slot][i][0], GL_QUERY_RESULT, &start);
+        glGetQueryObjectui64v(queries[slot][i][1], GL_QUERY_RESULT, &end);
+        GLfloat ms = (end - start) / 1000000.0f;
+        if(i == frameQuery)
+            sample.gpuFrameMs = ms;
+        else
+            sample.gpuMs[i] = ms;
+    }
+}
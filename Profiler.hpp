@@ -0,0 +1,143 @@
+#pragma once
+
+#include "WorldConstants.hpp"
+
+#include <glad/glad.h>
+#include <atomic> // For std::atomic
+#include <chrono> // For std::chrono::steady_clock
+#include <cstdint> // For uint64_t
+#include <string> // For std::string
+
+
+
+// Parts of a frame the profiler times. Keep in step with the table in Profiler.cpp
+typedef enum ProfileSection {
+    Profile_Input,           // Camera and player input
+    Profile_Streaming,       // Loading and unloading chunks around the camera
+    Profile_MeshUploads,     // Sending finished meshes to the GPU
+    Profile_MeshQueue,       // Snapshotting chunks and queueing their mesh jobs
+    Profile_Culling,         // Frustum culling the loaded chunks
+    Profile_OpaquePass,      // Drawing opaque chunk geometry
+    Profile_TransparentPass, // Drawing transparent chunk geometry
+    Profile_GUI,             // Crosshair and profiler overlay
+    Profile_Swap,            // Swapping buffers and polling events
+    Profile_Generation,      // Terrain generation, summed over all workers
+    Profile_MeshBuilds,      // Mesh building, summed over all workers
+    Profile_SectionCount
+} ProfileSection;
+
+
+
+// Times of every section in one frame, in milliseconds. A negative time means the
+// section didn't run (or has no GPU time, or its GPU time hasn't come back yet)
+struct FrameSample
+{
+    GLuint frameNumber = 0;
+    GLfloat frameMs = 0.0f;  // CPU time from BeginFrame to EndFrame
+    GLfloat gpuFrameMs = -1.0f;
+    GLfloat cpuMs[Profile_SectionCount];
+    GLfloat gpuMs[Profile_SectionCount];
+};
+
+
+
+// Per-frame CPU and GPU timings of the main parts of a frame, kept for the
+// last historyFrames frames. Sections are timed with ProfileScope. GPU times
+// come from timestamp queries, read back a few frames later so we never stall
+// waiting on the GPU.
+//
+// All of it compiles away when World::profilerEnabled is off. When it is on,
+// a section costs two clock reads (plus two timestamp queries for GPU sections)
+class Profiler
+{
+public:
+    // How many frames of samples we keep
+    static const GLuint historyFrames = 240;
+    // Frames we wait before reading GPU timestamps back
+    static const GLuint queryLatency = 4;
+
+    // Singleton Design
+    static Profiler &Instance()
+    {
+        static Profiler instance;
+        return instance;
+    }
+    ~Profiler(); // Destructor, deletes our queries
+
+    // Mark the start and end of a frame. Main thread only
+    void BeginFrame();
+    void EndFrame();
+    // Time a section. Main thread sections only, see ProfileScope
+    void BeginSection(ProfileSection section);
+    void EndSection(ProfileSection section);
+    // Add time a worker thread spent on a section. Safe from any thread
+    void AddWorkerTime(ProfileSection section, uint64_t nanoseconds);
+
+    // A frame's sample, 0 being the last finished frame
+    const FrameSample &GetSample(GLuint framesAgo) const;
+    // How many finished frames we have samples for, up to historyFrames
+    GLuint GetSampleCount() const;
+    // Write every sample we have to a CSV file, oldest first
+    GLboolean WriteCSV(const std::string &path) const;
+
+    static const char *SectionName(ProfileSection section);
+    // Whether a section's time comes from worker threads instead of the main thread
+    static GLboolean IsWorkerSection(ProfileSection section) { return section == Profile_Generation || section == Profile_MeshBuilds; }
+    // Whether a section gets GPU timestamps around it
+    static GLboolean HasGPUTime(ProfileSection section);
+
+    // Whether GUI draws the overlay
+    GLboolean overlayVisible = false;
+
+private:
+    FrameSample samples[historyFrames];
+    GLuint frameNumber = 0; // Frames begun so far
+    std::chrono::steady_clock::time_point frameStart;
+    std::chrono::steady_clock::time_point sectionStarts[Profile_SectionCount];
+    std::atomic<uint64_t> workerNanoseconds[Profile_SectionCount] = {};
+
+    // Timestamp queries for the start and end of every GPU section (and the
+    // whole frame, in the last slot), for each frame in flight
+    GLuint queries[queryLatency][Profile_SectionCount + 1][2];
+    // Which of those queries were issued in each frame in flight
+    GLboolean queriesIssued[queryLatency][Profile_SectionCount + 1];
+    GLboolean queriesCreated = false;
+
+    FrameSample &CurrentSample() { return samples[frameNumber % historyFrames]; }
+    // Read back the GPU times of the frame that last used this query slot
+    void ReadQueries(GLuint slot);
+};
+
+
+
+// Times the section it is alive for. Worker sections add their time to the
+// frame it finishes in, main thread sections also get GPU timings if the
+// section has them
+class ProfileScope
+{
+public:
+    ProfileScope(ProfileSection section) : section(section)
+    {
+        if(!World::profilerEnabled)
+            return;
+        if(Profiler::IsWorkerSection(section))
+            start = std::chrono::steady_clock::now();
+        else
+            Profiler::Instance().BeginSection(section);
+    }
+    ~ProfileScope()
+    {
+        if(!World::profilerEnabled)
+            return;
+        if(Profiler::IsWorkerSection(section))
+            Profiler::Instance().AddWorkerTime(section, std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+        else
+            Profiler::Instance().EndSection(section);
+    }
+    ProfileScope(const ProfileScope &) = delete;
+    ProfileScope &operator=(const ProfileScope &) = delete;
+
+private:
+    ProfileSection section;
+    std::chrono::steady_clock::time_point start;
+};
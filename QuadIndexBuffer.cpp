@@ -0,0 +1,47 @@
+#include "QuadIndexBuffer.hpp"
+#include "ChunkMesher.hpp"
+#include "WorldConstants.hpp"
+
+#include <vector> // For std::vector
+
+
+
+void QuadIndexBuffer::Init()
+{
+    if(!ChunkMesher::drawsIndexed)
+        return;
+
+    // Same corner order as the 6 vertex quads, so the winding doesn't change
+    static const GLuint quadCorners[ChunkMesher::indicesPerQuad] = { 0, 1, 2, 1, 0, 3 };
+    std::vector<GLuint> indices(ChunkMesher::maxQuadsPerMesh * ChunkMesher::indicesPerQuad);
+    for(GLuint quad = 0; quad < ChunkMesher::maxQuadsPerMesh; quad++)
+    for(GLuint i = 0; i < ChunkMesher::indicesPerQuad; i++)
+        indices[quad * ChunkMesher::indicesPerQuad + i] = quad * ChunkMesher::verticesPerQuad + quadCorners[i];
+
+    // Nothing can be bound to the element array binding without a VAO in core
+    // profile, so make the buffer through a throwaway one
+    GLuint setupVAO;
+    glGenVertexArrays(1, &setupVAO);
+    glBindVertexArray(setupVAO);
+    indexBuffer.InitEBO(indices.data(), indices.size() * sizeof(GLuint));
+    glBindVertexArray(0);
+    glDeleteVertexArrays(1, &setupVAO);
+    initialized = true;
+}
+
+
+
+void QuadIndexBuffer::Bind()
+{
+    if(initialized)
+        indexBuffer.Bind();
+}
+
+
+
+void QuadIndexBuffer::Delete()
+{
+    if(initialized)
+        indexBuffer.Delete();
+    initialized = false;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "EBO.hpp"
+
+#include <glad/glad.h>
+
+
+
+// One index buffer every chunk mesh draws its quads through, when
+// World::indexedQuads is on and World::vertexPulling isn't. It holds the two
+// triangles of every quad a mesh can have, 0 1 2 1 0 3 for the first quad's
+// 4 vertices, then the same 4 on for each quad after it. A draw starts at
+// index 0 and uses base vertex to pick its mesh, so nothing in here ever
+// changes after Init
+class QuadIndexBuffer
+{
+public:
+    // Blank constructor, call Init once there is a GL context
+    QuadIndexBuffer(){};
+
+    // Fill the index buffer for ChunkMesher::maxQuadsPerMesh quads
+    void Init();
+    // Attach the index buffer to the VAO that is bound right now
+    void Bind();
+    // Deletes the index buffer
+    void Delete();
+
+private:
+    EBO indexBuffer;
+    GLboolean initialized = false;
+};
+
+// Shared by the chunk arena and every chunk's own buffers
+inline QuadIndexBuffer quadIndexBuffer_;
@@ -0,0 +1,309 @@
+#include "RegionStorage.hpp"
+
+#include <algorithm> // For std::fill
+#include <filesystem> // For std::filesystem::create_directories and rename
+#include <iostream>
+#include <system_error> // For std::error_code
+
+
+
+// Region files start with this, then the table
+static const char regionMagic[4] = { 'R', 'G', 'N', '1' };
+static const GLuint regionChunkCount = World::regionSize * World::regionSize * World::regionSize;
+static const GLuint tableEntryBytes = 3 * sizeof(uint32_t);
+static const GLuint regionHeaderBytes = sizeof(regionMagic) + regionChunkCount * tableEntryBytes;
+// Chunks get space in steps of this many bytes, so a chunk that grows a little
+// after an edit usually still fits where it was
+static const GLuint chunkSpaceStep = 1024;
+// Most region files we keep open at once
+static const GLuint maxOpenRegions = 32;
+
+
+
+// Little endian, like the chunk bytes themselves
+static void PutUint32(GLubyte *bytes, uint32_t value)
+{
+    for(GLuint i = 0; i < 4; i++)
+        bytes[i] = (GLubyte)(value >> (i * 8));
+}
+
+static uint32_t GetUint32(const GLubyte *bytes)
+{
+    return (uint32_t)bytes[0] | (uint32_t)bytes[1] << 8 | (uint32_t)bytes[2] << 16 | (uint32_t)bytes[3] << 24;
+}
+
+
+
+// Division rounding towards negative infinity, so chunk -1 is in region -1, not 0
+static GLint FloorDivide(GLint value, GLint divisor)
+{
+    return (value >= 0 ? value / divisor : (value - divisor + 1) / divisor);
+}
+
+
+
+RegionStorage::~RegionStorage()
+{
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex);
+        stopping = true;
+    }
+    saveQueued.notify_all();
+    if(writer.joinable())
+        writer.join();
+
+    for(auto &region : regions)
+        fclose(region.second.file);
+}
+
+
+
+void RegionStorage::Open(const std::string &saveDirectory)
+{
+    std::error_code error;
+    std::filesystem::create_directories(saveDirectory, error);
+    if(error)
+    {
+        std::cout << "Could not create save folder " << saveDirectory << ": " << error.message() << ", the world won't be saved" << std::endl;
+        return;
+    }
+
+    directory = saveDirectory;
+    opened = true;
+    writer = std::thread(&RegionStorage::WriterLoop, this);
+}
+
+
+
+void RegionStorage::Save(glm::ivec3 position, SavedChunk &&chunk)
+{
+    if(!opened)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex);
+        std::shared_ptr<const SavedChunk> &pending = pendingSaves[position];
+        // Already queued, the writer will pick up this newer copy instead
+        if(pending == nullptr)
+            saveQueue.push_back(position);
+        pending = std::make_shared<const SavedChunk>(std::move(chunk));
+    }
+    saveQueued.notify_one();
+}
+
+
+
+GLboolean RegionStorage::Load(glm::ivec3 position, SavedChunk &chunk)
+{
+    if(!opened)
+        return false;
+
+    // A save still waiting for the writer is newer than what's on disk
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex);
+        auto pending = pendingSaves.find(position);
+        if(pending != pendingSaves.end())
+        {
+            chunk = *pending->second;
+            return true;
+        }
+    }
+
+    std::vector<GLubyte> bytes;
+    {
+        std::lock_guard<std::mutex> lock(regionsMutex);
+        Region *region = GetRegion(position, false);
+        if(region == nullptr)
+            return false;
+        const TableEntry &entry = region->table[TableIndex(position)];
+        if(entry.size == 0)
+            return false;
+
+        bytes.resize(entry.size);
+        if(fseek(region->file, entry.offset, SEEK_SET) != 0 || fread(bytes.data(), 1, bytes.size(), region->file) != bytes.size())
+        {
+            std::cout << "Could not read chunk " << position.x << ", " << position.y << ", " << position.z << " from its region file" << std::endl;
+            return false;
+        }
+    }
+
+    // Decompress outside the lock, so other threads can load at the same time
+    if(!ChunkSerializer::Load(bytes.data(), bytes.size(), chunk))
+    {
+        std::cout << "Saved chunk " << position.x << ", " << position.y << ", " << position.z << " is corrupt or from an old version, regenerating it" << std::endl;
+        chunk = SavedChunk();
+        return false;
+    }
+    return true;
+}
+
+
+
+void RegionStorage::Flush()
+{
+    std::unique_lock<std::mutex> lock(pendingMutex);
+    saveWritten.wait(lock, [this] { return saveQueue.empty(); });
+}
+
+
+
+void RegionStorage::WriterLoop()
+{
+    std::unique_lock<std::mutex> lock(pendingMutex);
+    while(true)
+    {
+        saveQueued.wait(lock, [this] { return stopping || !saveQueue.empty(); });
+        // Finish whatever is queued before stopping
+        if(saveQueue.empty())
+        {
+            if(stopping)
+                return;
+            continue;
+        }
+
+        glm::ivec3 position = saveQueue.front();
+        std::shared_ptr<const SavedChunk> chunk = pendingSaves[position];
+        lock.unlock();
+
+        std::vector<GLubyte> bytes;
+        ChunkSerializer::Save(*chunk, bytes);
+        {
+            std::lock_guard<std::mutex> regionsLock(regionsMutex);
+            WriteChunk(position, bytes);
+        }
+
+        lock.lock();
+        // If the chunk was saved again while we wrote, leave it queued and write the newer copy next
+        if(pendingSaves[position] == chunk)
+        {
+            pendingSaves.erase(position);
+            saveQueue.pop_front();
+            if(saveQueue.empty())
+                saveWritten.notify_all();
+        }
+    }
+}
+
+
+
+RegionStorage::Region *RegionStorage::GetRegion(glm::ivec3 position, GLboolean create)
+{
+    glm::ivec3 regionPosition(FloorDivide(position.x, World::regionSize), FloorDivide(position.y, World::regionSize), FloorDivide(position.z, World::regionSize));
+    auto found = regions.find(regionPosition);
+    if(found != regions.end())
+        return &found->second;
+    if(!create && missingRegions.count(regionPosition) != 0)
+        return nullptr;
+
+    // Don't run out of file handles as the player travels
+    if(regions.size() >= maxOpenRegions)
+    {
+        for(auto &region : regions)
+            fclose(region.second.file);
+        regions.clear();
+    }
+
+    std::string path = directory + "/r." + std::to_string(regionPosition.x) + "." + std::to_string(regionPosition.y) + "." + std::to_string(regionPosition.z) + ".region";
+    std::vector<GLubyte> header(regionHeaderBytes, 0);
+
+    FILE *file = fopen(path.c_str(), "r+b");
+    if(file != nullptr && (fread(header.data(), 1, header.size(), file) != header.size() || std::string(header.begin(), header.begin() + 4) != std::string(regionMagic, 4)))
+    {
+        fclose(file);
+        file = nullptr;
+        if(!create)
+        {
+            std::cout << "Region file " << path << " is corrupt, ignoring it" << std::endl;
+            missingRegions.insert(regionPosition);
+            return nullptr;
+        }
+
+        // Move the bad file out of the way instead of dropping every save to this region,
+        // keeping it around in case whatever was in it can be recovered by hand
+        std::string corruptPath = path + ".corrupt";
+        std::error_code error;
+        std::filesystem::rename(path, corruptPath, error);
+        if(error)
+            std::cout << "Region file " << path << " is corrupt and could not be moved to " << corruptPath << ": " << error.message() << ", starting over" << std::endl;
+        else
+            std::cout << "Region file " << path << " is corrupt, moved it to " << corruptPath << " and started a new one" << std::endl;
+        std::fill(header.begin(), header.end(), 0);
+    }
+
+    if(file == nullptr)
+    {
+        if(!create)
+        {
+            // Remember it doesn't exist, so loads in this region don't keep trying to open it
+            missingRegions.insert(regionPosition);
+            return nullptr;
+        }
+
+        // A new region file is just the header with an empty table
+        file = fopen(path.c_str(), "w+b");
+        if(file == nullptr)
+        {
+            std::cout << "Could not create region file " << path << std::endl;
+            return nullptr;
+        }
+        std::copy(regionMagic, regionMagic + 4, header.begin());
+        fwrite(header.data(), 1, header.size(), file);
+    }
+    missingRegions.erase(regionPosition);
+
+    Region &region = regions[regionPosition];
+    region.file = file;
+    region.table.resize(regionChunkCount);
+    for(GLuint i = 0; i < regionChunkCount; i++)
+    {
+        const GLubyte *entry = header.data() + sizeof(regionMagic) + i * tableEntryBytes;
+        region.table[i].offset = GetUint32(entry);
+        region.table[i].size = GetUint32(entry + 4);
+        region.table[i].capacity = GetUint32(entry + 8);
+    }
+    return &region;
+}
+
+
+
+GLuint RegionStorage::TableIndex(glm::ivec3 position)
+{
+    GLint size = World::regionSize;
+    GLint x = position.x - FloorDivide(position.x, size) * size;
+    GLint y = position.y - FloorDivide(position.y, size) * size;
+    GLint z = position.z - FloorDivide(position.z, size) * size;
+    return x + z * size + y * size * size;
+}
+
+
+
+void RegionStorage::WriteChunk(glm::ivec3 position, const std::vector<GLubyte> &bytes)
+{
+    Region *region = GetRegion(position, true);
+    if(region == nullptr)
+        return;
+    TableEntry &entry = region->table[TableIndex(position)];
+
+    // Outgrew its space, move it to the end of the file with some room to grow
+    GLuint padding = 0;
+    if(bytes.size() > entry.capacity)
+    {
+        fseek(region->file, 0, SEEK_END);
+        entry.offset = ftell(region->file);
+        entry.capacity = (bytes.size() + chunkSpaceStep - 1) / chunkSpaceStep * chunkSpaceStep;
+        padding = entry.capacity - bytes.size();
+    }
+    entry.size = bytes.size();
+
+    GLubyte tableEntry[tableEntryBytes];
+    PutUint32(tableEntry, entry.offset);
+    PutUint32(tableEntry + 4, entry.size);
+    PutUint32(tableEntry + 8, entry.capacity);
+    // Fill out the reserved space, so the next chunk moved to the end starts after it
+    std::vector<GLubyte> zeros(padding, 0);
+
+    if(fseek(region->file, entry.offset, SEEK_SET) != 0 || fwrite(bytes.data(), 1, bytes.size(), region->file) != bytes.size() || fwrite(zeros.data(), 1, padding, region->file) != padding
+    || fseek(region->file, sizeof(regionMagic) + TableIndex(position) * tableEntryBytes, SEEK_SET) != 0 || fwrite(tableEntry, 1, tableEntryBytes, region->file) != tableEntryBytes)
+        std::cout << "Could not write chunk " << position.x << ", " << position.y << ", " << position.z << " to its region file" << std::endl;
+    fflush(region->file);
+}
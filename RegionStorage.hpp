@@ -0,0 +1,98 @@
+#pragma once
+
+#include "ChunkSerializer.hpp"
+#include "WorldConstants.hpp"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <condition_variable> // For std::condition_variable
+#include <cstdio> // For FILE
+#include <deque> // For std::deque
+#include <map> // For std::map
+#include <memory> // For std::shared_ptr
+#include <mutex> // For std::mutex
+#include <set> // For std::set
+#include <string> // For std::string
+#include <thread> // For std::thread
+#include <vector> // For std::vector
+
+
+
+// Saves chunks to region files and loads them back. Each region file holds a
+// cube of World::regionSize chunks a side: a table of where each chunk's
+// compressed bytes sit in the file, followed by the chunks themselves. A chunk
+// that grows past the space it had is moved to the end of the file.
+//
+// Saves are queued and written by our own writer thread, so the main thread never
+// waits on the disk. Loads can come from any thread, and see queued saves that
+// haven't reached the disk yet
+class RegionStorage
+{
+public:
+    RegionStorage() {};
+    // Destructor, writes everything still queued and closes the region files
+    ~RegionStorage();
+
+    // Start saving to and loading from a folder, creating it if needed
+    void Open(const std::string &directory);
+    // Queue a chunk to be written. A newer save of the same chunk replaces a queued one
+    void Save(glm::ivec3 position, SavedChunk &&chunk);
+    // Read a saved chunk. Returns false if it was never saved (or can't be read)
+    GLboolean Load(glm::ivec3 position, SavedChunk &chunk);
+    // Block until every queued save is on disk
+    void Flush();
+
+private:
+    // Where a chunk's bytes are in its region file. Size 0 means it isn't saved
+    struct TableEntry
+    {
+        uint32_t offset = 0;
+        uint32_t size = 0;
+        uint32_t capacity = 0; // Space reserved for it, so small regrowths don't move it
+    };
+    struct Region
+    {
+        FILE *file = nullptr;
+        std::vector<TableEntry> table;
+    };
+    // Orders positions, so they can key a std::map
+    struct PositionLess
+    {
+        bool operator()(const glm::ivec3 &a, const glm::ivec3 &b) const
+        {
+            return a.x != b.x ? a.x < b.x : (a.y != b.y ? a.y < b.y : a.z < b.z);
+        }
+    };
+
+    std::string directory;
+    GLboolean opened = false;
+
+    // Open region files, by region position. Guarded by regionsMutex, which is
+    // also held for any file reads and writes
+    std::map<glm::ivec3, Region, PositionLess> regions;
+    // Regions with no readable file, so loads there don't keep trying to open one.
+    // Kept apart from regions so they don't count towards the open file limit.
+    // Guarded by regionsMutex
+    std::set<glm::ivec3, PositionLess> missingRegions;
+    std::mutex regionsMutex;
+
+    // Saves the writer hasn't finished yet, and the order to write them in. The writer
+    // holds on to the one it is writing, so a newer save replacing it shows up as a different pointer
+    std::map<glm::ivec3, std::shared_ptr<const SavedChunk>, PositionLess> pendingSaves;
+    std::deque<glm::ivec3> saveQueue;
+    std::mutex pendingMutex;
+    std::condition_variable saveQueued;   // Signalled when a save is queued or we are stopping
+    std::condition_variable saveWritten;  // Signalled whenever the queue empties
+    GLboolean stopping = false;
+    std::thread writer;
+
+    // What the writer thread runs until we are destroyed
+    void WriterLoop();
+    // The open region file holding a chunk, opening (or creating) it if needed. Creating
+    // replaces a corrupt file, which is moved aside. Must hold regionsMutex
+    Region *GetRegion(glm::ivec3 position, GLboolean create);
+    // Where in its region's table a chunk's entry is
+    static GLuint TableIndex(glm::ivec3 position);
+    // Write one chunk's bytes into its region file. Must hold regionsMutex
+    void WriteChunk(glm::ivec3 position, const std::vector<GLubyte> &bytes);
+};
@@ -2,6 +2,7 @@
 
 #include <stdio.h>
 #include <string.h>
+#include <glm/gtc/type_ptr.hpp> // For glm::value_ptr()
 
 
 
@@ -62,6 +63,8 @@ Shader::Shader(const char* vertexFile, const char* fragmentFile)
 	glLinkProgram(ID);
 	// Checks if Shaders linked succesfully
 	compileErrors(ID, "PROGRAM");
+	// Look up all of our uniform locations now, instead of every frame
+	cacheUniformLocations();
 
 	// Delete the now useless Vertex and Fragment Shader objects
 	glDeleteShader(vertexShader);
@@ -159,6 +162,8 @@ void Shader::setShaderFiles(const char* vertexFile, const char* fragmentFile)
 	glLinkProgram(ID);
 	// Checks if Shaders linked succesfully
 	compileErrors(ID, "PROGRAM");
+	// Look up all of our uniform locations now, instead of every frame
+	cacheUniformLocations();
 
 	// Delete the now useless Vertex and Fragment Shader objects
 	glDeleteShader(vertexShader);
@@ -166,3 +171,90 @@ void Shader::setShaderFiles(const char* vertexFile, const char* fragmentFile)
 }
 
 
+
+// Ask the driver for every active uniform's location once, after linking
+void Shader::cacheUniformLocations()
+{
+	uniformLocations.clear();
+
+	GLint uniformCount = 0;
+	glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &uniformCount);
+	GLint maxNameLength = 0;
+	glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+
+	std::string name(maxNameLength, '\0');
+	for (GLint i = 0; i < uniformCount; i++)
+	{
+		GLsizei nameLength = 0;
+		GLint size = 0;
+		GLenum type = 0;
+		glGetActiveUniform(ID, i, maxNameLength, &nameLength, &size, &type, &name[0]);
+		std::string uniformName = name.substr(0, nameLength);
+
+		// Members of uniform blocks have no location, they are fed by buffers
+		GLint location = glGetUniformLocation(ID, uniformName.c_str());
+		if (location == -1)
+			continue;
+		uniformLocations[uniformName] = location;
+
+		// Arrays are reported as "name[0]", let them be found by "name" too
+		size_t bracket = uniformName.find('[');
+		if (bracket != std::string::npos)
+			uniformLocations[uniformName.substr(0, bracket)] = location;
+	}
+}
+
+
+
+GLint Shader::GetUniformLocation(const std::string& name) const
+{
+	auto found = uniformLocations.find(name);
+	return (found == uniformLocations.end() ? -1 : found->second);
+}
+
+
+
+void Shader::SetInt(const std::string& name, GLint value)
+{
+	glUniform1i(GetUniformLocation(name), value);
+}
+
+
+
+void Shader::SetFloat(const std::string& name, GLfloat value)
+{
+	glUniform1f(GetUniformLocation(name), value);
+}
+
+
+
+void Shader::SetVec3(const std::string& name, const glm::vec3& value)
+{
+	glUniform3fv(GetUniformLocation(name), 1, glm::value_ptr(value));
+}
+
+
+
+void Shader::SetVec4(const std::string& name, const glm::vec4& value)
+{
+	glUniform4fv(GetUniformLocation(name), 1, glm::value_ptr(value));
+}
+
+
+
+void Shader::SetMat4(const std::string& name, const glm::mat4& value)
+{
+	glUniformMatrix4fv(GetUniformLocation(name), 1, GL_FALSE, glm::value_ptr(value));
+}
+
+
+
+// Point a std140 uniform block at a uniform buffer binding point
+GLboolean Shader::BindUniformBlock(const char* blockName, GLuint bindingPoint)
+{
+	GLuint blockIndex = glGetUniformBlockIndex(ID, blockName);
+	if (blockIndex == GL_INVALID_INDEX)
+		return false;
+	glUniformBlockBinding(ID, blockIndex, bindingPoint);
+	return true;
+}
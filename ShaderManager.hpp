@@ -6,6 +6,8 @@
 #include <sstream>
 #include <iostream>
 #include <cerrno>
+#include <unordered_map> // For std::unordered_map
+#include <glm/glm.hpp>
 
 
 
@@ -28,9 +30,28 @@ public:
 	void Delete();
 	// Get ID of the shader program
 	GLuint GetID();
+
+	// Location of a uniform, from the cache filled in after linking. -1 if the
+	// program has no such uniform (or the compiler optimised it out), which
+	// the setters below and glUniform* quietly ignore
+	GLint GetUniformLocation(const std::string& name) const;
+	// Typed uniform setters. Like glUniform*, they write to the currently active
+	// program, so Activate() this shader first
+	void SetInt(const std::string& name, GLint value);
+	void SetFloat(const std::string& name, GLfloat value);
+	void SetVec3(const std::string& name, const glm::vec3& value);
+	void SetVec4(const std::string& name, const glm::vec4& value);
+	void SetMat4(const std::string& name, const glm::mat4& value);
+	// Point a std140 uniform block at a uniform buffer binding point. Returns
+	// false if this program does not declare the block
+	GLboolean BindUniformBlock(const char* blockName, GLuint bindingPoint);
 private:
 	// Checks if the different Shaders have compiled properly
 	void compileErrors(GLuint shader, const char* type);
+	// Ask the driver for every active uniform's location once, after linking
+	void cacheUniformLocations();
 	// Reference ID of the Shader Program
 	GLuint ID;
+	// Uniform name -> location, so we never call glGetUniformLocation while drawing
+	std::unordered_map<std::string, GLint> uniformLocations;
 };
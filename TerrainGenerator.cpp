@@ -0,0 +1,49 @@
+#include "TerrainGenerator.hpp"
+#include "WorldConstants.hpp"
+
+#include <mutex> // For std::mutex
+
+
+
+TerrainGenerator &TerrainGenerator::ForThisThread()
+{
+    static thread_local TerrainGenerator generator;
+    return generator;
+}
+
+
+
+TerrainGenerator::TerrainGenerator()
+{
+    // FastNoise2 hands out nodes from a shared pool, so only build one graph at a time
+    static std::mutex buildMutex;
+    std::lock_guard<std::mutex> lock(buildMutex);
+
+    // Initialize FastNoise2
+    auto OpenSimplex = FastNoise::New<FastNoise::OpenSimplex2>();
+    FractalFBm = FastNoise::New<FastNoise::FractalFBm>();
+    FractalFBm->SetSource(OpenSimplex);
+    FractalFBm->SetOctaveCount(4);
+    FractalFBm->SetLacunarity(5.0f);
+    // FractalFBm->SetWeightedStrength(0.01f);
+
+    auto DomainScale = FastNoise::New<FastNoise::DomainScale>();
+    DomainScale->SetSource(FractalFBm);
+    DomainScale->SetScale(0.196f);
+
+    auto PositionOutput = FastNoise::New<FastNoise::PositionOutput>();
+    PositionOutput->Set<FastNoise::Dim::Y>(0.05f);
+
+    add = FastNoise::New<FastNoise::Add>();
+    add->SetLHS(DomainScale);
+    add->SetRHS(PositionOutput);
+}
+
+
+
+void TerrainGenerator::GenerateHeightNoise(GLfloat *noiseOutput, GLint startX, GLint startZ, GLfloat gain, GLfloat frequency, GLuint seed)
+{
+    // The gain is the only part of the graph that changes between biomes
+    FractalFBm->SetGain(gain);
+    add->GenUniformGrid2D(noiseOutput, startX, startZ, (GLint)World::chunkWidthX, (GLint)World::chunkDepthZ, frequency, seed);
+}
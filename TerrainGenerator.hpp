@@ -0,0 +1,27 @@
+#pragma once
+
+#include <FastNoise/FastNoise.h> // Noise generator
+#include <glad/glad.h>
+
+
+
+// The FastNoise2 node graph chunks sample their terrain height from. Building
+// the graph allocates, so instead of building one per chunk every thread
+// builds its own once and reuses it. Each thread only ever touches its own
+// graph, so generating chunks on worker threads needs no locking
+class TerrainGenerator
+{
+public:
+    // The generator belonging to the calling thread, built on first use
+    static TerrainGenerator &ForThisThread();
+
+    // Fill noiseOutput (chunkWidthX * chunkDepthZ floats, x fastest) with the
+    // height noise for the chunk column starting at block startX, startZ
+    void GenerateHeightNoise(GLfloat *noiseOutput, GLint startX, GLint startZ, GLfloat gain, GLfloat frequency, GLuint seed);
+
+private:
+    FastNoise::SmartNode<FastNoise::FractalFBm> FractalFBm;
+    FastNoise::SmartNode<FastNoise::Add> add;
+
+    TerrainGenerator();
+};
@@ -1,6 +1,5 @@
 #include "TextureArray.hpp"
 
-#include <stb/stb_image.h> // Used for textures / image processing
 #include <iostream>
 
 
@@ -11,14 +10,17 @@ TextureArray::TextureArray()
     glGenTextures(1, &textureID);
     // Activate the nth texture unit slot
     glActiveTexture(GL_TEXTURE0 + textureSlotIndex);
-    // Bind our texture ID to our 2D texture array and initialize it
+    // Bind our texture ID to our 2D texture array. Its storage is made by Upload,
+    // once we know how many layers there are
     glBindTexture(GL_TEXTURE_2D_ARRAY, textureID);
-    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA, image_size.x, image_size.y, 256, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
 
     // Settings for 2D texture array
-    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);	
-    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    // Repeat so greedy meshed quads tile the texture once per block
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    // Far away blocks blend between the pack's mip levels instead of shimmering,
+    // while up close each texel stays a sharp square
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_LINEAR);
     glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 
     // Increase the texture slot index, so the next time we create a texture array it does not 
@@ -29,34 +31,29 @@ TextureArray::TextureArray()
 
 
 
-void TextureArray::AddTextureToArray(const GLchar *filePath)
+void TextureArray::Upload(const AssetPack &pack)
 {
-    // Load and generate the texture
-    GLint width, height, nrChannels;
-    unsigned char *data = stbi_load(filePath, &width, &height, &nrChannels, STBI_rgb_alpha); // Loading as rgb_alpha so transparent pixels are transparent
-    // Flip textures on load
-    stbi_set_flip_vertically_on_load(false);
-    if (data)
-    {
-        // Put data into the 2D texture array
-        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, image_index, width, height, 1, GL_RGBA, GL_UNSIGNED_BYTE, data);  
-        glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
-    }
-    else
+    glActiveTexture(GL_TEXTURE0 + textureUnitID);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, textureID);
+
+    // Only as many layers as there are textures, and every mip level comes
+    // precomputed from the pack, so there is nothing to generate here
+    for(GLuint level = 0; level < pack.GetLevelCount(); level++)
     {
-        std::cout << "Failed to load texture " << filePath << std::endl;
+        GLuint size = AssetPack::LevelSize(level);
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, level, GL_RGBA8, size, size, pack.GetLayerCount(), 0, GL_RGBA, GL_UNSIGNED_BYTE, pack.GetLevelPixels(level));
     }
-
-    image_index++;
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, pack.GetLevelCount() - 1);
 }
 
 
 
-void TextureArray::ActivateShaderArray(GLuint shaderProgramID)
+void TextureArray::ActivateShaderArray(Shader &shader)
 {
     // Have to use our program before setting a uniform
-    glUseProgram(shaderProgramID);
-    glUniform1i(glGetUniformLocation(shaderProgramID, textureArrayName), textureUnitID);
+    shader.Activate();
+    shader.SetInt(textureArrayName, textureUnitID);
 }
 
 
@@ -1,5 +1,8 @@
 #pragma once
 
+#include "ShaderManager.hpp"
+#include "AssetPack.hpp"
+
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include <glm/glm.hpp>
@@ -13,17 +16,16 @@ public:
 
     TextureArray();
 
-    void AddTextureToArray(const GLchar *filePath);
-    void ActivateShaderArray(GLuint shaderProgramID);
+    // Upload every layer and mip level of a baked asset pack, one call per level
+    void Upload(const AssetPack &pack);
+    void ActivateShaderArray(Shader &shader);
     void Bind();
     void Unbind();
     void Delete();
 
 private:
-    glm::vec2 image_size = glm::vec2(512, 512);
     GLchar textureArrayName[15] = "ourTexture";
     GLuint textureUnitID;
-    GLuint image_index = 0;
 };
 
 // Increments for each texture array instance that is created. This keeps track of
@@ -0,0 +1,50 @@
+#include "UBO.hpp"
+
+
+
+// Allocate size bytes of storage and attach them to a binding point
+void UBO::InitUBO(GLsizeiptr size, GLuint bindingPoint)
+{
+    // Generate a reference ID for the UBO
+    glGenBuffers(1, &ID);
+    glBindBuffer(GL_UNIFORM_BUFFER, ID);
+    // Rewritten every frame, so let the driver know
+    glBufferData(GL_UNIFORM_BUFFER, size, nullptr, GL_DYNAMIC_DRAW);
+    // Every uniform block bound to this binding point now reads from us
+    glBindBufferBase(GL_UNIFORM_BUFFER, bindingPoint, ID);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+
+
+// Overwrite size bytes of the buffer, starting at the beginning
+void UBO::UpdateUBO(const void* data, GLsizeiptr size)
+{
+    glBindBuffer(GL_UNIFORM_BUFFER, ID);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, size, data);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+
+
+// Bind the UBO
+void UBO::Bind()
+{
+    glBindBuffer(GL_UNIFORM_BUFFER, ID);
+}
+
+
+
+// Unbind the UBO
+void UBO::Unbind()
+{
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+
+
+// Deletes the UBO
+void UBO::Delete()
+{
+    glDeleteBuffers(1, &ID);
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <glad/glad.h>
+
+
+
+// Uniform Buffer Object, the backing store for a std140 uniform block that
+// several shader programs can share through one binding point
+class UBO
+{
+public:
+    // Reference ID of the Uniform Buffer Object
+    GLuint ID = 0;
+
+    // Blank constructor, call InitUBO once there is a GL context
+    UBO(){};
+
+    // Allocate size bytes of storage and attach them to a binding point
+    void InitUBO(GLsizeiptr size, GLuint bindingPoint);
+    // Overwrite size bytes of the buffer, starting at the beginning
+    void UpdateUBO(const void* data, GLsizeiptr size);
+    // Binds the UBO
+    void Bind();
+    // Unbinds the UBO
+    void Unbind();
+    // Deletes the UBO
+    void Delete();
+};
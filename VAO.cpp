@@ -27,6 +27,22 @@ void VAO::LinkAttrib(VBO& VBO, GLuint layout, GLuint numComponents, GLenum type,
 
 
 
+// Links an integer VAO attribute, such as
+// packed vertex data, to the VAO
+void VAO::LinkAttribI(VBO& VBO, GLuint layout, GLuint numComponents, GLenum type, GLsizeiptr stride, void* offset)
+{
+    // Bind the VBO
+    VBO.Bind();
+    // Link the VAO attribute to the VBO, keeping the values as integers
+    glVertexAttribIPointer(layout, numComponents, type, stride, offset);
+    // Enable the VAO array
+    glEnableVertexAttribArray(layout);
+    // Unbind the VBO
+    VBO.Unbind();
+}
+
+
+
 // Binds the VAO
 void VAO::Bind()
 {
@@ -16,6 +16,8 @@ public:
 
     // Links a VBO Attribute such as a position or color to the VAO
 	void LinkAttrib(VBO& VBO, GLuint layout, GLuint numComponents, GLenum type, GLsizeiptr stride, void* offset);
+    // Links an integer VBO Attribute (read as uint/int in the shader, not converted to float)
+	void LinkAttribI(VBO& VBO, GLuint layout, GLuint numComponents, GLenum type, GLsizeiptr stride, void* offset);
     // Binds the VAO
     void Bind();
     // Unbinds the VAO
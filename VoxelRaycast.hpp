@@ -0,0 +1,102 @@
+#pragma once
+
+#include "BlockRegistry.hpp"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cmath> // For std::floor
+#include <limits> // For std::numeric_limits
+
+
+
+// What a raycast found. When hit is false the other fields are meaningless
+struct RaycastHit
+{
+    GLboolean hit = false;
+    glm::ivec3 block = glm::ivec3(0);      // World position of the block the ray stopped in
+    glm::ivec3 normal = glm::ivec3(0);     // Which face of it the ray came in through, zero if the ray started inside it
+    glm::ivec3 placeCell = glm::ivec3(0);  // The cell in front of that face, where a placed block goes
+    GLint blockTypeID = BlockRegistry::Air;
+    GLfloat distance = 0.0f;               // How far along the ray the block was entered
+};
+
+
+
+// Grid traversal (Amanatides & Woo) through the world's blocks. Every cell the
+// ray passes through is visited exactly once, in order, so a pick costs one
+// lookup per cell crossed and can't slip past a corner
+namespace VoxelRaycast
+{
+    // What the block lookup returns where nothing is loaded. Same value as ChunkSnapshot::Unloaded
+    const GLint Unloaded = -2;
+
+    // Walk from origin along direction (doesn't need to be normalized) for up to
+    // maxDistance blocks. getBlock(glm::ivec3 worldPosition) returns the block
+    // type there, or Unloaded where nothing is loaded, which ends the ray as a
+    // miss. The ray stops at the first block that isn't air
+    template <typename GetBlock>
+    RaycastHit Cast(glm::vec3 origin, glm::vec3 direction, GLfloat maxDistance, GetBlock getBlock)
+    {
+        RaycastHit result;
+        GLfloat length = glm::length(direction);
+        if(length == 0.0f)
+            return result;
+        direction /= length;
+
+        const GLfloat infinity = std::numeric_limits<GLfloat>::infinity();
+        glm::ivec3 cell(std::floor(origin.x), std::floor(origin.y), std::floor(origin.z));
+        glm::ivec3 step;
+        // Distance along the ray to the next cell boundary on each axis, and
+        // between boundaries on each axis
+        glm::vec3 tMax, tDelta;
+        for(GLint axis = 0; axis < 3; axis++)
+        {
+            if(direction[axis] > 0.0f)
+            {
+                step[axis] = 1;
+                tDelta[axis] = 1.0f / direction[axis];
+                tMax[axis] = (cell[axis] + 1 - origin[axis]) * tDelta[axis];
+            }
+            else if(direction[axis] < 0.0f)
+            {
+                step[axis] = -1;
+                tDelta[axis] = -1.0f / direction[axis];
+                tMax[axis] = (origin[axis] - cell[axis]) * tDelta[axis];
+            }
+            else
+            {
+                step[axis] = 0;
+                tDelta[axis] = infinity;
+                tMax[axis] = infinity;
+            }
+        }
+
+        glm::ivec3 normal(0);
+        GLfloat distance = 0.0f;
+        while(distance <= maxDistance)
+        {
+            GLint blockTypeID = getBlock(cell);
+            if(blockTypeID == Unloaded)
+                return result;
+            if(blockTypeID != BlockRegistry::Air)
+            {
+                result.hit = true;
+                result.block = cell;
+                result.normal = normal;
+                result.placeCell = cell + normal;
+                result.blockTypeID = blockTypeID;
+                result.distance = distance;
+                return result;
+            }
+
+            // Cross whichever cell boundary comes first
+            GLint axis = (tMax.x < tMax.y ? (tMax.x < tMax.z ? 0 : 2) : (tMax.y < tMax.z ? 1 : 2));
+            distance = tMax[axis];
+            tMax[axis] += tDelta[axis];
+            cell[axis] += step[axis];
+            normal = glm::ivec3(0);
+            normal[axis] = -step[axis];
+        }
+        return result;
+    }
+}
@@ -19,21 +19,32 @@ namespace World
     const GLuint chunkHeightY  = chunkSize;  // How many blocks tall a chunk is
     const GLuint chunkDepthZ   = chunkSize;  // How many blocks deep a chunk is
     const GLuint chunkVolume   = chunkWidthX * chunkHeightY * chunkDepthZ; // How many blocks a chunk is
-    const GLuint chunkDiameter = 12;  // The amount of chunks generated across. Basically the render distance
-                                     // If 0 then 1 chunks generate, If 1 then 9 chunks generate (3x3), if 2 then 25 chunks generate (5x5), etc
+    const GLuint blockSectionSize = 16; // Chunks store their blocks in palette compressed cubes this many blocks wide
+                                        // Has to divide evenly into the chunk dimensions
+    const GLuint chunkDiameter = 12;  // How many chunks out from the camera we load, in a circle. Basically the render distance
+                                     // If 0 then only the camera's chunk loads, if 1 then it and the 4 around it load, etc
+    const GLuint chunkUnloadDistance = chunkDiameter + 2; // Chunks further than this many chunks from the camera are unloaded.
+                                                          // The gap to chunkDiameter stops chunks reloading as the camera moves back and forth
+    const GLuint chunkLoadsPerFrame = 64; // Max chunks we create and queue for generation per frame
     const GLfloat BlockRenderDistance = 40 * chunkSize * blockSize; // Will render chunks within n blocks
 
     /* World Settings */
-    const GLuint chunksTall     = 1;     // How many chunks tall we generate the world / world height limit
-    const GLuint heightLimit    = 64;    // Max height limit of the world
+    const GLuint chunksTall     = 8;     // How many chunks tall we generate the world / world height limit
+    const GLuint heightLimit    = chunksTall * chunkHeightY; // Max height limit of the world
+    const GLuint terrainHeight  = 64;    // How high the generated terrain reaches. Chunks above it start out as air and
+                                         // cost next to nothing, but are there to build in
     const GLboolean randomSeed  = false; // If true then the seed will always be 100, otherwise random
     const GLuint defaultSeed = 926797;    // The default seed if randomSeed is false
     const GLboolean randomBiomeGenerationPerChunk = false; // If true then biomes generate randomly per chunk, otherwise generates with noise
     const GLuint waterLevel = 0;         // The height of the water level
 
     /* Logging */
-    const GLboolean frustumCullingLogging = false; // If true then we log the amount of passed and failed chunks in the frustum culling test in ChunkManager.cpp
     const GLboolean seedLogging = false;           // If true then we print out the seed on world load
+    const GLboolean chunkGenerationLogging = false; // If true then we print how many chunks load each frame and how many are in memory
+
+    /* Profiling */
+    const GLboolean profilerEnabled = true; // If true then frames are timed per section (CPU and GPU). F3 shows the frame time graph,
+                                            // F2 writes the last frames to a CSV file. If false the timing compiles away
 
     /* GUI Settings */
     const GLfloat crosshairThickness = 0.003f; // Thickness of the crosshair lines
@@ -45,9 +56,40 @@ namespace World
     /* Lighting Setting */
     const GLboolean ambientOcclusionEnabled = true; // Whether ambient occlusion for block faces is enabled
 
+    /* Meshing Settings */
+    const GLboolean greedyMeshingEnabled = true; // If true then chunks merge matching coplanar faces into bigger quads,
+                                                 // otherwise every visible block face gets its own quad
+    const GLuint meshUploadBudget = 4 * 1024 * 1024; // Max bytes of chunk meshes we upload to the GPU per frame (at least one mesh always goes)
+    const GLuint meshJobsPerFrame = 64;              // Max chunks we snapshot and queue for meshing per frame
+    const GLuint meshSlabHeight = 8;                 // Chunk meshes are built and uploaded in horizontal slabs this many blocks tall,
+                                                     // so a block edit only remeshes the slabs it touches
+    const GLuint meshSlabCount = chunkHeightY / meshSlabHeight;
+    const GLuint allMeshSlabs = (1u << meshSlabCount) - 1; // Slab mask with every slab of a chunk set
+
+    /* Level of Detail Settings */
+    const GLboolean levelOfDetail = true; // If true then distant chunks are meshed from merged 2, 4 or 8 block cells
+    const GLuint maxLODLevel = 3;         // Coarsest level, cells are 2^level blocks wide. 2^maxLODLevel has to divide meshSlabHeight
+    const GLfloat lodPixelError = 4.0f;   // A chunk uses the coarsest level whose cells are off by at most this many pixels on screen
+
+    /* Rendering Settings */
+    const GLboolean multiDrawRendering = true;     // If true then all chunk meshes share one vertex buffer and the visible chunks draw
+                                                   // with one multi-draw call per pass, otherwise every chunk binds and draws its own buffers
+    const GLboolean indexedQuads = true;           // If true then every quad is 4 vertices drawn through one shared index buffer,
+                                                   // otherwise 6 vertices drawn as plain triangles
+    const GLboolean vertexPulling = false;         // If true then every quad is one 8 byte record the cube shader reads from a buffer
+                                                   // texture and expands into its 6 vertices itself. Overrides indexedQuads
+    const GLuint chunkArenaPageVertices = 512;     // The shared vertex buffer hands out space in pages of this many vertices (a multiple of 4)
+    const GLuint chunkArenaInitialPages = 8192;    // Pages the shared vertex buffer starts with (32MB), it doubles whenever it runs out
+
+    /* Save Settings */
+    const GLboolean worldSaving = true;     // If true then chunks the player edits are saved to region files and loaded back
+                                            // from them instead of being regenerated
+    const char *const saveDirectory = "saves"; // Region files go in a folder per seed inside this folder
+    const GLuint regionSize = 16;           // Region files hold a cube of this many chunks a side
+
     /* Player Settings */
     const GLfloat blockBreakingSpeed = 0.1f; // How fast the player breaks blocks per second
-    const GLuint playerReachScaleAmount = 500; // How many steps we take to place a block
+    const GLfloat playerReach = 50.0f; // How many blocks away the player can break and place blocks
     const GLfloat blockPlacingSpeed = 0.1f; // How fast the player places blocks per second
 }
 
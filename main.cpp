@@ -4,6 +4,10 @@
 #include "GUI.hpp"
 #include "Sky.hpp"
 #include "Player.hpp"
+#include "Profiler.hpp"
+
+#include <cstdio> // For std::snprintf
+#include <ctime> // For std::time
 
 // Math headers
 #include <glm/glm.hpp>
@@ -30,34 +34,77 @@ int main()
     // glEnable(GL_BLEND);
     // glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
+    Profiler &profiler = Profiler::Instance();
+    // When the window title was last rebuilt, and whether F2/F3 were down last frame
+    GLdouble titleUpdateTime = 0.0;
+    GLboolean csvKeyWasDown = false, overlayKeyWasDown = false;
+
     // Render Loop
     while (!glfwWindowShouldClose(window.GetWindow()))
     {
-        // Handles camera inputs
-		camera.Inputs(window.GetWindow());
-		// Updates the camera matrix to the Vertex Shader
-        camera.Matrix(bufferManager.cubeShaderProgram, "projectionMatrix", "viewMatrix");
-        camera.Matrix(bufferManager.lightShaderProgram, "projectionMatrix", "viewMatrix");
+        profiler.BeginFrame();
+        {
+            ProfileScope input(Profile_Input);
+            // Handles camera inputs
+            camera.Inputs(window.GetWindow());
+
+            // F3 toggles the frame time graph, F2 dumps the recorded frames to a CSV file
+            GLboolean overlayKeyDown = glfwGetKey(window.GetWindow(), GLFW_KEY_F3) == GLFW_PRESS;
+            if(overlayKeyDown && !overlayKeyWasDown)
+                profiler.overlayVisible = !profiler.overlayVisible;
+            overlayKeyWasDown = overlayKeyDown;
+            GLboolean csvKeyDown = glfwGetKey(window.GetWindow(), GLFW_KEY_F2) == GLFW_PRESS;
+            if(csvKeyDown && !csvKeyWasDown)
+                profiler.WriteCSV("profile_" + std::to_string(std::time(nullptr)) + ".csv");
+            csvKeyWasDown = csvKeyDown;
+        }
+		// Updates the orthographic matrix for the GUI. The cube and light shaders get
+		// the camera matrices from the FrameData uniform buffer in RunLoop
         camera.OrthographicMatrix(guiManager.guiShaderProgram, "orthographicMatrix");
         // Update the FOV in the matrix. FOV degree, near and far clip planes
 		camera.updateMatrix(45.0f, 0.1f, World::BlockRenderDistance); 
         // Set sky colors
         skyManager.SetSkyColor();
         // Run all of our buffer business, including chunk/mesh rendering
-		bufferManager.RunLoop(window.GetWindow(), camera.Position, camera.Orientation);
-        // Process user input
-        player.ProcessInput(camera.Position, camera.Orientation);
-        // Run Gui Business
-        guiManager.RenderCrosshair();
+		bufferManager.RunLoop(window.GetWindow(), camera);
+        {
+            ProfileScope input(Profile_Input);
+            // Process user input
+            player.ProcessInput(camera.Position, camera.Orientation);
+        }
+        {
+            ProfileScope gui(Profile_GUI);
+            // Run Gui Business
+            guiManager.RenderCrosshair();
+            if(profiler.overlayVisible)
+                guiManager.RenderProfiler(profiler);
+        }
         // Error logging
         window.CheckErrors();
-        // Set FPS and camera coordinates to GLFW window title
-        window.SetWindowTitle("FPS: " + std::to_string(window.GetFPS()) + "             Camera Position: " + camera.GetPosition() + "             Camera Orientation: " + camera.GetOrientation());
 
-        // Swap the back buffer with the front buffer
-        glfwSwapBuffers(window.GetWindow());
-        // Poll for events so window responds to clicks and such
-        glfwPollEvents();
+        // Set FPS and camera coordinates to GLFW window title. The FPS only changes
+        // four times a second, so there's no point formatting the title more often
+        GLdouble fps = window.GetFPS();
+        if(glfwGetTime() - titleUpdateTime > 0.25)
+        {
+            titleUpdateTime = glfwGetTime();
+            ChunkManager::CullingStats cullingStats = bufferManager.chunkManager.GetCullingStats();
+            char title[256];
+            std::snprintf(title, sizeof(title), "FPS: %.1f             Camera Position: %dx %dy %dz             Camera Orientation: %.2fx %.2fy %.2fz             Chunks Drawn: %u/%u",
+                fps, (GLint)camera.Position.x, (GLint)camera.Position.y, (GLint)camera.Position.z,
+                camera.Orientation.x, camera.Orientation.y, camera.Orientation.z,
+                (GLuint)cullingStats.chunksPassed, (GLuint)cullingStats.chunksTested);
+            window.SetWindowTitle(title);
+        }
+
+        {
+            ProfileScope swap(Profile_Swap);
+            // Swap the back buffer with the front buffer
+            glfwSwapBuffers(window.GetWindow());
+            // Poll for events so window responds to clicks and such
+            glfwPollEvents();
+        }
+        profiler.EndFrame();
     }
 
     return 0;
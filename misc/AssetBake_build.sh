@@ -0,0 +1,4 @@
+#!/bin/sh
+
+# No window or GL libraries needed
+clang++ -std=c++17 -O2 -Wall -I.. -I../dependencies/include -o AssetBake AssetBake.cpp ../AssetPack.cpp ../BlockRegistry.cpp
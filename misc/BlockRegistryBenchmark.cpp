@@ -0,0 +1,134 @@
+//
+// Compares the old per-neighbour json lookups in the meshing loop against
+// the flat BlockRegistry table. Runs without a window or GL context.
+//
+
+#include "BlockRegistry.hpp"
+#include "BlockStorage.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+
+
+// The json table ActivateTextures used to build, keyed by name and by stringified ID
+json BuildLegacyTable(const json &definitions)
+{
+    json table;
+    table["Air"]["index"] = -1;
+    table["-1"]["transparent"] = true;
+    table["-1"]["isFoliage"] = false;
+    for (auto &el : definitions.items())
+    {
+        GLint index = el.value()["id"];
+        table[el.key()]["index"] = index;
+        table[to_string(index)]["transparent"] = (bool)el.value()["transparent"];
+        table[to_string(index)]["isFoliage"] = (bool)el.value()["isFoliage"];
+    }
+    return table;
+}
+
+
+
+// Rolling hills of grass, dirt and stone with some water, like a generated chunk
+void FillTerrain(BlockStorage &storage, const BlockRegistry &registry)
+{
+    GLint grass = registry.GetID("Grass_Top");
+    GLint dirt = registry.GetID("Dirt_Top");
+    GLint stone = registry.GetID("Stone_Block");
+    GLint water = registry.GetID("Water");
+    for (GLint z = 0; z < (GLint)World::chunkDepthZ; z++)
+    for (GLint x = 0; x < (GLint)World::chunkWidthX; x++)
+    {
+        GLint height = 12 + (GLint)(6.0 * sin(x * 0.3) + 5.0 * cos(z * 0.25));
+        for (GLint y = 0; y < (GLint)World::chunkHeightY; y++)
+        {
+            if (y < height - 4)
+                storage.SetBlockType(x, y, z, stone);
+            else if (y < height - 1)
+                storage.SetBlockType(x, y, z, dirt);
+            else if (y < height)
+                storage.SetBlockType(x, y, z, grass);
+            else if (y == 0)
+                storage.SetBlockType(x, y, z, water);
+        }
+    }
+}
+
+
+
+// The neighbour tests Chunk::RenderMesh does for every block, with a pluggable lookup
+template <typename IsTransparentFn, typename IsFoliageFn>
+GLuint CountVisibleFaces(const BlockStorage &storage, IsTransparentFn isTransparent, IsFoliageFn isFoliage)
+{
+    const GLint sizeX = World::chunkWidthX, sizeY = World::chunkHeightY, sizeZ = World::chunkDepthZ;
+    GLuint faces = 0;
+    for (GLint z = 0; z < sizeZ; z++)
+    for (GLint x = 0; x < sizeX; x++)
+    for (GLint y = 0; y < sizeY; y++)
+    {
+        GLint id = storage.GetBlockType(x, y, z);
+        if (id == BlockRegistry::Air)
+            continue;
+        if (y < sizeY - 1 && isTransparent(storage.GetBlockType(x, y + 1, z))) faces++;
+        if (y > 0 && isTransparent(storage.GetBlockType(x, y - 1, z))) faces++;
+        if (!isTransparent(id) || isFoliage(id))
+        {
+            if (x > 0 && isTransparent(storage.GetBlockType(x - 1, y, z))) faces++;
+            if (x < sizeX - 1 && isTransparent(storage.GetBlockType(x + 1, y, z))) faces++;
+            if (z > 0 && isTransparent(storage.GetBlockType(x, y, z - 1))) faces++;
+            if (z < sizeZ - 1 && isTransparent(storage.GetBlockType(x, y, z + 1))) faces++;
+        }
+    }
+    return faces;
+}
+
+
+
+int main(int argc, char *argv[])
+{
+    const GLint iterations = (argc > 1 ? stoi(argv[1]) : 20);
+
+    ifstream ifs("../resources/blocks.json");
+    if (!ifs.is_open())
+    {
+        cout << "Run this from the misc folder so ../resources/blocks.json can be found" << endl;
+        return 1;
+    }
+    json definitions = json::parse(ifs);
+
+    BlockRegistry registry;
+    registry.LoadDefinitions(definitions);
+    json legacy = BuildLegacyTable(definitions);
+
+    BlockStorage storage;
+    FillTerrain(storage, registry);
+
+    auto jsonTransparent = [&](GLint id) -> GLboolean { return legacy[to_string(id)]["transparent"]; };
+    auto jsonFoliage = [&](GLint id) -> GLboolean { return legacy[to_string(id)]["isFoliage"]; };
+    auto tableTransparent = [&](GLint id) { return registry.IsTransparent(id); };
+    auto tableFoliage = [&](GLint id) { return registry.IsFoliage(id); };
+
+    GLuint jsonFaces = 0, tableFaces = 0;
+    auto start = chrono::steady_clock::now();
+    for (GLint i = 0; i < iterations; i++)
+        jsonFaces = CountVisibleFaces(storage, jsonTransparent, jsonFoliage);
+    auto middle = chrono::steady_clock::now();
+    for (GLint i = 0; i < iterations; i++)
+        tableFaces = CountVisibleFaces(storage, tableTransparent, tableFoliage);
+    auto end = chrono::steady_clock::now();
+
+    GLdouble jsonMs = chrono::duration<GLdouble, milli>(middle - start).count() / iterations;
+    GLdouble tableMs = chrono::duration<GLdouble, milli>(end - middle).count() / iterations;
+
+    cout << "Visible faces per chunk: " << tableFaces << (jsonFaces == tableFaces ? "" : " (MISMATCH with json lookups!)") << endl;
+    cout << "json lookups:     " << jsonMs << " ms per chunk" << endl;
+    cout << "BlockRegistry:    " << tableMs << " ms per chunk" << endl;
+    cout << "Speedup:          " << jsonMs / tableMs << "x" << endl;
+    return jsonFaces == tableFaces ? 0 : 1;
+}
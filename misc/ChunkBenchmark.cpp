@@ -0,0 +1,449 @@
+//
+// Generates and meshes chunks for a fixed set of seeds, with and without ambient occlusion,
+// saves them to region files and loads them back, and prints per stage timings, vertices,
+// allocations and bytes per chunk as JSON. Uses the real Chunk, TerrainGenerator,
+// ChunkMesher and RegionStorage code, without a window or GL context.
+//
+
+#include "BlockRegistry.hpp"
+#include "Chunk.hpp"
+#include "ChunkMesher.hpp"
+#include "LightEngine.hpp"
+#include "RegionStorage.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+
+
+// Every heap allocation in the process goes through here, so each stage can
+// report how many allocations (and bytes) it made
+static atomic<size_t> allocationCount(0);
+static atomic<size_t> allocatedBytes(0);
+
+void *operator new(size_t size)
+{
+    allocationCount++;
+    allocatedBytes += size;
+    if (void *memory = malloc(size == 0 ? 1 : size))
+        return memory;
+    throw bad_alloc();
+}
+
+// GCC doesn't know our operator new is malloc underneath, so once these get
+// inlined it warns that free() is given memory from new
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void operator delete(void *memory) noexcept
+{
+    free(memory);
+}
+
+void operator delete(void *memory, size_t) noexcept
+{
+    free(memory);
+}
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+
+
+// Times a stage and counts its allocations, then reports them per chunk
+struct StageMeasurement
+{
+    chrono::steady_clock::time_point start;
+    size_t startAllocations;
+    size_t startBytes;
+
+    StageMeasurement() : start(chrono::steady_clock::now()), startAllocations(allocationCount), startBytes(allocatedBytes) {}
+
+    json Finish(size_t chunkCount) const
+    {
+        GLdouble ms = chrono::duration<GLdouble, milli>(chrono::steady_clock::now() - start).count();
+        json stage;
+        stage["msPerChunk"] = ms / chunkCount;
+        stage["allocationsPerChunk"] = (GLdouble)(allocationCount - startAllocations) / chunkCount;
+        stage["bytesAllocatedPerChunk"] = (GLdouble)(allocatedBytes - startBytes) / chunkCount;
+        return stage;
+    }
+};
+
+
+
+// Mesh every snapshot, adding the vertex counts and mesh sizes to the stage's results.
+// A lodLevel above 0 builds the level of detail meshes distant chunks use instead
+json MeshStage(const vector<ChunkSnapshot> &snapshots, GLboolean ambientOcclusion, GLuint lodLevel = 0)
+{
+    auto build = [&](const ChunkSnapshot &snapshot, ChunkMesh &mesh) {
+        if (lodLevel > 0)
+            ChunkMesher::BuildLODMesh(snapshot, lodLevel, mesh);
+        else
+            ChunkMesher::BuildMesh(snapshot, World::greedyMeshingEnabled, ambientOcclusion, World::allMeshSlabs, mesh);
+    };
+
+    // The game reuses meshes once they are uploaded, so the stage builds into one
+    // mesh over and over. Mesh everything once outside the measurement first, so
+    // growing that mesh and the mesher's per-thread scratch buffers isn't charged
+    // to the stage. What's left should be no allocations at all
+    ChunkMesh mesh;
+    for (const ChunkSnapshot &snapshot : snapshots)
+    {
+        mesh.Clear();
+        build(snapshot, mesh);
+    }
+
+    size_t vertices = 0, meshBytes = 0;
+    StageMeasurement measurement;
+    for (const ChunkSnapshot &snapshot : snapshots)
+    {
+        mesh.Clear();
+        build(snapshot, mesh);
+        vertices += (mesh.opaqueVertices.size() + mesh.transparentVertices.size()) / ChunkMesher::vertexStride;
+        meshBytes += (mesh.opaqueVertices.size() + mesh.transparentVertices.size()) * sizeof(GLuint);
+    }
+    json stage = measurement.Finish(snapshots.size());
+    stage["verticesPerChunk"] = (GLdouble)vertices / snapshots.size();
+    stage["meshBytesPerChunk"] = (GLdouble)meshBytes / snapshots.size();
+    // What the same quads take up on the GPU in each way of drawing them, whichever one
+    // WorldConstants.hpp picks: 6 vertices, 4 indexed vertices or one pulled record of 8 bytes
+    GLdouble quadsPerChunk = (GLdouble)vertices / ChunkMesher::verticesPerQuad / snapshots.size();
+    const GLdouble bytesPerVertex = ChunkMesher::vertexStride * sizeof(GLuint);
+    stage["quadsPerChunk"] = quadsPerChunk;
+    stage["gpuBytesPerChunk"]["triangles"] = quadsPerChunk * 6 * bytesPerVertex;
+    stage["gpuBytesPerChunk"]["indexedQuads"] = quadsPerChunk * 4 * bytesPerVertex;
+    stage["gpuBytesPerChunk"]["vertexPulling"] = quadsPerChunk * bytesPerVertex;
+    return stage;
+}
+
+
+
+// Every column of chunks above columnBottoms, lowest first
+static vector<Chunk *> ColumnChunks(const vector<Chunk *> &columnBottoms)
+{
+    vector<Chunk *> column;
+    for (Chunk *bottom : columnBottoms)
+        for (GLint y = 0; y < (GLint)World::chunksTall; y++)
+            column.push_back(chunks_.Get(glm::ivec3(bottom->chunk_position_x, y, bottom->chunk_position_z)));
+    return column;
+}
+
+
+
+// How many blocks of the lit columns have different light than a fresh lighting of them
+static size_t RelightAndCompare(const vector<Chunk *> &columnBottoms)
+{
+    vector<Chunk *> columnChunks = ColumnChunks(columnBottoms);
+    vector<LightStorage> incremental;
+    for (Chunk *chunk : columnChunks)
+    {
+        incremental.push_back(chunk->light);
+        chunk->lit = false;
+    }
+    for (Chunk *bottom : columnBottoms)
+        lightEngine_.LightColumn(bottom);
+
+    size_t wrong = 0;
+    for (size_t i = 0; i < columnChunks.size(); i++)
+        for (GLuint index = 0; index < World::chunkVolume; index++)
+            wrong += (incremental[i].Get(index) != columnChunks[i]->light.Get(index));
+    return wrong;
+}
+
+
+
+// Light whole columns the way they are as they finish generating, then time the
+// edits a player makes: dig out the surface block in the middle of each column, put
+// a glowing block in the hole, take it out again and put the ground back. Each edit
+// has to leave the same light as lighting its columns from scratch would
+json LightStage(const vector<Chunk *> &columnBottoms)
+{
+    StageMeasurement lightColumns;
+    for (Chunk *bottom : columnBottoms)
+        lightEngine_.LightColumn(bottom);
+    json stage;
+    stage["lightColumn"] = lightColumns.Finish(columnBottoms.size());
+
+    // The glowing block from blocks.json
+    const GLint lampBlockTypeID = blockRegistry.GetID("Glowstone");
+
+    const GLint x = World::chunkWidthX / 2, z = World::chunkDepthZ / 2;
+    auto SetBlock = [](Chunk *chunk, GLint x, GLint y, GLint z, GLint blockTypeID) {
+        GLint previousBlockTypeID = chunk->chunkBlocks.GetBlockType(x, y, z);
+        chunk->chunkBlocks.SetBlockType(x, y, z, blockTypeID);
+        lightEngine_.BlockChanged(chunk, x, y, z, previousBlockTypeID);
+    };
+    // Each column's highest opaque block in the middle, and what it was
+    struct Edit { Chunk *chunk; GLint y; GLint blockTypeID; };
+    vector<Edit> edits;
+    for (Chunk *bottom : columnBottoms)
+        for (GLint worldY = World::heightLimit - 1; worldY >= 0; worldY--)
+        {
+            Chunk *chunk = chunks_.Get(glm::ivec3(bottom->chunk_position_x, worldY / World::chunkHeightY, bottom->chunk_position_z));
+            GLint y = worldY % World::chunkHeightY;
+            GLint blockTypeID = chunk->chunkBlocks.GetBlockType(x, y, z);
+            if (blockRegistry.IsOpaque(blockTypeID))
+            {
+                edits.push_back(Edit{ chunk, y, blockTypeID });
+                break;
+            }
+        }
+    auto RunEdits = [&]() {
+        for (const Edit &edit : edits)
+        {
+            SetBlock(edit.chunk, x, edit.y, z, BlockRegistry::Air);
+            SetBlock(edit.chunk, x, edit.y, z, lampBlockTypeID);
+            SetBlock(edit.chunk, x, edit.y, z, BlockRegistry::Air);
+            SetBlock(edit.chunk, x, edit.y, z, edit.blockTypeID);
+        }
+    };
+
+    // Once to grow the queues, like a game that has been running a while
+    RunEdits();
+    StageMeasurement relight;
+    RunEdits();
+    stage["relightAfterEdit"] = relight.Finish(edits.size() * 4);
+
+    // Step through the edits again, checking the light after each
+    size_t wrong = 0;
+    for (const Edit &edit : edits)
+    {
+        for (GLint blockTypeID : { (GLint)BlockRegistry::Air, lampBlockTypeID, (GLint)BlockRegistry::Air, edit.blockTypeID })
+        {
+            SetBlock(edit.chunk, x, edit.y, z, blockTypeID);
+            wrong += RelightAndCompare(columnBottoms);
+        }
+    }
+    stage["blocksLitWrong"] = wrong;
+    return stage;
+}
+
+
+
+// Generate a square of chunks with a ring of neighbours around it, then mesh the
+// first chunkCount chunks inside the ring
+json BenchmarkSeed(GLuint seed, GLint chunkCount)
+{
+    const GLint side = (GLint)ceil(sqrt((GLdouble)chunkCount));
+    const GLuint biomeCount = sizeof(BiomeConfiguration) / sizeof(Biome_Configuration);
+
+    vector<Chunk *> allChunks;
+    vector<Chunk *> measuredChunks;
+    for (GLint z = -1; z <= side; z++)
+    for (GLint x = -1; x <= side; x++)
+    {
+        // A fixed biome pattern, so every run generates the same terrain
+        Chunk *chunk = new Chunk(x, 0, z, (GLuint)(x * 7 + z * 3 + 1000) % biomeCount);
+        chunks_.Add(chunk);
+        allChunks.push_back(chunk);
+        if (x >= 0 && z >= 0 && x < side && z < side && (GLint)measuredChunks.size() < chunkCount)
+            measuredChunks.push_back(chunk);
+    }
+
+    json result;
+    result["seed"] = seed;
+
+    StageMeasurement generate;
+    for (Chunk *chunk : allChunks)
+    {
+        chunk->GenerateBlocks(seed, chunk->biomeID, chunk->biomeID, chunk->biomeID, chunk->biomeID);
+        chunk->generated = true;
+    }
+    result["stages"]["generate"] = generate.Finish(allChunks.size());
+
+    size_t blockBytes = 0;
+    for (Chunk *chunk : measuredChunks)
+        blockBytes += chunk->chunkBlocks.MemoryUsage();
+    result["blockStorageBytesPerChunk"] = (GLdouble)blockBytes / measuredChunks.size();
+
+    StageMeasurement snapshot;
+    vector<ChunkSnapshot> snapshots;
+    snapshots.reserve(measuredChunks.size());
+    for (Chunk *chunk : measuredChunks)
+        snapshots.push_back(chunk->TakeSnapshot());
+    result["stages"]["snapshot"] = snapshot.Finish(measuredChunks.size());
+
+    result["stages"]["meshWithAO"] = MeshStage(snapshots, true);
+    result["stages"]["meshWithoutAO"] = MeshStage(snapshots, false);
+    for (GLuint lodLevel = 1; lodLevel <= World::maxLODLevel; lodLevel++)
+        result["stages"]["meshLOD" + to_string(lodLevel)] = MeshStage(snapshots, false, lodLevel);
+
+    // What a block edit in the middle of a chunk costs: snapshot and remesh only the
+    // slabs around it. Each rebuilt slab has to match the same slab of a full mesh
+    {
+        const GLint editY = World::meshSlabHeight + World::meshSlabHeight / 2;
+        const GLuint slabMask = ChunkMesher::SlabsBetween(editY - 1, editY + 1);
+        size_t slabsWrong = 0;
+        // Reused like the game's mesh jobs, and warmed up the same way as MeshStage
+        ChunkSnapshot editSnapshot;
+        ChunkMesh mesh;
+        for (Chunk *chunk : measuredChunks)
+        {
+            chunk->TakeSnapshot(editSnapshot, slabMask);
+            mesh.Clear();
+            ChunkMesher::BuildMesh(editSnapshot, World::greedyMeshingEnabled, true, slabMask, mesh);
+        }
+        StageMeasurement remesh;
+        for (Chunk *chunk : measuredChunks)
+        {
+            chunk->TakeSnapshot(editSnapshot, slabMask);
+            mesh.Clear();
+            ChunkMesher::BuildMesh(editSnapshot, World::greedyMeshingEnabled, true, slabMask, mesh);
+        }
+        result["stages"]["remeshAfterEdit"] = remesh.Finish(measuredChunks.size());
+        result["stages"]["remeshAfterEdit"]["speedupOverFullRemesh"] =
+            (result["stages"]["snapshot"]["msPerChunk"].get<GLdouble>() + result["stages"]["meshWithAO"]["msPerChunk"].get<GLdouble>()) / result["stages"]["remeshAfterEdit"]["msPerChunk"].get<GLdouble>();
+
+        for (size_t i = 0; i < measuredChunks.size(); i++)
+        {
+            ChunkMesh full, partial;
+            ChunkMesher::BuildMesh(snapshots[i], World::greedyMeshingEnabled, true, World::allMeshSlabs, full);
+            ChunkMesher::BuildMesh(measuredChunks[i]->TakeSnapshot(slabMask), World::greedyMeshingEnabled, true, slabMask, partial);
+            for (GLuint slab = 0; slab < World::meshSlabCount; slab++)
+            {
+                if (!(slabMask & (1u << slab)))
+                    continue;
+                GLuint fullStart = (slab > 0 ? full.opaqueSlabEnds[slab - 1] : 0);
+                GLuint partialStart = (slab > 0 ? partial.opaqueSlabEnds[slab - 1] : 0);
+                if (!equal(full.opaqueVertices.begin() + fullStart, full.opaqueVertices.begin() + full.opaqueSlabEnds[slab],
+                           partial.opaqueVertices.begin() + partialStart, partial.opaqueVertices.begin() + partial.opaqueSlabEnds[slab]))
+                    slabsWrong++;
+            }
+        }
+        result["slabRebuildsWrong"] = slabsWrong;
+    }
+
+    // Save every measured chunk as if the player had edited it, then load them
+    // back with a fresh storage so nothing comes from the save queue
+    string saveDirectory = (filesystem::temp_directory_path() / "ChunkBenchmarkSaves").string();
+    filesystem::remove_all(saveDirectory);
+    {
+        RegionStorage storage;
+        storage.Open(saveDirectory);
+        StageMeasurement save;
+        for (Chunk *chunk : measuredChunks)
+            storage.Save(chunk->GetPosition(), chunk->Save());
+        storage.Flush();
+        result["stages"]["saveToRegion"] = save.Finish(measuredChunks.size());
+    }
+    size_t savedBytes = 0;
+    for (const filesystem::directory_entry &file : filesystem::directory_iterator(saveDirectory))
+        savedBytes += file.file_size();
+    result["regionFileBytesPerChunk"] = (GLdouble)savedBytes / measuredChunks.size();
+    {
+        RegionStorage storage;
+        storage.Open(saveDirectory);
+        vector<SavedChunk> loaded(measuredChunks.size());
+        size_t mismatches = 0;
+        StageMeasurement load;
+        for (size_t i = 0; i < measuredChunks.size(); i++)
+            if (!storage.Load(measuredChunks[i]->GetPosition(), loaded[i]))
+                mismatches++;
+        result["stages"]["loadFromRegion"] = load.Finish(measuredChunks.size());
+        result["stages"]["loadFromRegion"]["speedupOverGenerate"] = result["stages"]["generate"]["msPerChunk"].get<GLdouble>() / result["stages"]["loadFromRegion"]["msPerChunk"].get<GLdouble>();
+
+        // Every block has to come back as it went in
+        for (size_t i = 0; i < measuredChunks.size(); i++)
+            for (GLint z = 0; z < (GLint)World::chunkDepthZ; z++)
+            for (GLint y = 0; y < (GLint)World::chunkHeightY; y++)
+            for (GLint x = 0; x < (GLint)World::chunkWidthX; x++)
+                if (loaded[i].blocks.GetBlockType(x, y, z) != measuredChunks[i]->chunkBlocks.GetBlockType(x, y, z))
+                {
+                    mismatches++;
+                    z = World::chunkDepthZ;
+                    y = World::chunkHeightY;
+                    break;
+                }
+        result["chunksLoadedWrong"] = mismatches;
+    }
+    filesystem::remove_all(saveDirectory);
+
+    // The rest of each measured chunk's column, up to the top of the world. Nearly all
+    // of it is air above the terrain, which should cost next to nothing to generate or keep
+    if (World::chunksTall > 1)
+    {
+        vector<Chunk *> upperChunks;
+        for (Chunk *chunk : measuredChunks)
+            for (GLint y = 1; y < (GLint)World::chunksTall; y++)
+                upperChunks.push_back(new Chunk(chunk->chunk_position_x, y, chunk->chunk_position_z, chunk->biomeID));
+
+        StageMeasurement generateUpper;
+        for (Chunk *chunk : upperChunks)
+            chunk->GenerateBlocks(seed, chunk->biomeID, chunk->biomeID, chunk->biomeID, chunk->biomeID);
+        result["stages"]["generateUpperColumn"] = generateUpper.Finish(upperChunks.size());
+
+        size_t upperBytes = 0, uniformChunks = 0;
+        for (Chunk *chunk : upperChunks)
+        {
+            GLint blockTypeID;
+            upperBytes += chunk->chunkBlocks.MemoryUsage();
+            uniformChunks += chunk->chunkBlocks.IsUniform(blockTypeID);
+        }
+        result["upperColumnBlockStorageBytesPerChunk"] = (GLdouble)upperBytes / upperChunks.size();
+        result["upperColumnUniformChunks"] = (GLdouble)uniformChunks / upperChunks.size();
+
+        for (Chunk *chunk : upperChunks)
+        {
+            chunk->generated = true;
+            chunks_.Add(chunk);
+        }
+        result["stages"]["light"] = LightStage(measuredChunks);
+        for (Chunk *chunk : upperChunks)
+        {
+            chunks_.Remove(chunk);
+            delete chunk;
+        }
+    }
+
+    for (Chunk *chunk : allChunks)
+    {
+        chunks_.Remove(chunk);
+        delete chunk;
+    }
+    return result;
+}
+
+
+
+int main(int argc, char *argv[])
+{
+    const GLint chunkCount = (argc > 1 ? stoi(argv[1]) : 64);
+    vector<GLuint> seeds = { World::defaultSeed, 1, 1337 };
+    if (argc > 2)
+    {
+        seeds.clear();
+        for (GLint i = 2; i < argc; i++)
+            seeds.push_back((GLuint)stoul(argv[i]));
+    }
+
+    ifstream ifs("../resources/blocks.json");
+    if (!ifs.is_open())
+    {
+        cerr << "Run this from the misc folder so ../resources/blocks.json can be found" << endl;
+        return 1;
+    }
+    blockRegistry.LoadDefinitions(json::parse(ifs));
+
+    json results;
+    results["chunkCount"] = chunkCount;
+    results["greedyMeshing"] = (bool)World::greedyMeshingEnabled;
+    results["seeds"] = json::array();
+    for (GLuint seed : seeds)
+        results["seeds"].push_back(BenchmarkSeed(seed, chunkCount));
+
+    cout << results.dump(4) << endl;
+    return 0;
+}
@@ -0,0 +1,4 @@
+#!/bin/sh
+
+# Links FastNoise for terrain generation, no window or GL libraries needed
+clang++ -std=c++17 -O2 -Wall -I.. -I../dependencies/include -L../dependencies/library -o ChunkBenchmark ChunkBenchmark.cpp ../Chunk.cpp ../ChunkIndex.cpp ../ChunkMesher.cpp ../FeaturePlacer.cpp ../ChunkSerializer.cpp ../RegionStorage.cpp ../TerrainGenerator.cpp ../BlockRegistry.cpp ../BlockStorage.cpp ../LightEngine.cpp -lFastNoise
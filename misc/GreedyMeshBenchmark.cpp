@@ -0,0 +1,172 @@
+//
+// Meshes terrain chunks with the per-face mesher and the greedy mesher and
+// prints the vertex counts and build times of both. Runs without a window or GL context.
+//
+
+#include "BlockRegistry.hpp"
+#include "BlockStorage.hpp"
+#include "ChunkMesher.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <string>
+#include <tuple>
+
+using namespace std;
+
+
+
+// Rolling hills of grass, dirt and stone with some water, like a generated chunk
+void FillTerrain(BlockStorage &storage, const BlockRegistry &registry, GLint variant)
+{
+    GLint grass = registry.GetID("Grass_Top");
+    GLint dirt = registry.GetID("Dirt_Top");
+    GLint stone = registry.GetID("Stone_Block");
+    GLint water = registry.GetID("Water");
+    for (GLint z = 0; z < (GLint)World::chunkDepthZ; z++)
+    for (GLint x = 0; x < (GLint)World::chunkWidthX; x++)
+    {
+        GLint height = 12 + (GLint)(6.0 * sin((x + variant * 7) * 0.2) + 5.0 * cos((z + variant * 3) * 0.15));
+        for (GLint y = 0; y < (GLint)World::chunkHeightY; y++)
+        {
+            if (y < height - 4)
+                storage.SetBlockType(x, y, z, stone);
+            else if (y < height - 1)
+                storage.SetBlockType(x, y, z, dirt);
+            else if (y < height)
+                storage.SetBlockType(x, y, z, grass);
+            else if (y == 0)
+                storage.SetBlockType(x, y, z, water);
+        }
+    }
+}
+
+
+
+GLint BlockTypeOrAir(const BlockStorage &storage, GLint x, GLint y, GLint z)
+{
+    if (x < 0 || y < 0 || z < 0 || x >= (GLint)World::chunkWidthX || y >= (GLint)World::chunkHeightY || z >= (GLint)World::chunkDepthZ)
+        return BlockRegistry::Air;
+    return storage.GetBlockType(x, y, z);
+}
+
+
+
+// Same visibility rules as Chunk::RenderMesh (everything outside the chunk is air), calling
+// visit(x, y, z, faceIndex, key) for every face that should be drawn
+template <typename Visit>
+void ForEachVisibleFace(const BlockStorage &storage, const BlockRegistry &registry, Visit visit)
+{
+    static const GLint offsets[6][3] = { {0, 0, -1}, {0, 0, 1}, {-1, 0, 0}, {1, 0, 0}, {0, 1, 0}, {0, -1, 0} };
+    for (GLint z = 0; z < (GLint)World::chunkDepthZ; z++)
+    for (GLint x = 0; x < (GLint)World::chunkWidthX; x++)
+    for (GLint y = 0; y < (GLint)World::chunkHeightY; y++)
+    {
+        GLint id = storage.GetBlockType(x, y, z);
+        if (id == BlockRegistry::Air)
+            continue;
+        GLboolean transparent = registry.IsTransparent(id);
+        GLboolean drawSides = !transparent || registry.IsFoliage(id);
+        for (GLuint face = 0; face < 6; face++)
+        {
+            if (face < BlockFaces::Top_Face && !drawSides)
+                continue;
+            if (registry.IsTransparent(BlockTypeOrAir(storage, x + offsets[face][0], y + offsets[face][1], z + offsets[face][2])))
+                visit(x, y, z, face, ChunkMesher::FaceKey(registry.FaceTexture(id, face), 0, 0, transparent));
+        }
+    }
+}
+
+
+
+// Expand quads back into the unit faces they cover, so both meshers can be compared
+set<tuple<GLuint, GLuint, GLuint, GLuint>> CoveredFaces(const vector<GLuint> &opaqueVertices, const vector<GLuint> &transparentVertices)
+{
+    vector<GLuint> vertices(opaqueVertices);
+    vertices.insert(vertices.end(), transparentVertices.begin(), transparentVertices.end());
+    static const GLuint uAxis[6] = { 0, 1, 1, 2, 0, 0 };
+    static const GLuint vAxis[6] = { 1, 0, 2, 1, 2, 2 };
+    set<tuple<GLuint, GLuint, GLuint, GLuint>> faces;
+    for (size_t i = 0; i < vertices.size(); i += ChunkMesher::vertexStride * ChunkMesher::verticesPerQuad)
+    {
+        GLuint position[3] = { vertices[i] & 63, (vertices[i] >> 6) & 63, (vertices[i] >> 12) & 63 };
+        GLuint face = (vertices[i] >> 18) & 7;
+        GLuint width = (vertices[i + 1] & 31) + 1;
+        GLuint height = ((vertices[i + 1] >> 5) & 31) + 1;
+        for (GLuint v = 0; v < height; v++)
+        for (GLuint u = 0; u < width; u++)
+        {
+            GLuint block[3] = { position[0], position[1], position[2] };
+            block[uAxis[face]] += u;
+            block[vAxis[face]] += v;
+            faces.insert(make_tuple(block[0], block[1], block[2], face));
+        }
+    }
+    return faces;
+}
+
+
+
+int main(int argc, char *argv[])
+{
+    const GLint chunkCount = (argc > 1 ? stoi(argv[1]) : 64);
+
+    ifstream ifs("../resources/blocks.json");
+    if (!ifs.is_open())
+    {
+        cout << "Run this from the misc folder so ../resources/blocks.json can be found" << endl;
+        return 1;
+    }
+    BlockRegistry registry;
+    registry.LoadDefinitions(json::parse(ifs));
+
+    vector<BlockStorage> chunks(chunkCount);
+    for (GLint i = 0; i < chunkCount; i++)
+        FillTerrain(chunks[i], registry, i);
+
+    vector<GLuint> faceMasks(6 * World::chunkVolume, 0);
+    vector<GLuint> opaque, transparent;
+    size_t perFaceVertices = 0, greedyVertices = 0;
+    GLdouble perFaceMs = 0.0, greedyMs = 0.0;
+    GLboolean coverageMatches = true;
+
+    for (GLint i = 0; i < chunkCount; i++)
+    {
+        // Per-face: one quad for every visible face
+        opaque.clear();
+        transparent.clear();
+        auto start = chrono::steady_clock::now();
+        ForEachVisibleFace(chunks[i], registry, [&](GLuint x, GLuint y, GLuint z, GLuint face, GLuint key) {
+            ChunkMesher::EmitQuad((key >> 13) & 1 ? transparent : opaque, x, y, z, face, key & 31, 0, 0, 1, 1);
+        });
+        perFaceMs += chrono::duration<GLdouble, milli>(chrono::steady_clock::now() - start).count();
+        perFaceVertices += (opaque.size() + transparent.size()) / ChunkMesher::vertexStride;
+        auto perFaceFaces = CoveredFaces(opaque, transparent);
+
+        // Greedy: record every visible face, then merge
+        opaque.clear();
+        transparent.clear();
+        start = chrono::steady_clock::now();
+        ForEachVisibleFace(chunks[i], registry, [&](GLuint x, GLuint y, GLuint z, GLuint face, GLuint key) {
+            faceMasks[face * World::chunkVolume + x + z * World::chunkWidthX + y * World::chunkWidthX * World::chunkDepthZ] = key;
+        });
+        for (GLuint face = 0; face < 6; face++)
+            ChunkMesher::GreedyMesh(faceMasks.data() + face * World::chunkVolume, face, 0, World::chunkHeightY, opaque, transparent);
+        greedyMs += chrono::duration<GLdouble, milli>(chrono::steady_clock::now() - start).count();
+        greedyVertices += (opaque.size() + transparent.size()) / ChunkMesher::vertexStride;
+
+        if (CoveredFaces(opaque, transparent) != perFaceFaces)
+            coverageMatches = false;
+    }
+
+    cout << "Chunks meshed:       " << chunkCount << endl;
+    cout << "Per-face mesher:     " << perFaceVertices / chunkCount << " vertices, " << perFaceMs / chunkCount << " ms per chunk" << endl;
+    cout << "Greedy mesher:       " << greedyVertices / chunkCount << " vertices, " << greedyMs / chunkCount << " ms per chunk" << endl;
+    cout << "Vertex delta:        " << (GLdouble)greedyVertices / perFaceVertices * 100.0 << "% of per-face" << endl;
+    cout << "Build time delta:    " << (greedyMs - perFaceMs) / chunkCount << " ms per chunk" << endl;
+    cout << "Same faces covered:  " << (coverageMatches ? "yes" : "NO") << endl;
+    return coverageMatches ? 0 : 1;
+}
@@ -0,0 +1,3 @@
+#!/bin/sh
+
+clang++ -std=c++17 -O2 -Wall -I.. -I../dependencies/include -o GreedyMeshBenchmark GreedyMeshBenchmark.cpp ../ChunkMesher.cpp ../BlockRegistry.cpp ../BlockStorage.cpp
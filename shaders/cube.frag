@@ -17,17 +17,23 @@ in float BlockFaceID;
 in float AmbientOcclusionIntensity;
 // Fog
 in float FogIntensity;
+// Voxel light, skylight or block light whichever is brighter
+in float LightLevel;
 
 vec3 skyColour = vec3(0.54f, 0.81f, 0.94f);
 
 // Get the texture unit from when we bound our texture
 uniform sampler2DArray ourTexture;	
-// Gets the color of the light
-uniform vec4 lightColor;
-// Gets the light's position
-uniform vec3 lightPosition;
-// Gets the position of the camera
-uniform vec3 cameraPosition;
+// Per-frame camera and light data, shared by every shader through one
+// uniform buffer (see BufferManager::FrameData, the layouts must match)
+layout (std140) uniform FrameData
+{
+	mat4 projectionMatrix;
+	mat4 viewMatrix;
+	vec4 cameraPosition;
+	vec4 lightPosition;
+	vec4 lightColor;
+};
 
 void main()
 {
@@ -38,7 +44,7 @@ void main()
 	vec3 normal = normalize(Normal);
 	// Get the light direction vector by subtracting
 	// current position by the light position and normalizing it
-	vec3 lightDirection = normalize(lightPosition - VertexPosition);
+	vec3 lightDirection = normalize(lightPosition.xyz - VertexPosition);
 
 	// Diffuse lighting
 	// Get the dot product of the light direction and the normal
@@ -50,7 +56,7 @@ void main()
 
 	// Specular lighting
 	float specularLight = 0.5f; // Maximum intensity of the specular light
-	vec3 viewDirection = normalize(cameraPosition - VertexPosition);
+	vec3 viewDirection = normalize(cameraPosition.xyz - VertexPosition);
 	vec3 reflectionDirection = max(reflect(-lightDirection, normal), 0.0f);
 	// Amount of specular amount looking at 
 	// a certain direction with our camera
@@ -84,6 +90,7 @@ void main()
 	// Our final color with phong lightings
 	// For some reason faceLight causes visual distortion on windows so getting rid of that
 	vec4 FinalColor = Texture * lightColor * (min(diffuse + ambient + specular, 0.6f) + AmbientOcclusionIntensity + (0.05*BlockFaceID));// + faceLight + AmbientOcclusionIntensity);
+	FinalColor.rgb *= LightLevel;
 	FinalColor = mix(vec4(skyColour, 1.0), FinalColor, FogIntensity);
 
 	// Add transparency if needed
@@ -1,7 +1,7 @@
 #version 330 core
 
-// Positions/Coordinates
-layout (location = 0) in uint packedVertexData;
+// Positions/Coordinates, two packed words per vertex (see ChunkMesher.hpp)
+layout (location = 0) in uvec2 packedVertexData;
 
 // Output textures to the Fragment Shader
 out vec2 TexCoord;
@@ -16,6 +16,8 @@ out float TexID;
 out float BlockFaceID;
 // Ambient occlusion intensity
 out float AmbientOcclusionIntensity;
+// How bright the voxel light engine lights this face, 0 to 1
+out float LightLevel;
 // Fog intensity
 out float FogIntensity;
 
@@ -23,13 +25,34 @@ out float FogIntensity;
 const float fogDensity = 0.001;
 const float fogGradient = 4.0;
 
-// Imports the camera matrix from the main function
-uniform mat4 projectionMatrix;
-uniform mat4 viewMatrix;
+// Per-frame camera and light data, shared by every shader through one
+// uniform buffer (see BufferManager::FrameData, the layouts must match)
+layout (std140) uniform FrameData
+{
+	mat4 projectionMatrix;
+	mat4 viewMatrix;
+	vec4 cameraPosition;
+	vec4 lightPosition;
+	vec4 lightColor;
+};
 
 // Uniform for chunk offset
 uniform vec3 chunkOffset;
 
+// When every chunk mesh shares one vertex buffer (the chunk arena), the offset
+// comes from the arena's page table instead. Meshes own whole pages of
+// chunkArenaPageVertices vertices, so our vertex ID tells us our page
+uniform bool chunkArenaEnabled;
+uniform int chunkArenaPageVertices;
+uniform samplerBuffer chunkArenaPageOffsets;
+
+// With vertex pulling there are no vertex attributes. Every quad is one record
+// of the same two words in this buffer texture (see ChunkMesher.hpp), drawn as
+// 6 vertices that find their record and corner from gl_VertexID
+uniform bool vertexPulling;
+uniform usamplerBuffer quadRecords;
+uint pulledCorners[6] = uint[6]( 0u, 1u, 2u, 1u, 0u, 3u );
+
 // The size of our blocks
 uniform float blockSize;
 
@@ -125,58 +148,74 @@ vec3 bottomFacePositions[4] = vec3[4](
 	vec3(0.0f, 0.0f, 0.0f)
 );
 
-// This is the order that vertices must be rendered
-// because of the winding order required for backface culling
-int indices[6] = int[6]( 0, 1, 2, 1, 0, 3 );
-
 void main()
 {
+	// Build the vertex a pulled record stands for, the same as the ones the
+	// other formats store. arenaIndex is where it lives in the chunk arena
+	uvec2 packedData = packedVertexData;
+	int arenaIndex = gl_VertexID;
+	if(vertexPulling)
+	{
+		arenaIndex = gl_VertexID / 6;
+		uvec2 record = texelFetch(quadRecords, arenaIndex).xy;
+		uint corner = pulledCorners[gl_VertexID % 6];
+		uint cornerAO = (record.y >> (10u + corner * 2u)) & 3u;
+		packedData = uvec2(record.x | corner << 21 | cornerAO << 29, record.y & ~(255u << 10));
+	}
+
 	// Unpack vertex data
-	uint x         = (packedVertexData) 	  & 63u; // 6 bits, x position in chunk
-	uint y         = (packedVertexData >> 6)  & 63u; // 6 bits, y position in chunk
-	uint z         = (packedVertexData >> 12) & 63u; // 6 bits, z position in chunk
-	uint aFaceID   = (packedVertexData >> 18) & 7u;	 // 3 bits, what face in the cube this is
-	uint aVertexID = (packedVertexData >> 21) & 7u;	 // 3 bits, which of 6 face vertices is this
-	uint aTexID    = (packedVertexData >> 24) & 31u; // 5 bits, which texture to use
-	uint aoEnabled = (packedVertexData >> 29) & 1u;  // 1 bit, whether ambient occlusion is toggled
+	uint x         = (packedData.x) 	    & 63u; // 6 bits, x position in chunk
+	uint y         = (packedData.x >> 6)  & 63u; // 6 bits, y position in chunk
+	uint z         = (packedData.x >> 12) & 63u; // 6 bits, z position in chunk
+	uint aFaceID   = (packedData.x >> 18) & 7u;  // 3 bits, what face in the cube this is
+	uint aCorner   = (packedData.x >> 21) & 7u;  // 3 bits, which of the face's 4 corners this is. The mesher (or the
+	                                                   // shared quad index buffer) orders them 0 1 2 1 0 3 for backface culling
+	uint aTexID    = (packedData.x >> 24) & 31u; // 5 bits, which texture to use
+	uint aoLevel   = (packedData.x >> 29) & 3u;  // 2 bits, how shaded this corner is, 0 (open) to 3 (fully occluded)
+	float quadWidth  = float((packedData.y)      & 31u) + 1.0f; // 5 bits, blocks a merged quad covers along u
+	float quadHeight = float((packedData.y >> 5) & 31u) + 1.0f; // 5 bits, blocks a merged quad covers along v
+	uint blockLight  = (packedData.y >> 18) & 15u; // 4 bits, block light level of the block the face looks into
+	uint skyLight    = (packedData.y >> 22) & 15u; // 4 bits, skylight level of the block the face looks into
 
 	// Adjust the offset for this chunk by the block size
 	vec3 aPos = vec3(x, y, z);				
 
 	// This is the final position for the vertex in world coordinates
-	VertexPosition = aPos * blockSize + chunkOffset;
+	vec3 offset = (chunkArenaEnabled ? texelFetch(chunkArenaPageOffsets, arenaIndex / chunkArenaPageVertices).xyz : chunkOffset);
+	VertexPosition = aPos * blockSize + offset;
 
-	// Set our normal vectors and adjust vertex position
+	// Set our normal vectors and adjust vertex position. Merged quads stretch
+	// the unit face along its u and v axes and repeat the texture once per block
 	switch(aFaceID) {
 		case 0u: // 0 is Index for Back face
-			Normal = backFaceNormals[indices[aVertexID]] * blockSize;
-			VertexPosition += backFacePositions[indices[aVertexID]] * blockSize;
-			TexCoord = texCoords[indices[aVertexID]] * blockSize;
+			Normal = backFaceNormals[aCorner] * blockSize;
+			VertexPosition += backFacePositions[aCorner] * vec3(quadWidth, quadHeight, 1.0f) * blockSize;
+			TexCoord = texCoords[aCorner] * vec2(quadWidth, quadHeight) * blockSize;
 			break;
 		case 1u: // 1 is Index for Front face
-			Normal = frontFaceNormals[indices[aVertexID]] * blockSize;
-			VertexPosition += frontFacePositions[indices[aVertexID]] * blockSize;
-			TexCoord = texCoords[indices[aVertexID]] * blockSize;
+			Normal = frontFaceNormals[aCorner] * blockSize;
+			VertexPosition += frontFacePositions[aCorner] * vec3(quadHeight, quadWidth, 1.0f) * blockSize;
+			TexCoord = texCoords[aCorner] * vec2(quadWidth, quadHeight) * blockSize;
 			break;
 		case 2u: // 2 is Index for Left face
-			Normal = leftFaceNormals[indices[aVertexID]] * blockSize;
-			VertexPosition += leftFacePositions[indices[aVertexID]] * blockSize;
-			TexCoord = texCoords[indices[aVertexID]] * blockSize;
+			Normal = leftFaceNormals[aCorner] * blockSize;
+			VertexPosition += leftFacePositions[aCorner] * vec3(1.0f, quadWidth, quadHeight) * blockSize;
+			TexCoord = texCoords[aCorner] * vec2(quadWidth, quadHeight) * blockSize;
 			break;
 		case 3u: // 3 is Index for Right face
-			Normal = rightFaceNormals[indices[aVertexID]] * blockSize;
-			VertexPosition += rightFacePositions[indices[aVertexID]] * blockSize;
-			TexCoord = texCoords[indices[aVertexID]] * blockSize;
+			Normal = rightFaceNormals[aCorner] * blockSize;
+			VertexPosition += rightFacePositions[aCorner] * vec3(1.0f, quadHeight, quadWidth) * blockSize;
+			TexCoord = texCoords[aCorner] * vec2(quadWidth, quadHeight) * blockSize;
 			break;
 		case 4u: // 4 is Index for Top face
-			Normal = topFaceNormals[indices[aVertexID]] * blockSize;
-			VertexPosition += topFacePositions[indices[aVertexID]] * blockSize;
-			TexCoord = texCoords[indices[aVertexID]] * blockSize;
+			Normal = topFaceNormals[aCorner] * blockSize;
+			VertexPosition += topFacePositions[aCorner] * vec3(quadWidth, 1.0f, quadHeight) * blockSize;
+			TexCoord = texCoords[aCorner] * vec2(quadWidth, quadHeight) * blockSize;
 			break;
 		case 5u: // 5 is Index for Bottom face
-			Normal = bottomFaceNormals[indices[aVertexID]] * blockSize;
-			VertexPosition += bottomFacePositions[indices[aVertexID]] * blockSize;
-			TexCoord = texCoords[indices[aVertexID]] * blockSize;
+			Normal = bottomFaceNormals[aCorner] * blockSize;
+			VertexPosition += bottomFacePositions[aCorner] * vec3(quadWidth, 1.0f, quadHeight) * blockSize;
+			TexCoord = texCoords[aCorner] * vec2(quadWidth, quadHeight) * blockSize;
 			break;
 	}
 
@@ -188,10 +227,10 @@ void main()
 	TexID = aTexID; 
 	// Block face
 	BlockFaceID = aFaceID;
-	if(aoEnabled == 1u) // This is the working code for top face, uncomment later
-		AmbientOcclusionIntensity = -0.6f;
-	else
-		AmbientOcclusionIntensity = 0.0f;
+	// Each level of occlusion darkens the corner a bit more
+	AmbientOcclusionIntensity = -0.2f * float(aoLevel);
+	// Each light level below full is a fifth darker than the one above it
+	LightLevel = pow(0.8f, float(15u - max(skyLight, blockLight)));
 
 	// Calculate Fog
 	vec4 positionRelativeToCamera = viewMatrix * vec4(VertexPosition, 1.0f);
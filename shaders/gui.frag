@@ -2,7 +2,9 @@
 
 out vec4 FragColor;
 
+uniform vec4 guiColor;
+
 void main()
 {
-    FragColor = vec4(1.0f, 1.0f, 1.0f, 1.0f);
+    FragColor = guiColor;
 }
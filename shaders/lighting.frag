@@ -2,7 +2,16 @@
 
 out vec4 FragColor;
 
-uniform vec4 lightColor;
+// Per-frame camera and light data, shared by every shader through one
+// uniform buffer (see BufferManager::FrameData, the layouts must match)
+layout (std140) uniform FrameData
+{
+	mat4 projectionMatrix;
+	mat4 viewMatrix;
+	vec4 cameraPosition;
+	vec4 lightPosition;
+	vec4 lightColor;
+};
 
 void main()
 {
@@ -3,8 +3,17 @@
 layout (location = 0) in vec3 aPos;
 
 uniform mat4 model;
-uniform mat4 projectionMatrix;
-uniform mat4 viewMatrix;
+
+// Per-frame camera and light data, shared by every shader through one
+// uniform buffer (see BufferManager::FrameData, the layouts must match)
+layout (std140) uniform FrameData
+{
+	mat4 projectionMatrix;
+	mat4 viewMatrix;
+	vec4 cameraPosition;
+	vec4 lightPosition;
+	vec4 lightColor;
+};
 
 void main()
 {